@@ -37,6 +37,7 @@
 #include "udp_fw_update.h"
 #include "pkt_ctrl.h"
 #include "udp_uart.h"
+#include "timed_ctrl.h"
 
 //standard headers
 #include <stddef.h>
@@ -266,6 +267,23 @@ static void handle_udp_ctrl_packet(
         ctrl_data_out.id = USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE;
         break;
 
+    /*******************************************************************
+     * Timed register writes
+     ******************************************************************/
+    case USRP2_CTRL_ID_DO_THIS_AT_TIME_BRO:
+        ctrl_data_out.data.timed_args = ctrl_data_in->data.timed_args;
+        ctrl_data_out.data.timed_args.queued = timed_ctrl_push(
+            ctrl_data_in->data.timed_args.secs,
+            ctrl_data_in->data.timed_args.ticks,
+            ctrl_data_in->data.timed_args.action,
+            ctrl_data_in->data.timed_args.addr,
+            ctrl_data_in->data.timed_args.data,
+            ctrl_data_in->data.timed_args.num_bits,
+            ctrl_data_in->data.timed_args.mosi_edge
+        );
+        ctrl_data_out.id = USRP2_CTRL_ID_WILL_DO_AT_TIME_DUDE;
+        break;
+
     /*******************************************************************
      * Echo test
      ******************************************************************/
@@ -391,6 +409,8 @@ main(void)
 
     udp_uart_poll(); //uart message handling
 
+    timed_ctrl_poll(); //run the timed register writes that are due
+
     pic_interrupt_handler();
     /*
     int pending = pic_regs->pending;		// poll for under or overrun
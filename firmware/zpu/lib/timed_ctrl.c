@@ -0,0 +1,94 @@
+/*
+ * Copyright 2013 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timed_ctrl.h"
+#include "memory_map.h"
+#include "spi.h"
+#include "usrp2/fw_common.h"
+#include <stddef.h>
+
+/***********************************************************************
+ * The queue: a ring of writes in time order
+ **********************************************************************/
+typedef struct{
+    uint32_t secs;
+    uint32_t ticks;
+    uint32_t addr;
+    uint32_t data;
+    uint8_t action;
+    uint8_t num_bits;
+    uint8_t mosi_edge;
+} timed_ctrl_t;
+
+static timed_ctrl_t _queue[USRP2_TIMED_CMD_QUEUE_DEPTH];
+static size_t _head = 0, _size = 0;
+
+bool timed_ctrl_push(
+    uint32_t secs, uint32_t ticks, uint8_t action,
+    uint32_t addr, uint32_t data, uint8_t num_bits, uint8_t mosi_edge
+){
+    if (_size == USRP2_TIMED_CMD_QUEUE_DEPTH) return false;
+    timed_ctrl_t *cmd = &_queue[(_head + _size) % USRP2_TIMED_CMD_QUEUE_DEPTH];
+    cmd->secs = secs;
+    cmd->ticks = ticks;
+    cmd->addr = addr;
+    cmd->data = data;
+    cmd->action = action;
+    cmd->num_bits = num_bits;
+    cmd->mosi_edge = mosi_edge;
+    _size++;
+    return true;
+}
+
+static void timed_ctrl_run(const timed_ctrl_t *cmd){
+    switch(cmd->action){
+    case USRP2_REG_ACTION_FPGA_POKE32:
+        *((uint32_t *) cmd->addr) = cmd->data;
+        break;
+
+    case USRP2_REG_ACTION_FPGA_POKE16:
+        *((uint16_t *) cmd->addr) = (uint16_t)cmd->data;
+        break;
+
+#ifndef NO_SPI_I2C
+    case USRP2_REG_ACTION_SPI_WRITE:
+        spi_transact(SPI_TXONLY, cmd->addr, cmd->data, cmd->num_bits,
+            (cmd->mosi_edge == USRP2_CLK_EDGE_RISE)? SPIF_PUSH_FALL : SPIF_PUSH_RISE
+        );
+        break;
+#endif
+    }
+}
+
+void timed_ctrl_poll(void){
+    if (_size == 0) return;
+
+    //read the time, again if the seconds rolled over in between
+    uint32_t secs, ticks;
+    do{
+        secs = router_status->time64_secs_rb;
+        ticks = router_status->time64_ticks_rb;
+    } while (secs != router_status->time64_secs_rb);
+
+    while (_size != 0){
+        const timed_ctrl_t *cmd = &_queue[_head];
+        if (cmd->secs > secs || (cmd->secs == secs && cmd->ticks > ticks)) return; //not yet
+        timed_ctrl_run(cmd);
+        _head = (_head + 1) % USRP2_TIMED_CMD_QUEUE_DEPTH;
+        _size--;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2013 Fairwaves LLC
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_TIMED_CTRL_H
+#define INCLUDED_TIMED_CTRL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ * Queue a register write to run at a given time.
+ * The writes run in order, the front write holds back the rest,
+ * and a late write runs as soon as it reaches the front.
+ * \param secs the full seconds of the time64 core
+ * \param ticks the fractional seconds in ticks
+ * \param action USRP2_REG_ACTION_FPGA_POKE32/16 or USRP2_REG_ACTION_SPI_WRITE
+ * \param addr the register address or the spi slave
+ * \param data the register value or the spi data
+ * \param num_bits the spi length in bits
+ * \param mosi_edge the spi push edge, USRP2_CLK_EDGE_RISE/FALL
+ * \return false when the queue is full
+ */
+bool timed_ctrl_push(
+    uint32_t secs, uint32_t ticks, uint8_t action,
+    uint32_t addr, uint32_t data, uint8_t num_bits, uint8_t mosi_edge
+);
+
+/*!
+ * Polls the time64 core,
+ * and runs the writes that are due.
+ */
+void timed_ctrl_poll(void);
+
+#endif /* INCLUDED_TIMED_CTRL_H */
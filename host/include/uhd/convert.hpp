@@ -24,6 +24,7 @@
 #include <boost/function.hpp>
 #include <boost/operators.hpp>
 #include <string>
+#include <vector>
 
 namespace uhd{ namespace convert{
 
@@ -65,6 +66,9 @@ namespace uhd{ namespace convert{
     //! Implement equality_comparable interface
     UHD_API bool operator==(const id_type &, const id_type &);
 
+    //! Implement the boost::hash interface, for the registry lookup
+    UHD_API std::size_t hash_value(const id_type &);
+
     /*!
      * Register a converter function.
      * \param id identify the conversion
@@ -80,9 +84,17 @@ namespace uhd{ namespace convert{
     /*!
      * Get a converter factory function.
      * \param id identify the conversion
+     * \param prio the desired prio or -1 for the highest registered
      * \return the converter factory function
+     * \throw uhd::key_error when no such conversion is registered
      */
-    UHD_API function_type get_converter(const id_type &id);
+    UHD_API function_type get_converter(const id_type &id, const priority_type prio = -1);
+
+    //! Get a list of all registered conversions
+    UHD_API std::vector<id_type> get_converter_ids(void);
+
+    //! Get the priorities of all implementations registered for a conversion
+    UHD_API std::vector<priority_type> get_converter_prios(const id_type &id);
 
     /*!
      * Register the size of a particular item.
@@ -32,6 +32,7 @@ namespace uhd{
  */
 template <typename T> class property : boost::noncopyable{
 public:
+    typedef boost::shared_ptr<property<T> > sptr;
     typedef boost::function<void(const T &)> subscriber_type;
     typedef boost::function<T(void)> publisher_type;
     typedef boost::function<T(const T &)> coercer_type;
@@ -142,6 +143,13 @@ public:
     //! Get access to a property in the tree
     template <typename T> property<T> &access(const fs_path &path);
 
+    /*!
+     * Get a shared handle to a property in the tree.
+     * Hot callers can hold the handle to skip the path lookup.
+     * The handle keeps the property alive after a removal from the tree.
+     */
+    template <typename T> typename property<T>::sptr access_handle(const fs_path &path);
+
 private:
     //! Internal create property with wild-card type
     virtual void _create(const fs_path &path, const boost::shared_ptr<void> &prop) = 0;
@@ -90,6 +90,10 @@ namespace uhd{
         return *boost::static_pointer_cast<property<T> >(this->_access(path));
     }
 
+    template <typename T> typename property<T>::sptr property_tree::access_handle(const fs_path &path){
+        return boost::static_pointer_cast<property<T> >(this->_access(path));
+    }
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_PROPERTY_TREE_IPP */
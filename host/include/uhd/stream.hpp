@@ -22,6 +22,7 @@
 #include <uhd/types/metadata.hpp>
 #include <uhd/types/device_addr.hpp>
 #include <uhd/types/ref_vector.hpp>
+#include <uhd/transport/zero_copy.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 #include <vector>
@@ -88,6 +89,11 @@ struct UHD_API stream_args_t{
      * In the "next_burst" mode, the DSP drops incoming packets until a new burst is started.
      * In the "next_packet" mode, the DSP starts transmitting again at the next packet.
      *
+     * - convert_threads: the number of worker threads for RX copy-conversion.
+     * When set on a multi-channel RX streamer, the channels are converted in parallel
+     * on this many persistent threads plus the thread calling recv().
+     * The default of 0 converts all channels on the calling thread.
+     *
      * The following are not implemented, but are listed for conceptual purposes:
      * - function: magnitude or phase/magnitude
      * - units: numeric units like counts or dBm
@@ -158,6 +164,57 @@ public:
         const double timeout = 0.1,
         const bool one_packet = false
     ) = 0;
+
+    /*!
+     * A view into the payloads of one received packet per channel.
+     * The view holds a lease on the transport buffers;
+     * the buffers return to the transport on release() or destruction.
+     * A view may be released on any thread, ex: by a processing thread.
+     * Hold on to a view only as long as needed:
+     * each outstanding view keeps a frame of every transport.
+     */
+    struct UHD_API recv_view_type{
+        recv_view_type(void);
+
+        //! Per-channel pointers to the samples in the over-the-wire format
+        std::vector<const void *> buffs;
+
+        //! The number of samples in each channel's buffer
+        size_t nsamps_per_buff;
+
+        //! The transport buffers that back the channel pointers
+        std::vector<transport::managed_recv_buffer::sptr> leases;
+
+        //! Give the transport buffers back and clear the view
+        void release(void);
+    };
+
+    /*!
+     * Receive a single packet per channel without a copy-conversion.
+     *
+     * The view points straight into the transport buffers,
+     * so the samples are in the over-the-wire format of the stream,
+     * ex: sc16 samples as big-endian 32-bit items for otw_format sc16.
+     * Any previous contents of the view are released first.
+     * When a call to recv() left a fragment behind,
+     * the view holds the remainder of that packet.
+     * On error, the metadata carries the error code
+     * and the view is empty, just like a recv() of 0 samples.
+     *
+     * Streamers that cannot lend their buffers,
+     * ex: more than one channel per transport,
+     * throw uhd::not_implemented_error.
+     *
+     * \param view the view to fill with the received packets
+     * \param metadata data to fill describing the view
+     * \param timeout the timeout in seconds to wait for a packet
+     * \return the number of samples in each buffer of the view
+     */
+    virtual size_t recv_view(
+        recv_view_type &view,
+        rx_metadata_t &metadata,
+        const double timeout = 0.1
+    );
 };
 
 /*!
@@ -205,6 +262,70 @@ public:
         const tx_metadata_t &metadata,
         const double timeout = 0.1
     ) = 0;
+
+    /*!
+     * A view into the payloads of one send frame per channel.
+     * The view holds a lease on the transport buffers until it is committed.
+     * A view released without a commit gives its frames back unsent.
+     */
+    struct UHD_API send_view_type{
+        send_view_type(void);
+
+        //! Per-channel pointers to fill with samples in the over-the-wire format
+        std::vector<void *> buffs;
+
+        //! The maximum number of samples in each channel's buffer
+        size_t nsamps_per_buff;
+
+        //! True when the header space was reserved for a time spec
+        bool has_time_spec;
+
+        //! The transport buffers that back the channel pointers
+        std::vector<transport::managed_send_buffer::sptr> leases;
+
+        //! Drop the transport buffers and clear the view
+        void release(void);
+    };
+
+    /*!
+     * Get a view into the next send frame of every channel.
+     *
+     * The caller writes the samples straight into the transport buffers,
+     * in the over-the-wire format of the stream,
+     * ex: sc16 samples as big-endian 32-bit items for otw_format sc16.
+     * The length of the packet header depends on the time spec,
+     * so the commit must agree with the has_time_spec given here.
+     * Any previous contents of the view are released first.
+     *
+     * Streamers that cannot lend their buffers,
+     * ex: more than one channel per transport,
+     * throw uhd::not_implemented_error.
+     *
+     * \param view the view to fill with the send frames
+     * \param has_time_spec true to reserve space for a time spec
+     * \param timeout the timeout in seconds to wait on a frame
+     * \return the number of samples that fit each buffer or 0 on timeout
+     */
+    virtual size_t get_send_view(
+        send_view_type &view,
+        const bool has_time_spec,
+        const double timeout = 0.1
+    );
+
+    /*!
+     * Send the samples written into a view.
+     * The packet header is packed from the metadata at commit time.
+     * The view is released once the frames are committed.
+     * \param view a view from get_send_view()
+     * \param nsamps_per_buff the number of samples to send, per buffer
+     * \param metadata data describing the buffer's contents
+     * \return the number of samples sent
+     */
+    virtual size_t commit_send_view(
+        send_view_type &view,
+        const size_t nsamps_per_buff,
+        const tx_metadata_t &metadata
+    );
 };
 
 } //namespace uhd
@@ -19,6 +19,7 @@
 #define INCLUDED_UHD_TRANSPORT_BUFFER_POOL_HPP
 
 #include <uhd/config.hpp>
+#include <uhd/types/device_addr.hpp>
 #include <boost/utility.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -46,6 +47,25 @@ namespace uhd{ namespace transport{
             const size_t alignment = 16
         );
 
+        /*!
+         * Make a new buffer pool with allocation options from transport hints.
+         * The following hints are recognized (all optional):
+         *  - buff_alignment: the alignment boundary in bytes (default 16)
+         *  - buff_hugepages: non-zero to back the pool with huge pages
+         *  - buff_numa_node: the NUMA node to place the pool on
+         *  - buff_mlock: non-zero to lock the pool into physical memory
+         * Options that cannot be honored on this system are warned about and skipped.
+         * \param num_buffs the number of buffers to allocate
+         * \param buff_size the size of each buffer in bytes
+         * \param hints the transport hints with the above keys
+         * \return a new buffer pool buff_size X num_buffs
+         */
+        static sptr make(
+            const size_t num_buffs,
+            const size_t buff_size,
+            const device_addr_t &hints
+        );
+
         //! Get a pointer to the buffer start at the specified index
         virtual ptr_type at(const size_t index) const = 0;
 
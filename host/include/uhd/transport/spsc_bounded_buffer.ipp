@@ -0,0 +1,139 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TRANSPORT_SPSC_BOUNDED_BUFFER_IPP
+#define INCLUDED_UHD_TRANSPORT_SPSC_BOUNDED_BUFFER_IPP
+
+#include <uhd/config.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/utility.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <vector>
+
+namespace uhd{ namespace transport{ namespace{ /*anon*/
+
+    template <typename elem_type> class spsc_bounded_buffer_detail : boost::noncopyable{
+    public:
+
+        spsc_bounded_buffer_detail(size_t capacity):
+            _buffer(capacity), _push_index(0), _pop_index(0)
+        {
+            /* NOP */
+        }
+
+        UHD_INLINE bool push_with_haste(const elem_type &elem){
+            if (_size.read() == _buffer.size()) return false;
+            _buffer[_push_index] = elem;
+            _push_index = this->next(_push_index);
+            _size.inc(); //publishes the element to the consumer
+            if (_pop_waiting.read() != 0) this->notify(_empty_cond);
+            return true;
+        }
+
+        UHD_INLINE void push_with_wait(const elem_type &elem){
+            while (not this->push_with_timed_wait(elem, 1.0)){}
+        }
+
+        UHD_INLINE bool push_with_timed_wait(const elem_type &elem, double timeout){
+            if (this->push_with_haste(elem)) return true;
+            if (not this->wait(_push_waiting, _full_cond, &spsc_bounded_buffer_detail::not_full, timeout)) return false;
+            return this->push_with_haste(elem);
+        }
+
+        UHD_INLINE bool pop_with_haste(elem_type &elem){
+            if (_size.read() == 0) return false;
+            elem = _buffer[_pop_index];
+            _buffer[_pop_index] = elem_type();
+            _pop_index = this->next(_pop_index);
+            _size.dec(); //releases the slot to the producer
+            if (_push_waiting.read() != 0) this->notify(_full_cond);
+            return true;
+        }
+
+        UHD_INLINE void pop_with_wait(elem_type &elem){
+            while (not this->pop_with_timed_wait(elem, 1.0)){}
+        }
+
+        UHD_INLINE bool pop_with_timed_wait(elem_type &elem, double timeout){
+            if (this->pop_with_haste(elem)) return true;
+            if (not this->wait(_pop_waiting, _empty_cond, &spsc_bounded_buffer_detail::not_empty, timeout)) return false;
+            return this->pop_with_haste(elem);
+        }
+
+    private:
+        //poll this many times before blocking on the condition
+        static const size_t SPIN_COUNT = 1000;
+
+        std::vector<elem_type> _buffer;
+        size_t _push_index; //only touched by the producer
+        size_t _pop_index; //only touched by the consumer
+        atomic_uint32_t _size;
+
+        //slow path: used only when one side has to block
+        boost::mutex _mutex;
+        boost::condition _empty_cond, _full_cond;
+        atomic_uint32_t _pop_waiting, _push_waiting;
+
+        bool not_full(void){return _size.read() != _buffer.size();}
+        bool not_empty(void){return _size.read() != 0;}
+
+        UHD_INLINE size_t next(size_t index) const{
+            return (++index == _buffer.size())? 0 : index;
+        }
+
+        /*!
+         * Spin on the ready condition, then block on the condition variable.
+         * The waiting flag is set with a full barrier before re-checking,
+         * and the other side reads it after its own full barrier (inc/dec),
+         * so either we see the new state or the other side sees the flag.
+         */
+        UHD_INLINE bool wait(
+            atomic_uint32_t &waiting, boost::condition &cond,
+            bool (spsc_bounded_buffer_detail::*ready)(void), double timeout
+        ){
+            for (size_t i = 0; i < SPIN_COUNT; i++){
+                if ((this->*ready)()) return true;
+            }
+
+            const boost::system_time exit_time = boost::get_system_time() + to_time_dur(timeout);
+            boost::mutex::scoped_lock lock(_mutex);
+            waiting.cas(1, 0);
+            bool is_ready = (this->*ready)();
+            while (not is_ready){
+                const bool notified = cond.timed_wait(lock, exit_time);
+                is_ready = (this->*ready)();
+                if (not notified) break; //timeout
+            }
+            waiting.write(0);
+            return is_ready;
+        }
+
+        UHD_INLINE void notify(boost::condition &cond){
+            boost::mutex::scoped_lock lock(_mutex);
+            cond.notify_one();
+        }
+
+        static UHD_INLINE boost::posix_time::time_duration to_time_dur(double timeout){
+            return boost::posix_time::microseconds(long(timeout*1e6));
+        }
+
+    };
+}}} //namespace
+
+#endif /* INCLUDED_UHD_TRANSPORT_SPSC_BOUNDED_BUFFER_IPP */
@@ -58,6 +58,22 @@ public:
         const std::string &port,
         const device_addr_t &hints = device_addr_t()
     );
+
+    /*!
+     * Send all committed buffers that are still queued.
+     * Committed buffers are only queued when batched send
+     * is enabled through the send_batch_size hint;
+     * otherwise every commit sends immediately and this is a NOP.
+     */
+    virtual void flush_send_buffs(void) = 0;
+
+    /*!
+     * Get the native socket descriptor of the transport.
+     * Use it only to wait on several transports at once,
+     * ex: with epoll or select, then receive through get_recv_buff().
+     * \return the socket file descriptor
+     */
+    virtual int get_native_handle(void) const = 0;
 };
 
 }} //namespace
@@ -19,13 +19,34 @@
 #define INCLUDED_UHD_TYPES_DICT_HPP
 
 #include <uhd/config.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/unordered_map.hpp>
 #include <vector>
 #include <list>
 
 namespace uhd{
 
+    /*!
+     * The hash function for dict keys.
+     * Keys are hashed with boost::hash, so a custom key type
+     * must provide a hash_value() overload next to its operator==.
+     * Enumerations are hashed by their integer value.
+     */
+    template <typename Key, bool = boost::is_enum<Key>::value>
+    struct dict_key_hash : boost::hash<Key>{};
+
+    template <typename Key> struct dict_key_hash<Key, true>{
+        std::size_t operator()(const Key &key) const{
+            return boost::hash<long>()(long(key));
+        }
+    };
+
     /*!
      * A templated dictionary class with a python-like interface.
+     * Iteration follows the insertion order.
+     * Small dictionaries are searched in order, since a few key compares
+     * beat a hash; larger dictionaries are looked up through a hash index.
      */
     template <typename Key, typename Val> class dict{
     public:
@@ -34,9 +55,25 @@ namespace uhd{
          */
         dict(void);
 
+        /*!
+         * Copy constructor:
+         * The copy gets its own lookup into its own items.
+         * \param other the dictionary to copy
+         */
+        dict(const dict &other);
+
+        /*!
+         * Assignment operator:
+         * The items are copied and the lookup is rebuilt.
+         * \param other the dictionary to copy
+         * \return a reference to this dictionary
+         */
+        dict &operator=(const dict &other);
+
         /*!
          * Input iterator constructor:
          * Makes boost::assign::map_list_of work.
+         * Keeps the first item of a repeated key.
          * \param first the begin iterator
          * \param last the end iterator
          */
@@ -119,7 +156,21 @@ namespace uhd{
 
     private:
         typedef std::pair<Key, Val> pair_t;
-        std::list<pair_t> _map; //private container
+        typedef std::list<pair_t> list_type;
+        typedef boost::unordered_map<Key, typename list_type::iterator, dict_key_hash<Key> > index_type;
+        list_type _map; //private container, holds the insertion order
+        index_type _index; //private lookup into the container, when indexed
+        bool _indexed;
+
+        //! Dictionaries larger than this are indexed
+        static const std::size_t max_unindexed_size = 8;
+
+        //! Rebuild the lookup, keeping the first item of a repeated key
+        void reindex(void);
+
+        //! Find the item for a key, or the end of the container
+        typename list_type::iterator find(const Key &key);
+        typename list_type::const_iterator find(const Key &key) const;
     };
 
 } //namespace uhd
@@ -42,15 +42,75 @@ namespace uhd{
     } // namespace /*anon*/
 
     template <typename Key, typename Val>
-    dict<Key, Val>::dict(void){
+    dict<Key, Val>::dict(void):
+        _indexed(false)
+    {
         /* NOP */
     }
 
+    template <typename Key, typename Val>
+    dict<Key, Val>::dict(const dict &other):
+        _map(other._map), _indexed(false)
+    {
+        this->reindex();
+    }
+
+    template <typename Key, typename Val>
+    dict<Key, Val> &dict<Key, Val>::operator=(const dict &other){
+        if (this == &other) return *this;
+        _map = other._map;
+        this->reindex();
+        return *this;
+    }
+
     template <typename Key, typename Val> template <typename InputIterator>
     dict<Key, Val>::dict(InputIterator first, InputIterator last):
-        _map(first, last)
+        _indexed(false)
     {
-        /* NOP */
+        for (; first != last; first++){
+            if (this->find(first->first) != _map.end()) continue; //the first of a repeated key wins
+            _map.push_back(pair_t(first->first, first->second));
+            if (_indexed) _index[first->first] = --_map.end();
+            else if (_map.size() > max_unindexed_size) this->reindex();
+        }
+    }
+
+    template <typename Key, typename Val>
+    void dict<Key, Val>::reindex(void){
+        _index.clear();
+        _indexed = _map.size() > max_unindexed_size;
+        if (not _indexed) return;
+        _index.rehash(_map.size());
+        for (typename list_type::iterator it = _map.begin(); it != _map.end(); it++){
+            _index[it->first] = it;
+        }
+    }
+
+    template <typename Key, typename Val>
+    typename dict<Key, Val>::list_type::iterator dict<Key, Val>::find(const Key &key){
+        if (_indexed){
+            typename index_type::iterator it = _index.find(key);
+            return (it == _index.end())? _map.end() : it->second;
+        }
+        typename list_type::iterator it;
+        for (it = _map.begin(); it != _map.end(); it++){
+            if (it->first == key) break;
+        }
+        return it;
+    }
+
+    template <typename Key, typename Val>
+    typename dict<Key, Val>::list_type::const_iterator dict<Key, Val>::find(const Key &key) const{
+        if (_indexed){
+            typename index_type::const_iterator it = _index.find(key);
+            if (it == _index.end()) return _map.end();
+            return typename list_type::const_iterator(it->second);
+        }
+        typename list_type::const_iterator it;
+        for (it = _map.begin(); it != _map.end(); it++){
+            if (it->first == key) break;
+        }
+        return it;
     }
 
     template <typename Key, typename Val>
@@ -61,6 +121,7 @@ namespace uhd{
     template <typename Key, typename Val>
     std::vector<Key> dict<Key, Val>::keys(void) const{
         std::vector<Key> keys;
+        keys.reserve(_map.size());
         BOOST_FOREACH(const pair_t &p, _map){
             keys.push_back(p.first);
         }
@@ -70,6 +131,7 @@ namespace uhd{
     template <typename Key, typename Val>
     std::vector<Val> dict<Key, Val>::vals(void) const{
         std::vector<Val> vals;
+        vals.reserve(_map.size());
         BOOST_FOREACH(const pair_t &p, _map){
             vals.push_back(p.second);
         }
@@ -78,26 +140,21 @@ namespace uhd{
 
     template <typename Key, typename Val>
     bool dict<Key, Val>::has_key(const Key &key) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return true;
-        }
-        return false;
+        return this->find(key) != _map.end();
     }
 
     template <typename Key, typename Val>
     const Val &dict<Key, Val>::get(const Key &key, const Val &other) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
-        return other;
+        typename list_type::const_iterator it = this->find(key);
+        if (it == _map.end()) return other;
+        return it->second;
     }
 
     template <typename Key, typename Val>
     const Val &dict<Key, Val>::get(const Key &key) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
-        throw key_not_found<Key, Val>(key);
+        typename list_type::const_iterator it = this->find(key);
+        if (it == _map.end()) throw key_not_found<Key, Val>(key);
+        return it->second;
     }
 
     template <typename Key, typename Val>
@@ -107,32 +164,27 @@ namespace uhd{
 
     template <typename Key, typename Val>
     const Val &dict<Key, Val>::operator[](const Key &key) const{
-        BOOST_FOREACH(const pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
-        throw key_not_found<Key, Val>(key);
+        return this->get(key);
     }
 
     template <typename Key, typename Val>
     Val &dict<Key, Val>::operator[](const Key &key){
-        BOOST_FOREACH(pair_t &p, _map){
-            if (p.first == key) return p.second;
-        }
+        typename list_type::iterator it = this->find(key);
+        if (it != _map.end()) return it->second;
         _map.push_back(std::make_pair(key, Val()));
+        if (_indexed) _index[key] = --_map.end();
+        else if (_map.size() > max_unindexed_size) this->reindex();
         return _map.back().second;
     }
 
     template <typename Key, typename Val>
     Val dict<Key, Val>::pop(const Key &key){
-        typename std::list<pair_t>::iterator it;
-        for (it = _map.begin(); it != _map.end(); it++){
-            if (it->first == key){
-                Val val = it->second;
-                _map.erase(it);
-                return val;
-            }
-        }
-        throw key_not_found<Key, Val>(key);
+        typename list_type::iterator it = this->find(key);
+        if (it == _map.end()) throw key_not_found<Key, Val>(key);
+        Val val = it->second;
+        if (_indexed) _index.erase(key);
+        _map.erase(it);
+        return val;
     }
 
 } //namespace uhd
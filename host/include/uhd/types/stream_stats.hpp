@@ -0,0 +1,151 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_TYPES_STREAM_STATS_HPP
+#define INCLUDED_UHD_TYPES_STREAM_STATS_HPP
+
+#include <uhd/config.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+#include <vector>
+
+namespace uhd{
+
+    /*!
+     * A histogram with power of two buckets, cheap enough for a fast path.
+     * Bucket 0 counts zeros, and bucket n counts values in [2^(n-1), 2^n).
+     * The last bucket also counts all values that are larger.
+     */
+    struct UHD_API log2_histogram_t{
+        static const size_t num_buckets = 33;
+
+        //! Create an empty histogram
+        log2_histogram_t(void);
+
+        //! The number of values in each bucket
+        boost::uint64_t buckets[num_buckets];
+
+        //! The number of values added
+        boost::uint64_t count;
+
+        //! The sum of the values added
+        boost::uint64_t sum;
+
+        //! Add a value to the histogram
+        UHD_INLINE void add(boost::uint64_t value){
+            count++;
+            sum += value;
+            size_t index = 0;
+            while (value != 0 and index < num_buckets-1){
+                value >>= 1;
+                index++;
+            }
+            buckets[index]++;
+        }
+
+        //! Get the mean of the values, 0 when empty
+        double get_mean(void) const;
+
+        /*!
+         * Get an upper bound for a percentile of the values.
+         * \param fraction the fraction of values, ex: 0.99
+         * \return the upper edge of the bucket holding the percentile
+         */
+        boost::uint64_t get_percentile(const double fraction) const;
+
+        /*!
+         * Create a pretty print string for this histogram.
+         * \return the printable string
+         */
+        std::string to_pp_string(void) const;
+    };
+
+    /*!
+     * Counters and histograms from the fast path of an RX streamer.
+     * The counts are exact; the durations are sampled on a fraction of the packets.
+     * The devices publish these under /mboards/<n>/rx_dsps/<n>/stats.
+     */
+    struct UHD_API rx_stream_stats_t{
+        //! The packets received, summed over the channels
+        boost::uint64_t num_packets;
+
+        //! The payload bytes received, summed over the channels
+        boost::uint64_t num_bytes;
+
+        //! The receive calls that timed out waiting on a packet
+        boost::uint64_t num_timeouts;
+
+        //! The overflow messages received from the device
+        boost::uint64_t num_overflows;
+
+        //! The sequence errors detected on each channel
+        std::vector<boost::uint64_t> seq_errors;
+
+        //! The packets processed to get one set of time-aligned packets
+        log2_histogram_t align_iterations;
+
+        //! The nanoseconds spent waiting on the transport for a packet
+        log2_histogram_t get_buff_ns;
+
+        //! The nanoseconds spent copy-converting a set of packets
+        log2_histogram_t convert_ns;
+
+        rx_stream_stats_t(void);
+
+        /*!
+         * Create a pretty print string for these stats.
+         * \return the printable string
+         */
+        std::string to_pp_string(void) const;
+    };
+
+    /*!
+     * Counters and histograms from the fast path of a TX streamer.
+     * The counts are exact; the durations are sampled on a fraction of the packets.
+     * The devices publish these under /mboards/<n>/tx_dsps/<n>/stats.
+     */
+    struct UHD_API tx_stream_stats_t{
+        //! The packets sent, summed over the channels
+        boost::uint64_t num_packets;
+
+        //! The payload bytes sent, summed over the channels
+        boost::uint64_t num_bytes;
+
+        //! The send calls that timed out waiting on a send buffer
+        boost::uint64_t num_timeouts;
+
+        //! The nanoseconds spent getting a send buffer, flow control included
+        log2_histogram_t get_buff_ns;
+
+        //! The nanoseconds spent copy-converting a set of packets
+        log2_histogram_t convert_ns;
+
+        //! The nanoseconds spent blocked on flow control, every wait is counted
+        log2_histogram_t fc_wait_ns;
+
+        tx_stream_stats_t(void);
+
+        /*!
+         * Create a pretty print string for these stats.
+         * \return the printable string
+         */
+        std::string to_pp_string(void) const;
+    };
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_TYPES_STREAM_STATS_HPP */
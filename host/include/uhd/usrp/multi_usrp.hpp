@@ -234,6 +234,8 @@ public:
      * A timed command will back-pressure all subsequent timed commands,
      * assuming that the subsequent commands occur within the time-window.
      * If the time spec is late, the command will be activated upon arrival.
+     * Only register writes are timed: readbacks, and settings that need them,
+     * like an LO retune that calibrates the VCO, take effect right away.
      *
      * \param time_spec the time at which the next command will activate
      * \param mboard which motherboard to set the config
@@ -0,0 +1,106 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_UHD_UTILS_ATOMIC_HPP
+#define INCLUDED_UHD_UTILS_ATOMIC_HPP
+
+#include <uhd/config.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/version.hpp>
+#include <boost/interprocess/detail/atomic.hpp>
+#include <boost/thread/thread.hpp>
+
+#if BOOST_VERSION >= 104800
+#  define BOOST_IPC_DETAIL boost::interprocess::ipcdetail
+#else
+#  define BOOST_IPC_DETAIL boost::interprocess::detail
+#endif
+
+namespace uhd{
+
+    /*!
+     * A 32-bit integer that can be atomically accessed from multiple threads.
+     * The read-modify-write operations (cas, inc, dec) are full memory barriers.
+     */
+    class atomic_uint32_t{
+    public:
+
+        //! Create a new atomic 32-bit integer, initially zero
+        UHD_INLINE atomic_uint32_t(void){
+            this->write(0);
+        }
+
+        /*!
+         * Compare with cmp, swap with newval if same.
+         * \return the old value, equals cmp when the swap happened
+         */
+        UHD_INLINE boost::uint32_t cas(boost::uint32_t newval, boost::uint32_t cmp){
+            return BOOST_IPC_DETAIL::atomic_cas32(&_num, newval, cmp);
+        }
+
+        //! Increment by 1 and return the old value
+        UHD_INLINE boost::uint32_t inc(void){
+            return BOOST_IPC_DETAIL::atomic_inc32(&_num);
+        }
+
+        //! Decrement by 1 and return the old value
+        UHD_INLINE boost::uint32_t dec(void){
+            return BOOST_IPC_DETAIL::atomic_dec32(&_num);
+        }
+
+        //! Get the current value
+        UHD_INLINE boost::uint32_t read(void){
+            return BOOST_IPC_DETAIL::atomic_read32(&_num);
+        }
+
+        //! Set the current value
+        UHD_INLINE void write(const boost::uint32_t newval){
+            BOOST_IPC_DETAIL::atomic_write32(&_num, newval);
+        }
+
+    private: volatile boost::uint32_t _num;
+    };
+
+    /*!
+     * A spin lock for critical sections of a few instructions.
+     * Ex: let several threads share the producer side of a
+     * single-producer queue. A waiting thread yields the processor.
+     */
+    class spin_lock{
+    public:
+        UHD_INLINE void lock(void){
+            while (_locked.cas(1, 0) != 0) boost::this_thread::yield();
+        }
+
+        UHD_INLINE void unlock(void){
+            _locked.cas(0, 1);
+        }
+
+        //! Hold the lock for the life of the scope
+        class scoped_lock{
+        public:
+            UHD_INLINE scoped_lock(spin_lock &lock): _lock(lock){_lock.lock();}
+            UHD_INLINE ~scoped_lock(void){_lock.unlock();}
+        private: spin_lock &_lock;
+        };
+
+    private: atomic_uint32_t _locked;
+    };
+
+} //namespace uhd
+
+#endif /* INCLUDED_UHD_UTILS_ATOMIC_HPP */
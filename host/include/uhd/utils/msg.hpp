@@ -59,6 +59,15 @@ namespace uhd{ namespace msg{
      */
     UHD_API void register_handler(const handler_t &handler);
 
+    /*!
+     * Hand all queued fast-path messages to the handler now.
+     * Fast-path messages are queued by the sending thread without
+     * blocking and handed to the handler from a background thread.
+     * A message repeated more than a few times in a second is
+     * reported once as a count, ex: "O x 523 in last 1s".
+     */
+    UHD_API void flush(void);
+
     //! Internal message object (called by UHD_MSG macro)
     class UHD_API _msg{
     public:
@@ -53,6 +53,20 @@ namespace uhd{
         bool realtime = true
     );
 
+    /*!
+     * Pin the current thread to a single CPU core.
+     * \param cpu the index of the core
+     * \throw exception on set affinity failure
+     */
+    UHD_API void set_thread_affinity(size_t cpu);
+
+    /*!
+     * Pin the current thread to a single CPU core.
+     * Same as set_thread_affinity but does not throw on failure.
+     * \return true on success, false on failure
+     */
+    UHD_API bool set_thread_affinity_safe(size_t cpu);
+
 } //namespace uhd
 
 #endif /* INCLUDED_UHD_UTILS_THREAD_PRIORITY_HPP */
@@ -24,6 +24,9 @@
 #include <complex>
 
 #define _DECLARE_CONVERTER(name, in_form, num_in, out_form, num_out, prio) \
+    _DECLARE_CONVERTER_IF(true, name, in_form, num_in, out_form, num_out, prio)
+
+#define _DECLARE_CONVERTER_IF(cond, name, in_form, num_in, out_form, num_out, prio) \
     struct name : public uhd::convert::converter{ \
         static sptr make(void){return sptr(new name());} \
         double scale_factor; \
@@ -31,6 +34,7 @@
         void operator()(const input_type&, const output_type&, const size_t); \
     }; \
     UHD_STATIC_BLOCK(__register_##name##_##prio){ \
+        if (not (cond)) return; \
         uhd::convert::id_type id; \
         id.input_format = #in_form; \
         id.num_inputs = num_in; \
@@ -45,6 +49,10 @@
 #define DECLARE_CONVERTER(in_form, num_in, out_form, num_out, prio) \
     _DECLARE_CONVERTER(__convert_##in_form##_##num_in##_##out_form##_##num_out##_##prio, in_form, num_in, out_form, num_out, prio)
 
+//! declare a converter that is only registered when cond is true at runtime
+#define DECLARE_CONVERTER_IF(cond, in_form, num_in, out_form, num_out, prio) \
+    _DECLARE_CONVERTER_IF(cond, __convert_##in_form##_##num_in##_##out_form##_##num_out##_##prio, in_form, num_in, out_form, num_out, prio)
+
 /***********************************************************************
  * Setup priorities
  **********************************************************************/
@@ -61,6 +69,13 @@ static const int PRIORITY_SIMD = 2;
 static const int PRIORITY_TABLE = 3;
 #endif
 
+//simd that replaces a table conversion, so it must outrank the table
+static const int PRIORITY_SIMD_OVER_TABLE = PRIORITY_TABLE + 1;
+
+//wider x86 simd, registered only when the host processor supports it
+static const int PRIORITY_SIMD_AVX2 = PRIORITY_TABLE + 2;
+static const int PRIORITY_SIMD_AVX512 = PRIORITY_TABLE + 3;
+
 /***********************************************************************
  * Typedefs
  **********************************************************************/
@@ -0,0 +1,73 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_CONVERT_CPUID_HPP
+#define INCLUDED_LIBUHD_CONVERT_CPUID_HPP
+
+#include <uhd/config.hpp>
+#include <boost/cstdint.hpp>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  include <cpuid.h>
+#  define HAVE_X86_CPUID
+#endif
+
+/***********************************************************************
+ * Runtime detection of x86 instruction set extensions:
+ * An extension is usable when the processor reports it in cpuid,
+ * and the operating system saves the register state (xgetbv),
+ * so a single binary can carry kernels for newer processors.
+ **********************************************************************/
+#ifdef HAVE_X86_CPUID
+
+static UHD_INLINE boost::uint64_t x86_xgetbv0(void){
+    boost::uint32_t eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    return (boost::uint64_t(edx) << 32) | eax;
+}
+
+//! get the cpuid leaf 7 ebx bits, or 0 when the os does not save the given xcr0 state
+static UHD_INLINE boost::uint32_t x86_extended_features(const boost::uint64_t xcr0_mask){
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, 0) < 7) return 0;
+    __cpuid(1, eax, ebx, ecx, edx);
+    const unsigned int osxsave_avx = (1 << 27) | (1 << 28);
+    if ((ecx & osxsave_avx) != osxsave_avx) return 0;
+    if ((x86_xgetbv0() & xcr0_mask) != xcr0_mask) return 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx;
+}
+
+static UHD_INLINE bool cpu_has_avx2(void){
+    //xcr0: sse and avx state
+    return (x86_extended_features(0x6) & (1 << 5)) != 0;
+}
+
+static UHD_INLINE bool cpu_has_avx512bw(void){
+    //xcr0: sse, avx, opmask, and upper zmm state
+    const boost::uint32_t avx512f_bw = (1 << 16) | (1 << 30);
+    return (x86_extended_features(0xe6) & avx512f_bw) == avx512f_bw;
+}
+
+#else /* HAVE_X86_CPUID */
+
+static UHD_INLINE bool cpu_has_avx2(void){return false;}
+static UHD_INLINE bool cpu_has_avx512bw(void){return false;}
+
+#endif /* HAVE_X86_CPUID */
+
+#endif /* INCLUDED_LIBUHD_CONVERT_CPUID_HPP */
@@ -19,10 +19,19 @@
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/static.hpp>
 #include <uhd/types/dict.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/exception.hpp>
 #include <boost/cstdint.hpp>
+#include <boost/foreach.hpp>
 #include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
 #include <complex>
+#include <cstdlib> //getenv
+#include <limits>
+#include <vector>
 
 using namespace uhd;
 
@@ -35,6 +44,15 @@ bool convert::operator==(const convert::id_type &lhs, const convert::id_type &rh
     ;
 }
 
+std::size_t convert::hash_value(const convert::id_type &id){
+    std::size_t seed = 0;
+    boost::hash_combine(seed, id.input_format);
+    boost::hash_combine(seed, id.num_inputs);
+    boost::hash_combine(seed, id.output_format);
+    boost::hash_combine(seed, id.num_outputs);
+    return seed;
+}
+
 std::string convert::id_type::to_pp_string(void) const{
     return str(boost::format(
         "conversion ID\n"
@@ -51,16 +69,11 @@ std::string convert::id_type::to_pp_string(void) const{
 }
 
 /***********************************************************************
- * Define types for the function tables
- **********************************************************************/
-struct fcn_table_entry_type{
-    convert::priority_type prio;
-    convert::function_type fcn;
-};
-
-/***********************************************************************
- * Setup the table registry
+ * Setup the table registry:
+ * Every registered function is kept, keyed by its priority,
+ * so that a specific implementation can be requested.
  **********************************************************************/
+typedef uhd::dict<convert::priority_type, convert::function_type> fcn_table_entry_type;
 typedef uhd::dict<convert::id_type, fcn_table_entry_type> fcn_table_type;
 UHD_SINGLETON_FCN(fcn_table_type, get_table);
 
@@ -75,11 +88,9 @@ void uhd::convert::register_converter(
     //get a reference to the function table
     fcn_table_type &table = get_table();
 
-    //register the function if higher priority
-    if (not table.has_key(id) or table[id].prio < prio){
-        table[id].fcn = fcn;
-        table[id].prio = prio;
-    }
+    //register the function under its priority
+    if (not table.has_key(id)) table[id] = fcn_table_entry_type();
+    table[id][prio] = fcn;
 
     //----------------------------------------------------------------//
     UHD_LOGV(always) << "register_converter: " << id.to_pp_string() << std::endl
@@ -89,12 +100,126 @@ void uhd::convert::register_converter(
     //----------------------------------------------------------------//
 }
 
+/***********************************************************************
+ * Converter selection:
+ * By default, the highest priority implementation wins.
+ * UHD_CONVERT_PRIO pins the implementation with that priority (if registered).
+ * UHD_CONVERT_BENCHMARK times every implementation on a short synthetic
+ * buffer the first time a conversion is requested, and keeps the fastest.
+ **********************************************************************/
+static const size_t BENCHMARK_NSAMPS = 4096; //a few packets worth
+static const size_t BENCHMARK_ITERATIONS = 16;
+
+typedef uhd::dict<convert::id_type, convert::priority_type> selection_table_type;
+UHD_SINGLETON_FCN(selection_table_type, get_selection_table);
+UHD_SINGLETON_FCN(boost::mutex, get_selection_mutex);
+
+static bool get_env_prio(convert::priority_type &prio){
+    const char *prio_env = std::getenv("UHD_CONVERT_PRIO");
+    if (prio_env == NULL) return false;
+    try{
+        prio = boost::lexical_cast<convert::priority_type>(prio_env);
+        return true;
+    }
+    catch(const boost::bad_lexical_cast &){
+        UHD_MSG(warning) << "Ignoring invalid UHD_CONVERT_PRIO: " << prio_env << std::endl;
+        return false;
+    }
+}
+
+static bool benchmark_enabled(void){
+    const char *benchmark_env = std::getenv("UHD_CONVERT_BENCHMARK");
+    return benchmark_env != NULL and std::string(benchmark_env) != "0";
+}
+
+//! time a converter on zeroed buffers, return the best time per call in seconds
+static double time_converter(const convert::id_type &id, const convert::function_type &fcn){
+    //size buffers for the wider side, multi-channel formats interleave the channels
+    const size_t nitems = BENCHMARK_NSAMPS*std::max(id.num_inputs, id.num_outputs);
+    std::vector<std::vector<char> > input_mems(id.num_inputs,
+        std::vector<char>(nitems*convert::get_bytes_per_item(id.input_format)));
+    std::vector<std::vector<char> > output_mems(id.num_outputs,
+        std::vector<char>(nitems*convert::get_bytes_per_item(id.output_format)));
+
+    std::vector<const void *> inputs;
+    std::vector<void *> outputs;
+    BOOST_FOREACH(const std::vector<char> &mem, input_mems) inputs.push_back(&mem.front());
+    BOOST_FOREACH(std::vector<char> &mem, output_mems) outputs.push_back(&mem.front());
+
+    convert::converter::sptr converter = fcn();
+    converter->set_scalar(1.0);
+    converter->conv(inputs, outputs, BENCHMARK_NSAMPS); //warm up
+
+    double best_secs = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++){
+        const time_spec_t start = time_spec_t::get_system_time();
+        converter->conv(inputs, outputs, BENCHMARK_NSAMPS);
+        best_secs = std::min(best_secs, (time_spec_t::get_system_time() - start).get_real_secs());
+    }
+    return best_secs;
+}
+
+static convert::priority_type select_prio(
+    const convert::id_type &id, const fcn_table_entry_type &entry
+){
+    //pinned from the environment when debugging
+    convert::priority_type env_prio;
+    if (get_env_prio(env_prio) and entry.has_key(env_prio)) return env_prio;
+
+    //find the highest priority
+    const std::vector<convert::priority_type> prios = entry.keys();
+    convert::priority_type best_prio = prios.front();
+    BOOST_FOREACH(const convert::priority_type &prio, prios){
+        if (prio > best_prio) best_prio = prio;
+    }
+    if (prios.size() < 2 or not benchmark_enabled()) return best_prio;
+
+    //time the candidates once and remember the winner
+    boost::mutex::scoped_lock lock(get_selection_mutex());
+    if (get_selection_table().has_key(id)) return get_selection_table()[id];
+    try{
+        double best_secs = std::numeric_limits<double>::max();
+        BOOST_FOREACH(const convert::priority_type &prio, prios){
+            const double secs = time_converter(id, entry[prio]);
+            UHD_LOG << boost::format("converter %s -> %s prio %d: %f ns/sample")
+                % id.input_format % id.output_format % prio % (secs*1e9/BENCHMARK_NSAMPS) << std::endl;
+            if (secs < best_secs){
+                best_secs = secs;
+                best_prio = prio;
+            }
+        }
+    }
+    catch(const uhd::exception &e){
+        UHD_LOG << "converter benchmark failed, using priority: " << e.what() << std::endl;
+    }
+    get_selection_table()[id] = best_prio;
+    return best_prio;
+}
+
 /***********************************************************************
  * The converter functions
  **********************************************************************/
-convert::function_type convert::get_converter(const id_type &id){
-    if (get_table().has_key(id)) return get_table()[id].fcn;
-    throw uhd::key_error("Cannot find a conversion routine for " + id.to_pp_string());
+convert::function_type convert::get_converter(const id_type &id, const priority_type prio){
+    if (not get_table().has_key(id)) throw uhd::key_error(
+        "Cannot find a conversion routine for " + id.to_pp_string()
+    );
+    const fcn_table_entry_type &entry = get_table()[id];
+
+    if (prio == -1) return entry[select_prio(id, entry)];
+
+    if (entry.has_key(prio)) return entry[prio];
+    throw uhd::key_error(str(boost::format(
+        "Cannot find a conversion routine with priority %d for %s"
+    ) % prio % id.to_pp_string()));
+}
+
+std::vector<convert::id_type> convert::get_converter_ids(void){
+    return get_table().keys();
+}
+
+std::vector<convert::priority_type> convert::get_converter_prios(const id_type &id){
+    if (not get_table().has_key(id)) return std::vector<priority_type>();
+    return get_table()[id].keys();
 }
 
 /***********************************************************************
@@ -140,4 +265,7 @@ UHD_STATIC_BLOCK(convert_register_item_sizes){
     convert::register_bytes_per_item("s32", sizeof(boost::int32_t));
     convert::register_bytes_per_item("s16", sizeof(boost::int16_t));
     convert::register_bytes_per_item("s8", sizeof(boost::int8_t));
+
+    //register raw device items
+    convert::register_bytes_per_item("item32", sizeof(boost::uint32_t));
 }
@@ -0,0 +1,191 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <emmintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * SSE2 sign-extend-and-scale for sc8 item32:
+ * These replace the 64K entry lookup tables, which take 512KB (fc32)
+ * or 1MB (fc64) of cache and are rebuilt on every call to set_scalar.
+ *
+ * Each kernel takes 16 bytes (8 samples) per iteration:
+ *  - swap the bytes into host (real, imag) order
+ *    le: swap the bytes of every 16-bit half
+ *    be: swap the 16-bit halves of every item
+ *  - sign extend the bytes to 16 bits (unpack with itself, shift right)
+ *  - for floats, sign extend to 32 bits, convert, and scale
+ **********************************************************************/
+template <bool wire_be> static UHD_INLINE __m128i sc8_item32_to_host(const __m128i tmpi){
+    if (wire_be){
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(tmpi, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+    }
+    return _mm_or_si128(_mm_srli_epi16(tmpi, 8), _mm_slli_epi16(tmpi, 8));
+}
+
+template <bool wire_be> static UHD_INLINE item32_t to_host(const item32_t item){
+    return wire_be? uhd::ntohx(item) : uhd::wtohx(item);
+}
+
+//! sign extend the low or high 8 bytes to 16 bits
+static UHD_INLINE __m128i sc8_to_sc16_lo(const __m128i tmpi){
+    return _mm_srai_epi16(_mm_unpacklo_epi8(tmpi, tmpi), 8);
+}
+
+static UHD_INLINE __m128i sc8_to_sc16_hi(const __m128i tmpi){
+    return _mm_srai_epi16(_mm_unpackhi_epi8(tmpi, tmpi), 8);
+}
+
+//! sign extend the low or high 4 shorts to 32 bits
+static UHD_INLINE __m128i sc16_to_sc32_lo(const __m128i tmpi){
+    return _mm_srai_epi32(_mm_unpacklo_epi16(tmpi, tmpi), 16);
+}
+
+static UHD_INLINE __m128i sc16_to_sc32_hi(const __m128i tmpi){
+    return _mm_srai_epi32(_mm_unpackhi_epi16(tmpi, tmpi), 16);
+}
+
+/***********************************************************************
+ * Per-type store of 8 samples from two vectors of 4 sign-extended pairs
+ **********************************************************************/
+static UHD_INLINE void store_sc32_as_fc32(fc32_t *output, const __m128i tmpi, const __m128 scalar){
+    _mm_storeu_ps(reinterpret_cast<float *>(output), _mm_mul_ps(_mm_cvtepi32_ps(tmpi), scalar));
+}
+
+static UHD_INLINE void store_sc32_as_fc64(fc64_t *output, const __m128i tmpi, const __m128d scalar){
+    _mm_storeu_pd(reinterpret_cast<double *>(output+0), _mm_mul_pd(_mm_cvtepi32_pd(tmpi), scalar));
+    _mm_storeu_pd(reinterpret_cast<double *>(output+1), _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(tmpi, 8)), scalar));
+}
+
+struct sc8_to_fc32_kernel{
+    sc8_to_fc32_kernel(const double scale_factor): scalar(_mm_set_ps1(float(scale_factor))){}
+    UHD_INLINE void operator()(fc32_t *output, const __m128i lo, const __m128i hi) const{
+        store_sc32_as_fc32(output+0, sc16_to_sc32_lo(lo), scalar);
+        store_sc32_as_fc32(output+2, sc16_to_sc32_hi(lo), scalar);
+        store_sc32_as_fc32(output+4, sc16_to_sc32_lo(hi), scalar);
+        store_sc32_as_fc32(output+6, sc16_to_sc32_hi(hi), scalar);
+    }
+    const __m128 scalar;
+};
+
+struct sc8_to_fc64_kernel{
+    sc8_to_fc64_kernel(const double scale_factor): scalar(_mm_set1_pd(scale_factor)){}
+    UHD_INLINE void operator()(fc64_t *output, const __m128i lo, const __m128i hi) const{
+        store_sc32_as_fc64(output+0, sc16_to_sc32_lo(lo), scalar);
+        store_sc32_as_fc64(output+2, sc16_to_sc32_hi(lo), scalar);
+        store_sc32_as_fc64(output+4, sc16_to_sc32_lo(hi), scalar);
+        store_sc32_as_fc64(output+6, sc16_to_sc32_hi(hi), scalar);
+    }
+    const __m128d scalar;
+};
+
+struct sc8_to_sc16_kernel{
+    sc8_to_sc16_kernel(const double){}
+    UHD_INLINE void operator()(sc16_t *output, const __m128i lo, const __m128i hi) const{
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output+0), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output+4), hi);
+    }
+};
+
+/***********************************************************************
+ * The conversion loop, shared by all output types:
+ * The input may start on the upper half of an item (odd sample offset).
+ **********************************************************************/
+template <bool wire_be, typename kernel_type, typename out_type>
+static UHD_INLINE void convert_sc8_item32_1_to_xx_1(
+    const void *input_addr, out_type *output, const size_t nsamps, const double scale_factor,
+    void (*convert_item)(item32_t, out_type &, out_type &, double)
+){
+    const item32_t *input = reinterpret_cast<const item32_t *>(size_t(input_addr) & ~0x3);
+    const kernel_type kernel(scale_factor);
+    out_type dummy;
+    size_t num_samps = nsamps;
+
+    if ((size_t(input_addr) & 0x3) != 0){
+        const item32_t item0 = to_host<wire_be>(*input++);
+        convert_item(item0, dummy, *output++, scale_factor);
+        num_samps--;
+    }
+
+    const size_t num_pairs = num_samps/2;
+    size_t i = 0;
+    for (; i+4 <= num_pairs; i+=4){
+        //load 4 items (8 samples) from input + swap to host
+        __m128i tmpi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+i));
+        tmpi = sc8_item32_to_host<wire_be>(tmpi);
+
+        //sign extend, convert and store
+        kernel(output+2*i, sc8_to_sc16_lo(tmpi), sc8_to_sc16_hi(tmpi));
+    }
+
+    //convert remainder
+    for (; i < num_pairs; i++){
+        convert_item(to_host<wire_be>(input[i]), output[2*i], output[2*i+1], scale_factor);
+    }
+
+    if (num_samps != num_pairs*2){
+        const item32_t item_n = to_host<wire_be>(input[num_pairs]);
+        convert_item(item_n, output[num_samps-1], dummy, scale_factor);
+    }
+}
+
+/***********************************************************************
+ * Exact scaling for fc64, the general converter rounds through float
+ **********************************************************************/
+static UHD_INLINE void item32_sc8_to_fc64_exact(item32_t item, fc64_t &out0, fc64_t &out1, double scale_factor){
+    out0 = fc64_t(boost::int8_t(item >> 8)*scale_factor, boost::int8_t(item >> 0)*scale_factor);
+    out1 = fc64_t(boost::int8_t(item >> 24)*scale_factor, boost::int8_t(item >> 16)*scale_factor);
+}
+
+DECLARE_CONVERTER(sc8_item32_le, 1, fc32, 1, PRIORITY_SIMD_OVER_TABLE){
+    convert_sc8_item32_1_to_xx_1<false, sc8_to_fc32_kernel>(
+        inputs[0], reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor, &item32_sc8_to_fc32
+    );
+}
+
+DECLARE_CONVERTER(sc8_item32_be, 1, fc32, 1, PRIORITY_SIMD_OVER_TABLE){
+    convert_sc8_item32_1_to_xx_1<true, sc8_to_fc32_kernel>(
+        inputs[0], reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor, &item32_sc8_to_fc32
+    );
+}
+
+DECLARE_CONVERTER(sc8_item32_le, 1, fc64, 1, PRIORITY_SIMD_OVER_TABLE){
+    convert_sc8_item32_1_to_xx_1<false, sc8_to_fc64_kernel>(
+        inputs[0], reinterpret_cast<fc64_t *>(outputs[0]), nsamps, scale_factor, &item32_sc8_to_fc64_exact
+    );
+}
+
+DECLARE_CONVERTER(sc8_item32_be, 1, fc64, 1, PRIORITY_SIMD_OVER_TABLE){
+    convert_sc8_item32_1_to_xx_1<true, sc8_to_fc64_kernel>(
+        inputs[0], reinterpret_cast<fc64_t *>(outputs[0]), nsamps, scale_factor, &item32_sc8_to_fc64_exact
+    );
+}
+
+DECLARE_CONVERTER(sc8_item32_le, 1, sc16, 1, PRIORITY_SIMD_OVER_TABLE){
+    convert_sc8_item32_1_to_xx_1<false, sc8_to_sc16_kernel>(
+        inputs[0], reinterpret_cast<sc16_t *>(outputs[0]), nsamps, scale_factor, &item32_sc8_to_sc16
+    );
+}
+
+DECLARE_CONVERTER(sc8_item32_be, 1, sc16, 1, PRIORITY_SIMD_OVER_TABLE){
+    convert_sc8_item32_1_to_xx_1<true, sc8_to_sc16_kernel>(
+        inputs[0], reinterpret_cast<sc16_t *>(outputs[0]), nsamps, scale_factor, &item32_sc8_to_sc16
+    );
+}
@@ -0,0 +1,191 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <emmintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * USRP1 multi-channel sc16:
+ * The channels are interleaved in one buffer, one 32-bit word per
+ * channel per sample, each word being I16 then Q16 in little endian.
+ * On a little endian host a word is exactly one sc16_t in memory.
+ *
+ * The converters below work on 4 samples of every channel at once:
+ * the width vectors of 4 words are transposed into one vector per
+ * channel (or back), so deinterleaving and the sample conversion
+ * happen in a single pass over the packet.
+ **********************************************************************/
+template <size_t width> static UHD_INLINE void transpose_words(__m128i *vecs);
+
+template <> UHD_INLINE void transpose_words<2>(__m128i *vecs){
+    const __m128 a = _mm_castsi128_ps(vecs[0]);
+    const __m128 b = _mm_castsi128_ps(vecs[1]);
+    vecs[0] = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    vecs[1] = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+template <> UHD_INLINE void transpose_words<4>(__m128i *vecs){
+    const __m128i t0 = _mm_unpacklo_epi32(vecs[0], vecs[1]);
+    const __m128i t1 = _mm_unpacklo_epi32(vecs[2], vecs[3]);
+    const __m128i t2 = _mm_unpackhi_epi32(vecs[0], vecs[1]);
+    const __m128i t3 = _mm_unpackhi_epi32(vecs[2], vecs[3]);
+    vecs[0] = _mm_unpacklo_epi64(t0, t1);
+    vecs[1] = _mm_unpackhi_epi64(t0, t1);
+    vecs[2] = _mm_unpacklo_epi64(t2, t3);
+    vecs[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+//! the inverse of the 2 channel deinterleave
+static UHD_INLINE void interleave_words_2(__m128i *vecs){
+    const __m128i a = vecs[0];
+    vecs[0] = _mm_unpacklo_epi32(a, vecs[1]);
+    vecs[1] = _mm_unpackhi_epi32(a, vecs[1]);
+}
+
+template <size_t width> static UHD_INLINE void interleave_words(__m128i *vecs){
+    if (width == 2) interleave_words_2(vecs);
+    else transpose_words<width>(vecs); //4x4 transpose is its own inverse
+}
+
+/***********************************************************************
+ * Per-type load and store of 4 samples as a vector of sc16
+ **********************************************************************/
+struct sc16_io{
+    sc16_io(const double){}
+    UHD_INLINE void store(sc16_t *output, const __m128i tmpi) const{
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output), tmpi);
+    }
+    UHD_INLINE __m128i load(const sc16_t *input) const{
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(input));
+    }
+    static UHD_INLINE sc16_t to_cpu(const sc16_t &num, double){
+        return num;
+    }
+    static UHD_INLINE sc16_t to_wire(const sc16_t &num, double){
+        return num;
+    }
+};
+
+struct fc32_io{
+    fc32_io(const double scale_factor): scalar(_mm_set_ps1(float(scale_factor))){}
+    UHD_INLINE void store(fc32_t *output, const __m128i tmpi) const{
+        const __m128i tmpilo = _mm_srai_epi32(_mm_unpacklo_epi16(tmpi, tmpi), 16);
+        const __m128i tmpihi = _mm_srai_epi32(_mm_unpackhi_epi16(tmpi, tmpi), 16);
+        _mm_storeu_ps(reinterpret_cast<float *>(output+0), _mm_mul_ps(_mm_cvtepi32_ps(tmpilo), scalar));
+        _mm_storeu_ps(reinterpret_cast<float *>(output+2), _mm_mul_ps(_mm_cvtepi32_ps(tmpihi), scalar));
+    }
+    UHD_INLINE __m128i load(const fc32_t *input) const{
+        const __m128 tmplo = _mm_loadu_ps(reinterpret_cast<const float *>(input+0));
+        const __m128 tmphi = _mm_loadu_ps(reinterpret_cast<const float *>(input+2));
+        return _mm_packs_epi32(
+            _mm_cvtps_epi32(_mm_mul_ps(tmplo, scalar)),
+            _mm_cvtps_epi32(_mm_mul_ps(tmphi, scalar))
+        );
+    }
+    static UHD_INLINE fc32_t to_cpu(const sc16_t &num, double scale_factor){
+        return fc32_t(num.real()*float(scale_factor), num.imag()*float(scale_factor));
+    }
+    static UHD_INLINE sc16_t to_wire(const fc32_t &num, double scale_factor){
+        return sc16_t(
+            boost::int16_t(num.real()*float(scale_factor)),
+            boost::int16_t(num.imag()*float(scale_factor))
+        );
+    }
+    const __m128 scalar;
+};
+
+/***********************************************************************
+ * Deinterleave for RX and interleave for TX
+ **********************************************************************/
+template <size_t width, typename io_type, typename cpu_type>
+static UHD_INLINE void convert_usrp1_1_to_cpu_n(
+    const void *input_addr, void *const *outputs, const size_t nsamps, const double scale_factor
+){
+    const sc16_t *input = reinterpret_cast<const sc16_t *>(input_addr);
+    cpu_type *output[width];
+    for (size_t w = 0; w < width; w++) output[w] = reinterpret_cast<cpu_type *>(outputs[w]);
+
+    const io_type io(scale_factor);
+    __m128i vecs[width];
+
+    size_t i = 0;
+    for (; i+4 <= nsamps; i+=4){
+        for (size_t w = 0; w < width; w++){
+            vecs[w] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+width*i+4*w));
+        }
+        transpose_words<width>(vecs);
+        for (size_t w = 0; w < width; w++) io.store(output[w]+i, vecs[w]);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        for (size_t w = 0; w < width; w++){
+            output[w][i] = io_type::to_cpu(input[width*i+w], scale_factor);
+        }
+    }
+}
+
+template <size_t width, typename io_type, typename cpu_type>
+static UHD_INLINE void convert_cpu_n_to_usrp1_1(
+    const void *const *inputs, void *output_addr, const size_t nsamps, const double scale_factor
+){
+    const cpu_type *input[width];
+    for (size_t w = 0; w < width; w++) input[w] = reinterpret_cast<const cpu_type *>(inputs[w]);
+    sc16_t *output = reinterpret_cast<sc16_t *>(output_addr);
+
+    const io_type io(scale_factor);
+    __m128i vecs[width];
+
+    size_t i = 0;
+    for (; i+4 <= nsamps; i+=4){
+        for (size_t w = 0; w < width; w++) vecs[w] = io.load(input[w]+i);
+        interleave_words<width>(vecs);
+        for (size_t w = 0; w < width; w++){
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output+width*i+4*w), vecs[w]);
+        }
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        for (size_t w = 0; w < width; w++){
+            output[width*i+w] = io_type::to_wire(input[w][i], scale_factor);
+        }
+    }
+}
+
+/***********************************************************************
+ * Register the 2 and 4 channel converters
+ **********************************************************************/
+#define DECLARE_USRP1_SSE2_CONVERTERS(cpu_type, width) \
+    DECLARE_CONVERTER(sc16_item16_usrp1, 1, cpu_type, width, PRIORITY_SIMD){ \
+        convert_usrp1_1_to_cpu_n<width, cpu_type ## _io, cpu_type ## _t>( \
+            inputs[0], &outputs[0], nsamps, scale_factor \
+        ); \
+    } \
+    DECLARE_CONVERTER(cpu_type, width, sc16_item16_usrp1, 1, PRIORITY_SIMD){ \
+        convert_cpu_n_to_usrp1_1<width, cpu_type ## _io, cpu_type ## _t>( \
+            &inputs[0], outputs[0], nsamps, scale_factor \
+        ); \
+    }
+
+DECLARE_USRP1_SSE2_CONVERTERS(sc16, 2)
+DECLARE_USRP1_SSE2_CONVERTERS(sc16, 4)
+DECLARE_USRP1_SSE2_CONVERTERS(fc32, 2)
+DECLARE_USRP1_SSE2_CONVERTERS(fc32, 4)
@@ -0,0 +1,268 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include "convert_cpuid.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <immintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * The kernels are compiled for avx2 with a function attribute,
+ * not a file-wide flag, so that the static registration code
+ * runs on any processor. The converters are only registered
+ * when the processor supports avx2 (checked at load time).
+ *
+ * Unaligned loads and stores are used throughout,
+ * they cost nothing extra on aligned data with avx2 processors.
+ **********************************************************************/
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+/***********************************************************************
+ * Byte shuffles between host order and the sc16/sc8 item32 wire formats
+ *  - sc16 le: swap the 16-bit halves of every item
+ *  - sc16 be: swap the bytes of every 16-bit half
+ *  - sc8 le: swap the bytes of every 16-bit half
+ *  - sc8 be: swap the 16-bit halves of every item
+ * Every shuffle is its own inverse.
+ **********************************************************************/
+static AVX2_TARGET __m128i swap_halves_mask(void){
+    return _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+}
+
+static AVX2_TARGET __m128i swap_bytes_mask(void){
+    return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+}
+
+static AVX2_TARGET __m256i broadcast_mask(const __m128i mask){
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(mask), mask, 1);
+}
+
+template <bool wire_be> static UHD_INLINE item32_t to_host(const item32_t item){
+    return wire_be? uhd::ntohx(item) : uhd::wtohx(item);
+}
+
+template <bool wire_be> static UHD_INLINE item32_t to_wire(const item32_t item){
+    return to_host<wire_be>(item); //symmetric
+}
+
+/***********************************************************************
+ * Convert complex float to sc16 item32
+ **********************************************************************/
+template <bool wire_be> static AVX2_TARGET void convert_fc32_1_to_item32_1_avx2(
+    const fc32_t *input, item32_t *output, const size_t nsamps, const double scale_factor
+){
+    const __m256 scalar = _mm256_set1_ps(float(scale_factor));
+    const __m256i shuffle = broadcast_mask(wire_be? swap_bytes_mask() : swap_halves_mask());
+
+    size_t i = 0;
+    for (; i+8 <= nsamps; i+=8){
+        //load from input
+        __m256 tmplo = _mm256_loadu_ps(reinterpret_cast<const float *>(input+i+0));
+        __m256 tmphi = _mm256_loadu_ps(reinterpret_cast<const float *>(input+i+4));
+
+        //convert and scale
+        __m256i tmpilo = _mm256_cvtps_epi32(_mm256_mul_ps(tmplo, scalar));
+        __m256i tmpihi = _mm256_cvtps_epi32(_mm256_mul_ps(tmphi, scalar));
+
+        //pack (per 128-bit lane) + restore the sample order + swap to wire
+        __m256i tmpi = _mm256_packs_epi32(tmpilo, tmpihi);
+        tmpi = _mm256_permute4x64_epi64(tmpi, _MM_SHUFFLE(3, 1, 2, 0));
+        tmpi = _mm256_shuffle_epi8(tmpi, shuffle);
+
+        //store to output
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output+i), tmpi);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        output[i] = to_wire<wire_be>(fc32_to_item32_sc16(input[i], scale_factor));
+    }
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), fc32, 1, sc16_item32_le, 1, PRIORITY_SIMD_AVX2){
+    convert_fc32_1_to_item32_1_avx2<false>(
+        reinterpret_cast<const fc32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), fc32, 1, sc16_item32_be, 1, PRIORITY_SIMD_AVX2){
+    convert_fc32_1_to_item32_1_avx2<true>(
+        reinterpret_cast<const fc32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+/***********************************************************************
+ * Convert sc16 item32 to complex float
+ **********************************************************************/
+template <bool wire_be> static AVX2_TARGET void convert_item32_1_to_fc32_1_avx2(
+    const item32_t *input, fc32_t *output, const size_t nsamps, const double scale_factor
+){
+    const __m256 scalar = _mm256_set1_ps(float(scale_factor));
+    const __m256i shuffle = broadcast_mask(wire_be? swap_bytes_mask() : swap_halves_mask());
+
+    size_t i = 0;
+    for (; i+8 <= nsamps; i+=8){
+        //load from input + swap to host
+        __m256i tmpi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input+i));
+        tmpi = _mm256_shuffle_epi8(tmpi, shuffle);
+
+        //sign extend each half
+        __m256i tmpilo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(tmpi));
+        __m256i tmpihi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(tmpi, 1));
+
+        //convert and scale
+        __m256 tmplo = _mm256_mul_ps(_mm256_cvtepi32_ps(tmpilo), scalar);
+        __m256 tmphi = _mm256_mul_ps(_mm256_cvtepi32_ps(tmpihi), scalar);
+
+        //store to output
+        _mm256_storeu_ps(reinterpret_cast<float *>(output+i+0), tmplo);
+        _mm256_storeu_ps(reinterpret_cast<float *>(output+i+4), tmphi);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        output[i] = item32_sc16_to_fc32(to_host<wire_be>(input[i]), scale_factor);
+    }
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc16_item32_le, 1, fc32, 1, PRIORITY_SIMD_AVX2){
+    convert_item32_1_to_fc32_1_avx2<false>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc16_item32_be, 1, fc32, 1, PRIORITY_SIMD_AVX2){
+    convert_item32_1_to_fc32_1_avx2<true>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+/***********************************************************************
+ * Convert between complex short and sc16 item32:
+ * This is a pure byte shuffle, and the same one in both directions.
+ **********************************************************************/
+template <bool wire_be> static AVX2_TARGET void convert_sc16_1_swap_item32_1_avx2(
+    const item32_t *input, item32_t *output, const size_t nsamps
+){
+    const __m256i shuffle = broadcast_mask(wire_be? swap_bytes_mask() : swap_halves_mask());
+
+    size_t i = 0;
+    for (; i+8 <= nsamps; i+=8){
+        __m256i tmpi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input+i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output+i), _mm256_shuffle_epi8(tmpi, shuffle));
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        const item32_t item = input[i];
+        output[i] = wire_be?
+            (((item & 0x00ff00ff) << 8) | ((item >> 8) & 0x00ff00ff)) :
+            ((item << 16) | (item >> 16));
+    }
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc16, 1, sc16_item32_le, 1, PRIORITY_SIMD_AVX2){
+    convert_sc16_1_swap_item32_1_avx2<false>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc16, 1, sc16_item32_be, 1, PRIORITY_SIMD_AVX2){
+    convert_sc16_1_swap_item32_1_avx2<true>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc16_item32_le, 1, sc16, 1, PRIORITY_SIMD_AVX2){
+    convert_sc16_1_swap_item32_1_avx2<false>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc16_item32_be, 1, sc16, 1, PRIORITY_SIMD_AVX2){
+    convert_sc16_1_swap_item32_1_avx2<true>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps
+    );
+}
+
+/***********************************************************************
+ * Convert sc8 item32 to complex float:
+ * The input may start on the upper half of an item (odd sample offset).
+ **********************************************************************/
+template <bool wire_be> static AVX2_TARGET void convert_sc8_item32_1_to_fc32_1_avx2(
+    const void *input_addr, fc32_t *output, const size_t nsamps, const double scale_factor
+){
+    const item32_t *input = reinterpret_cast<const item32_t *>(size_t(input_addr) & ~0x3);
+    const __m256 scalar = _mm256_set1_ps(float(scale_factor));
+    const __m128i shuffle = wire_be? swap_halves_mask() : swap_bytes_mask();
+    fc32_t dummy;
+    size_t num_samps = nsamps;
+
+    if ((size_t(input_addr) & 0x3) != 0){
+        const item32_t item0 = to_host<wire_be>(*input++);
+        item32_sc8_to_fc32(item0, dummy, *output++, scale_factor);
+        num_samps--;
+    }
+
+    const size_t num_pairs = num_samps/2;
+    size_t i = 0;
+    for (; i+4 <= num_pairs; i+=4){
+        //load 4 items (8 samples) from input + swap to host (real, imag) bytes
+        __m128i tmpi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input+i));
+        tmpi = _mm_shuffle_epi8(tmpi, shuffle);
+
+        //sign extend, convert, and scale
+        __m256 tmplo = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(tmpi)), scalar);
+        __m256 tmphi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(tmpi, 8))), scalar);
+
+        //store to output
+        _mm256_storeu_ps(reinterpret_cast<float *>(output+2*i+0), tmplo);
+        _mm256_storeu_ps(reinterpret_cast<float *>(output+2*i+4), tmphi);
+    }
+
+    //convert remainder
+    for (; i < num_pairs; i++){
+        item32_sc8_to_fc32(to_host<wire_be>(input[i]), output[2*i], output[2*i+1], scale_factor);
+    }
+
+    if (num_samps != num_pairs*2){
+        const item32_t item_n = to_host<wire_be>(input[num_pairs]);
+        item32_sc8_to_fc32(item_n, output[num_samps-1], dummy, scale_factor);
+    }
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc8_item32_le, 1, fc32, 1, PRIORITY_SIMD_AVX2){
+    convert_sc8_item32_1_to_fc32_1_avx2<false>(
+        inputs[0], reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx2(), sc8_item32_be, 1, fc32, 1, PRIORITY_SIMD_AVX2){
+    convert_sc8_item32_1_to_fc32_1_avx2<true>(
+        inputs[0], reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
@@ -0,0 +1,147 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "convert_common.hpp"
+#include "convert_cpuid.hpp"
+#include <uhd/utils/byteswap.hpp>
+#include <immintrin.h>
+
+using namespace uhd::convert;
+
+/***********************************************************************
+ * AVX-512BW kernels for the float <-> sc16 item32 conversions.
+ * Like the avx2 kernels, these are compiled with a function attribute
+ * and only registered when the processor supports avx512bw.
+ **********************************************************************/
+#define AVX512_TARGET __attribute__((target("avx512f,avx512bw")))
+
+/***********************************************************************
+ * Byte shuffles between host sc16 and the item32 wire formats
+ *  - le: swap the 16-bit halves of every item
+ *  - be: swap the bytes of every 16-bit half
+ **********************************************************************/
+template <bool wire_be> static AVX512_TARGET __m512i item32_sc16_shuffle(void){
+    //the same 16 byte pattern in every 128-bit lane, as little endian words
+    return wire_be?
+        _mm512_set4_epi32(0x0e0f0c0d, 0x0a0b0809, 0x06070405, 0x02030001) : //1, 0, 3, 2, ... 13, 12, 15, 14
+        _mm512_set4_epi32(0x0d0c0f0e, 0x09080b0a, 0x05040706, 0x01000302);  //2, 3, 0, 1, ... 14, 15, 12, 13
+}
+
+template <bool wire_be> static UHD_INLINE item32_t to_host(const item32_t item){
+    return wire_be? uhd::ntohx(item) : uhd::wtohx(item);
+}
+
+template <bool wire_be> static UHD_INLINE item32_t to_wire(const item32_t item){
+    return to_host<wire_be>(item); //symmetric
+}
+
+/***********************************************************************
+ * Convert complex float to sc16 item32
+ **********************************************************************/
+template <bool wire_be> static AVX512_TARGET void convert_fc32_1_to_item32_1_avx512(
+    const fc32_t *input, item32_t *output, const size_t nsamps, const double scale_factor
+){
+    const __m512 scalar = _mm512_set1_ps(float(scale_factor));
+    const __m512i shuffle = item32_sc16_shuffle<wire_be>();
+    const __m512i order = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+
+    size_t i = 0;
+    for (; i+16 <= nsamps; i+=16){
+        //load from input
+        __m512 tmplo = _mm512_loadu_ps(reinterpret_cast<const float *>(input+i+0));
+        __m512 tmphi = _mm512_loadu_ps(reinterpret_cast<const float *>(input+i+8));
+
+        //convert and scale
+        __m512i tmpilo = _mm512_cvtps_epi32(_mm512_mul_ps(tmplo, scalar));
+        __m512i tmpihi = _mm512_cvtps_epi32(_mm512_mul_ps(tmphi, scalar));
+
+        //pack (per 128-bit lane) + restore the sample order + swap to wire
+        __m512i tmpi = _mm512_packs_epi32(tmpilo, tmpihi);
+        tmpi = _mm512_permutexvar_epi64(order, tmpi);
+        tmpi = _mm512_shuffle_epi8(tmpi, shuffle);
+
+        //store to output
+        _mm512_storeu_si512(reinterpret_cast<void *>(output+i), tmpi);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        output[i] = to_wire<wire_be>(fc32_to_item32_sc16(input[i], scale_factor));
+    }
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx512bw(), fc32, 1, sc16_item32_le, 1, PRIORITY_SIMD_AVX512){
+    convert_fc32_1_to_item32_1_avx512<false>(
+        reinterpret_cast<const fc32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx512bw(), fc32, 1, sc16_item32_be, 1, PRIORITY_SIMD_AVX512){
+    convert_fc32_1_to_item32_1_avx512<true>(
+        reinterpret_cast<const fc32_t *>(inputs[0]),
+        reinterpret_cast<item32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+/***********************************************************************
+ * Convert sc16 item32 to complex float
+ **********************************************************************/
+template <bool wire_be> static AVX512_TARGET void convert_item32_1_to_fc32_1_avx512(
+    const item32_t *input, fc32_t *output, const size_t nsamps, const double scale_factor
+){
+    const __m512 scalar = _mm512_set1_ps(float(scale_factor));
+    const __m512i shuffle = item32_sc16_shuffle<wire_be>();
+
+    size_t i = 0;
+    for (; i+16 <= nsamps; i+=16){
+        //load from input + swap to host
+        __m512i tmpi = _mm512_loadu_si512(reinterpret_cast<const void *>(input+i));
+        tmpi = _mm512_shuffle_epi8(tmpi, shuffle);
+
+        //sign extend each half
+        __m512i tmpilo = _mm512_cvtepi16_epi32(_mm512_castsi512_si256(tmpi));
+        __m512i tmpihi = _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(tmpi, 1));
+
+        //convert and scale
+        __m512 tmplo = _mm512_mul_ps(_mm512_cvtepi32_ps(tmpilo), scalar);
+        __m512 tmphi = _mm512_mul_ps(_mm512_cvtepi32_ps(tmpihi), scalar);
+
+        //store to output
+        _mm512_storeu_ps(reinterpret_cast<float *>(output+i+0), tmplo);
+        _mm512_storeu_ps(reinterpret_cast<float *>(output+i+8), tmphi);
+    }
+
+    //convert remainder
+    for (; i < nsamps; i++){
+        output[i] = item32_sc16_to_fc32(to_host<wire_be>(input[i]), scale_factor);
+    }
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx512bw(), sc16_item32_le, 1, fc32, 1, PRIORITY_SIMD_AVX512){
+    convert_item32_1_to_fc32_1_avx512<false>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
+
+DECLARE_CONVERTER_IF(cpu_has_avx512bw(), sc16_item32_be, 1, fc32, 1, PRIORITY_SIMD_AVX512){
+    convert_item32_1_to_fc32_1_avx512<true>(
+        reinterpret_cast<const item32_t *>(inputs[0]),
+        reinterpret_cast<fc32_t *>(outputs[0]), nsamps, scale_factor
+    );
+}
@@ -20,6 +20,7 @@
 #include <boost/foreach.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/unordered_map.hpp>
 #include <iostream>
 
 using namespace uhd;
@@ -99,11 +100,13 @@ public:
         }
         if (parent == NULL) throw uhd::runtime_error("Cannot uproot");
         parent->pop(fs_path(path.leaf()));
+        _guts->index.clear(); //any indexed path may be under this one
     }
 
     bool exists(const fs_path &path_) const{
         const fs_path path = _root / path_;
         boost::mutex::scoped_lock lock(_guts->mutex);
+        if (_guts->index.count(path) != 0) return true;
 
         node_type *node = &_guts->root;
         BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
@@ -143,13 +146,17 @@ public:
         const fs_path path = _root / path_;
         boost::mutex::scoped_lock lock(_guts->mutex);
 
+        //fast path: this path string was resolved before
+        index_type::iterator it = _guts->index.find(path);
+        if (it != _guts->index.end()) return it->second;
+
         node_type *node = &_guts->root;
         BOOST_FOREACH(const std::string &name, path_tokenizer(path)){
             if (not node->has_key(name)) throw_path_not_found(path);
             node = &(*node)[name];
         }
         if (node->prop.get() == NULL) throw uhd::runtime_error("Cannot access! Property uninitialized at: " + path);
-        return node->prop;
+        return _guts->index[path] = node->prop;
     }
 
 private:
@@ -162,9 +169,14 @@ private:
         boost::shared_ptr<void> prop;
     };
 
+    //flat index of the full path strings that were accessed,
+    //the map keeps references valid across inserts and rehashes
+    typedef boost::unordered_map<std::string, boost::shared_ptr<void> > index_type;
+
     //tree guts which may be referenced in a subtree
     struct tree_guts_type{
         node_type root;
+        index_type index;
         boost::mutex mutex;
     };
 
@@ -0,0 +1,63 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/stream.hpp>
+#include <uhd/exception.hpp>
+
+using namespace uhd;
+
+/***********************************************************************
+ * RX streamer zero-copy view
+ **********************************************************************/
+rx_streamer::recv_view_type::recv_view_type(void):
+    nsamps_per_buff(0)
+{
+    /* NOP */
+}
+
+void rx_streamer::recv_view_type::release(void){
+    buffs.clear();
+    nsamps_per_buff = 0;
+    leases.clear(); //effectively a release of every buffer
+}
+
+size_t rx_streamer::recv_view(recv_view_type &, rx_metadata_t &, const double){
+    throw uhd::not_implemented_error("this rx streamer cannot lend its transport buffers");
+}
+
+/***********************************************************************
+ * TX streamer zero-copy view
+ **********************************************************************/
+tx_streamer::send_view_type::send_view_type(void):
+    nsamps_per_buff(0), has_time_spec(false)
+{
+    /* NOP */
+}
+
+void tx_streamer::send_view_type::release(void){
+    buffs.clear();
+    nsamps_per_buff = 0;
+    leases.clear(); //dropped without a commit
+}
+
+size_t tx_streamer::get_send_view(send_view_type &, const bool, const double){
+    throw uhd::not_implemented_error("this tx streamer cannot lend its transport buffers");
+}
+
+size_t tx_streamer::commit_send_view(send_view_type &, const size_t, const tx_metadata_t &){
+    throw uhd::not_implemented_error("this tx streamer cannot lend its transport buffers");
+}
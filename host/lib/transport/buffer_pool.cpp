@@ -16,9 +16,21 @@
 //
 
 #include <uhd/transport/buffer_pool.hpp>
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/log.hpp>
+#include <uhd/exception.hpp>
 #include <boost/shared_array.hpp>
+#include <boost/format.hpp>
+#include <cstring>
 #include <vector>
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif /*HAVE_MMAP*/
+
 using namespace uhd::transport;
 
 //! pad the byte count to a multiple of alignment
@@ -51,6 +63,26 @@ private:
     boost::shared_array<char> _mem;
 };
 
+//! carve the memory into boundary-aligned buffers of padded size
+static buffer_pool::sptr make_pool(
+    boost::shared_array<char> mem,
+    const size_t num_buffs,
+    const size_t padded_buff_size,
+    const size_t alignment
+){
+    //Fill a vector with boundary-aligned points in the memory
+    const size_t mem_start = pad_to_boundary(size_t(mem.get()), alignment);
+    std::vector<buffer_pool::ptr_type> ptrs(num_buffs);
+    for (size_t i = 0; i < num_buffs; i++){
+        ptrs[i] = buffer_pool::ptr_type(mem_start + padded_buff_size*i);
+    }
+
+    //Create a new buffer pool implementation with:
+    // - the pre-computed pointers, and
+    // - the reference to allocated memory.
+    return buffer_pool::sptr(new buffer_pool_impl(ptrs, mem));
+}
+
 /***********************************************************************
  * Buffer pool factor function
  **********************************************************************/
@@ -64,17 +96,114 @@ buffer_pool::sptr buffer_pool::make(
     //3) allocate the memory in one block of sufficient size
     const size_t padded_buff_size = pad_to_boundary(buff_size, alignment);
     boost::shared_array<char> mem(new char[padded_buff_size*num_buffs + alignment-1]);
+    return make_pool(mem, num_buffs, padded_buff_size, alignment);
+}
 
-    //Fill a vector with boundary-aligned points in the memory
-    const size_t mem_start = pad_to_boundary(size_t(mem.get()), alignment);
-    std::vector<ptr_type> ptrs(num_buffs);
-    for (size_t i = 0; i < num_buffs; i++){
-        ptrs[i] = ptr_type(mem_start + padded_buff_size*i);
+/***********************************************************************
+ * Mapped memory allocation:
+ * Huge pages cut the TLB misses when thousands of frames are allocated.
+ * The pages are placed and faulted in here, so the NUMA policy applies
+ * and the first packets do not pay for page faults.
+ **********************************************************************/
+#ifdef HAVE_MMAP
+static const size_t HUGE_PAGE_SIZE = 2*1024*1024;
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+struct munmap_deleter{
+    munmap_deleter(const size_t len): len(len){}
+    void operator()(char *mem) const{::munmap(mem, len);}
+    size_t len;
+};
+
+static char *map_anonymous(const size_t len, const int flags){
+    void *mem = ::mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return (mem == MAP_FAILED)? NULL : static_cast<char *>(mem);
+}
+
+static boost::shared_array<char> make_mapped_mem(
+    size_t len, const bool hugepages, const int numa_node, const bool lock
+){
+    char *mem = NULL;
+
+    if (hugepages){
+        len = pad_to_boundary(len, HUGE_PAGE_SIZE);
+        #ifdef MAP_HUGETLB
+        mem = map_anonymous(len, MAP_HUGETLB);
+        if (mem == NULL) UHD_LOG << "buffer_pool: MAP_HUGETLB failed, trying transparent huge pages" << std::endl;
+        #endif /*MAP_HUGETLB*/
     }
 
-    //Create a new buffer pool implementation with:
-    // - the pre-computed pointers, and
-    // - the reference to allocated memory.
-    return sptr(new buffer_pool_impl(ptrs, mem));
+    if (mem == NULL){
+        mem = map_anonymous(len, 0);
+        if (mem == NULL) throw uhd::os_error(str(boost::format(
+            "buffer_pool: failed to map %d bytes (errno %d)") % len % errno
+        ));
+        #ifdef MADV_HUGEPAGE
+        if (hugepages and ::madvise(mem, len, MADV_HUGEPAGE) != 0) UHD_MSG(warning) << boost::format(
+            "buffer_pool: huge pages are not available (errno %d).\n"
+            "Reserve them with /proc/sys/vm/nr_hugepages or enable transparent huge pages.\n"
+        ) % errno;
+        #else
+        if (hugepages) UHD_MSG(warning) << "buffer_pool: huge pages are not supported on this platform." << std::endl;
+        #endif /*MADV_HUGEPAGE*/
+    }
+    boost::shared_array<char> mem_sptr(mem, munmap_deleter(len));
+
+    if (numa_node >= 0){
+        #ifdef SYS_mbind
+        const unsigned long nodemask = 1ul << numa_node;
+        if (numa_node >= int(sizeof(nodemask)*8) or ::syscall(
+            SYS_mbind, mem, len, MPOL_PREFERRED, &nodemask, sizeof(nodemask)*8, 0
+        ) != 0) UHD_MSG(warning) << boost::format(
+            "buffer_pool: failed to place buffers on NUMA node %d (errno %d).\n"
+        ) % numa_node % errno;
+        #else
+        UHD_MSG(warning) << "buffer_pool: NUMA placement is not supported on this platform." << std::endl;
+        #endif /*SYS_mbind*/
+    }
+
+    //touch every page so it is allocated now under the policy above
+    std::memset(mem, 0, len);
+
+    if (lock and ::mlock(mem, len) != 0) UHD_MSG(warning) << boost::format(
+        "buffer_pool: failed to lock %d bytes into memory (errno %d).\n"
+        "Raise the memlock limit (ulimit -l) to lock the buffers.\n"
+    ) % len % errno;
+
+    return mem_sptr;
 }
+#endif /*HAVE_MMAP*/
 
+buffer_pool::sptr buffer_pool::make(
+    const size_t num_buffs,
+    const size_t buff_size,
+    const device_addr_t &hints
+){
+    const size_t alignment = hints.cast<size_t>("buff_alignment", 16);
+    const bool hugepages = hints.cast<int>("buff_hugepages", 0) != 0;
+    const int numa_node = hints.cast<int>("buff_numa_node", -1);
+    const bool lock = hints.cast<int>("buff_mlock", 0) != 0;
+    if (alignment == 0) throw uhd::value_error("buffer_pool: buff_alignment must be non-zero");
+
+    //the plain allocation unless mapped memory was requested
+    if (not hugepages and numa_node < 0 and not lock){
+        return make(num_buffs, buff_size, alignment);
+    }
+
+    #ifdef HAVE_MMAP
+    //mappings are page aligned, only pad for larger alignments
+    const size_t padded_buff_size = pad_to_boundary(buff_size, alignment);
+    const size_t page_size = size_t(::sysconf(_SC_PAGESIZE));
+    const size_t len = padded_buff_size*num_buffs + ((alignment > page_size)? alignment-1 : 0);
+    UHD_LOG << boost::format(
+        "buffer_pool: mapping %d x %d bytes (hugepages %d, numa node %d, mlock %d)"
+    ) % num_buffs % padded_buff_size % hugepages % numa_node % lock << std::endl;
+    return make_pool(make_mapped_mem(len, hugepages, numa_node, lock), num_buffs, padded_buff_size, alignment);
+    #else
+    UHD_MSG(warning) << "buffer_pool: huge pages, NUMA placement, and mlock are not supported on this platform." << std::endl;
+    return make(num_buffs, buff_size, alignment);
+    #endif /*HAVE_MMAP*/
+}
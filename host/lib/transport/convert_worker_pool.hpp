@@ -0,0 +1,141 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_CONVERT_WORKER_POOL_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_CONVERT_WORKER_POOL_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/bind.hpp>
+
+namespace uhd{ namespace transport{ namespace sph{
+
+/***********************************************************************
+ * Convert worker pool
+ *
+ * A small set of persistent threads that run a fixed set of tasks
+ * (one per channel) in parallel with the calling thread.
+ * Task i runs on thread i % (num_threads + 1), where thread 0 is
+ * the caller; run() returns once every task has completed.
+ **********************************************************************/
+class convert_worker_pool : boost::noncopyable{
+public:
+    typedef boost::function<void(size_t)> task_type;
+
+    /*!
+     * Make a new worker pool and spawn the worker threads.
+     * \param task the task function, called with the task index
+     * \param num_tasks the number of tasks to run per call to run()
+     * \param num_threads the number of threads in addition to the caller
+     */
+    convert_worker_pool(const task_type &task, const size_t num_tasks, const size_t num_threads):
+        _task(task), _num_tasks(num_tasks), _num_threads(num_threads), _generation_done(0)
+    {
+        for (size_t i = 0; i < _num_threads; i++){
+            _thread_group.create_thread(boost::bind(&convert_worker_pool::worker_loop, this, i+1));
+        }
+    }
+
+    ~convert_worker_pool(void){
+        _exit.write(1);
+        this->wake_workers();
+        _thread_group.join_all();
+    }
+
+    //! Run all tasks across the pool, return when they are complete
+    UHD_INLINE void run(void){
+        this->wake_workers();
+
+        //the caller takes its share of the tasks
+        this->run_tasks(0);
+
+        //wait on the workers: spin a little, then yield the processor
+        _generation_done += _num_threads;
+        for (size_t i = 0; _num_done.read() != _generation_done; i++){
+            if (i >= SPIN_COUNT) boost::this_thread::yield();
+        }
+    }
+
+private:
+    //poll this many times before blocking/yielding
+    static const size_t SPIN_COUNT = 1000;
+
+    const task_type _task;
+    const size_t _num_tasks;
+    const size_t _num_threads;
+    boost::uint32_t _generation_done; //only touched by the caller
+    boost::thread_group _thread_group;
+
+    atomic_uint32_t _generation; //incremented by the caller for each run
+    atomic_uint32_t _num_done; //incremented by a worker for each run
+    atomic_uint32_t _num_sleeping;
+    atomic_uint32_t _exit;
+    boost::mutex _mutex;
+    boost::condition _cond;
+
+    UHD_INLINE void run_tasks(const size_t thread_index){
+        for (size_t i = thread_index; i < _num_tasks; i += _num_threads+1){
+            _task(i);
+        }
+    }
+
+    /*!
+     * Start a new generation (full barrier), then notify any sleepers.
+     * The workers increment the sleeping count (full barrier)
+     * before re-checking the generation under the mutex,
+     * so either they see the new generation or we see them sleeping.
+     */
+    UHD_INLINE void wake_workers(void){
+        _generation.inc();
+        if (_num_sleeping.read() == 0) return;
+        boost::mutex::scoped_lock lock(_mutex);
+        _cond.notify_all();
+    }
+
+    void worker_loop(const size_t thread_index){
+        boost::uint32_t last_generation = 0; //the initial generation
+        while (true){
+            this->wait_for_generation(last_generation);
+            last_generation = _generation.read();
+            if (_exit.read() != 0) return;
+            this->run_tasks(thread_index);
+            _num_done.inc();
+        }
+    }
+
+    void wait_for_generation(const boost::uint32_t last_generation){
+        for (size_t i = 0; i < SPIN_COUNT; i++){
+            if (_generation.read() != last_generation) return;
+        }
+
+        boost::mutex::scoped_lock lock(_mutex);
+        _num_sleeping.inc();
+        while (_generation.read() == last_generation){
+            _cond.wait(lock);
+        }
+        _num_sleeping.dec();
+    }
+};
+
+}}} //namespace
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_CONVERT_WORKER_POOL_HPP */
@@ -170,8 +170,8 @@ public:
         _num_recv_frames(size_t(hints.cast<double>("num_recv_frames", DEFAULT_NUM_XFERS))),
         _send_frame_size(size_t(hints.cast<double>("send_frame_size", DEFAULT_XFER_SIZE))),
         _num_send_frames(size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_XFERS))),
-        _recv_buffer_pool(buffer_pool::make(_num_recv_frames, _recv_frame_size)),
-        _send_buffer_pool(buffer_pool::make(_num_send_frames, _send_frame_size)),
+        _recv_buffer_pool(buffer_pool::make(_num_recv_frames, _recv_frame_size, hints)),
+        _send_buffer_pool(buffer_pool::make(_num_send_frames, _send_frame_size, hints)),
         _next_recv_buff_index(0),
         _next_send_buff_index(0)
     {
@@ -25,9 +25,15 @@
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include <uhd/transport/zero_copy.hpp>
+#include "convert_worker_pool.hpp"
+#include "tick_time.hpp"
 #include <boost/dynamic_bitset.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
 #include <boost/format.hpp>
@@ -67,7 +73,10 @@ public:
      */
     recv_packet_handler(const size_t size = 1):
         _queue_error_for_next_call(false),
-        _buffers_infos_index(0)
+        _buffers_infos_index(0),
+        _num_convert_threads(0),
+        _stats_tick(0),
+        _stats_sample_now(false)
     {
         this->resize(size);
         set_alignment_failure_threshold(1000);
@@ -77,8 +86,10 @@ public:
     void resize(const size_t size){
         if (this->size() == size) return;
         _props.resize(size);
+        _stats.seq_errors.resize(size, 0);
         //re-initialize all buffers infos by re-creating the vector
         _buffers_infos = std::vector<buffers_info_type>(4, buffers_info_type(size));
+        this->set_convert_threads(_num_convert_threads);
     }
 
     //! Get the channel width of this handler
@@ -103,12 +114,12 @@ public:
 
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
-        _tick_rate = rate;
+        _clock.set_tick_rate(rate);
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
-        _samp_rate = rate;
+        _clock.set_samp_rate(rate);
     }
 
     /*!
@@ -125,11 +136,38 @@ public:
 
     //! Set the conversion routine for all channels
     void set_converter(const uhd::convert::id_type &id){
+        _converter_id = id;
         _io_buffs.resize(id.num_outputs);
         _converter = uhd::convert::get_converter(id)();
-        this->set_scale_factor(1/32767.); //update after setting converter
         _bytes_per_otw_item = uhd::convert::get_bytes_per_item(id.input_format);
         _bytes_per_cpu_item = uhd::convert::get_bytes_per_item(id.output_format);
+        this->set_convert_threads(_num_convert_threads);
+        this->set_scale_factor(1/32767.); //update after setting converter
+    }
+
+    /*!
+     * Copy-convert the channels in parallel on a pool of worker threads.
+     * The calling thread converts its share of the channels,
+     * and recv() returns only once all channels are converted.
+     * Each channel gets its own converter instance.
+     * \param num_threads the number of worker threads (0 to disable)
+     */
+    void set_convert_threads(const size_t num_threads){
+        _num_convert_threads = num_threads;
+        _convert_pool.reset();
+        _conv_converters.clear();
+        _conv_io_buffs.clear();
+        if (num_threads == 0 or this->size() < 2 or not _converter) return;
+
+        for (size_t i = 0; i < this->size(); i++){
+            _conv_converters.push_back((i == 0)? _converter : uhd::convert::get_converter(_converter_id)());
+            _conv_converters.back()->set_scalar(_scale_factor);
+        }
+        _conv_io_buffs.resize(this->size(), _io_buffs);
+        _convert_pool.reset(new convert_worker_pool(
+            boost::bind(&recv_packet_handler::convert_channel, this, _1),
+            this->size(), std::min(num_threads, this->size()-1)
+        ));
     }
 
     //! Set the transport channel's overflow handler
@@ -139,7 +177,11 @@ public:
 
     //! Set the scale factor used in float conversion
     void set_scale_factor(const double scale_factor){
+        _scale_factor = scale_factor;
         _converter->set_scalar(scale_factor);
+        BOOST_FOREACH(uhd::convert::converter::sptr &converter, _conv_converters){
+            converter->set_scalar(scale_factor);
+        }
     }
 
     /*******************************************************************
@@ -189,11 +231,72 @@ public:
         return accum_num_samps;
     }
 
+    /*!
+     * Get a snapshot of the fast path stats.
+     * The snapshot is taken without locking while the streamer runs,
+     * so a counter may be off by the packet being handled at that time.
+     */
+    uhd::rx_stream_stats_t get_stats(void) const{
+        return _stats;
+    }
+
+    /*******************************************************************
+     * Receive view:
+     * The entry point for the zero-copy receive calls.
+     * Hand the aligned transport buffers of one packet to the caller
+     * rather than copy-converting them into the caller's buffers.
+     ******************************************************************/
+    UHD_INLINE size_t recv_view(
+        uhd::rx_streamer::recv_view_type &view,
+        uhd::rx_metadata_t &metadata,
+        const double timeout
+    ){
+        view.release();
+
+        //the payload interleaves channels when a converter has many outputs
+        if (_io_buffs.size() != 1) throw uhd::not_implemented_error(
+            "recv view: cannot lend a transport buffer shared by several channels"
+        );
+
+        //handle metadata queued from a previous receive
+        if (_queue_error_for_next_call){
+            _queue_error_for_next_call = false;
+            metadata = _queue_metadata;
+            if (_queue_metadata.error_code != rx_metadata_t::ERROR_CODE_TIMEOUT) return 0;
+        }
+
+        this->get_next_buffs_if_expired(timeout);
+
+        buffers_info_type &info = get_curr_buffer_info();
+        metadata = info.metadata;
+
+        //interpolate the time spec (useful when this is a fragment)
+        metadata.time_spec = _clock.to_time_spec(info.time, info.fragment_offset_in_samps);
+        metadata.more_fragments = false;
+        metadata.fragment_offset = info.fragment_offset_in_samps;
+
+        //the view takes over the buffers along with the remaining samples
+        const size_t nsamps = info.data_bytes_to_copy/_bytes_per_otw_item;
+        BOOST_FOREACH(per_buffer_info_type &buff_info, info){
+            if (nsamps != 0){
+                view.buffs.push_back(buff_info.copy_buff);
+                view.leases.push_back(managed_recv_buffer::sptr());
+                view.leases.back().swap(buff_info.buff);
+            }
+            buff_info.buff.reset(); //effectively a release
+        }
+        view.nsamps_per_buff = nsamps;
+        info.data_bytes_to_copy = 0;
+        info.fragment_offset_in_samps += nsamps;
+
+        return nsamps;
+    }
+
 private:
 
     vrt_unpacker_type _vrt_unpacker;
     size_t _header_offset_words32;
-    double _tick_rate, _samp_rate;
+    tick_clock _clock;
     bool _queue_error_for_next_call;
     size_t _alignment_faulure_threshold;
     rx_metadata_t _queue_metadata;
@@ -211,13 +314,15 @@ private:
     size_t _bytes_per_otw_item; //used in conversion
     size_t _bytes_per_cpu_item; //used in conversion
     uhd::convert::converter::sptr _converter; //used in conversion
+    uhd::convert::id_type _converter_id;
+    double _scale_factor;
 
     //! information stored for a received buffer
     struct per_buffer_info_type{
         managed_recv_buffer::sptr buff;
         const boost::uint32_t *vrt_hdr;
         vrt::if_packet_info_t ifpi;
-        time_spec_t time;
+        tick_time_type time;
         const char *copy_buff;
     };
 
@@ -231,10 +336,11 @@ private:
             fragment_offset_in_samps(0)
         {/* NOP */}
         boost::dynamic_bitset<> indexes_todo; //used in alignment logic
-        time_spec_t alignment_time; //used in alignment logic
+        tick_time_type alignment_time; //used in alignment logic
         bool alignment_time_valid; //used in alignment logic
         size_t data_bytes_to_copy; //keeps track of state
         size_t fragment_offset_in_samps; //keeps track of state
+        tick_time_type time; //packet time, converted into the metadata on return
         rx_metadata_t metadata; //packet description
     };
 
@@ -246,6 +352,24 @@ private:
     buffers_info_type &get_next_buffer_info(void){return _buffers_infos[(_buffers_infos_index + 1)%4];}
     void increment_buffer_info(void){_buffers_infos_index = (_buffers_infos_index + 1)%4;}
 
+    //! state for the parallel conversion, one entry per channel
+    size_t _num_convert_threads;
+    std::vector<uhd::convert::converter::sptr> _conv_converters;
+    std::vector<std::vector<void *> > _conv_io_buffs;
+    const buffers_info_type *_conv_info;
+    size_t _conv_nsamps;
+    boost::scoped_ptr<convert_worker_pool> _convert_pool;
+
+    //! fast path stats, durations are sampled on 1 in 16 aligned sets
+    uhd::rx_stream_stats_t _stats;
+    size_t _stats_tick;
+    bool _stats_sample_now;
+
+    //! the nanoseconds since the start time, for the stats
+    static UHD_INLINE boost::uint64_t elapsed_ns(const time_spec_t &start){
+        return boost::uint64_t((time_spec_t::get_system_time() - start).get_real_secs()*1e9);
+    }
+
     //! possible return options for the packet receiver
     enum packet_type{
         PACKET_IF_DATA,
@@ -269,7 +393,12 @@ private:
     ){
         //get a single packet from the transport layer
         managed_recv_buffer::sptr &buff = curr_buffer_info[index].buff;
-        buff = _props[index].get_buff(timeout);
+        if (_stats_sample_now){
+            const time_spec_t start = time_spec_t::get_system_time();
+            buff = _props[index].get_buff(timeout);
+            _stats.get_buff_ns.add(elapsed_ns(start));
+        }
+        else buff = _props[index].get_buff(timeout);
         if (buff.get() == NULL) return PACKET_TIMEOUT_ERROR;
 
         //bounds check before extract
@@ -283,7 +412,7 @@ private:
         info.ifpi.num_packet_words32 = num_packet_words32 - _header_offset_words32;
         info.vrt_hdr = buff->cast<const boost::uint32_t *>() + _header_offset_words32;
         _vrt_unpacker(info.vrt_hdr, info.ifpi);
-        info.time = time_spec_t(time_t(info.ifpi.tsi), size_t(info.ifpi.tsf), _tick_rate); //assumes has_tsi and has_tsf are true
+        info.time = _clock.from_packet(info.ifpi.tsi, info.ifpi.tsf); //assumes has_tsi and has_tsf are true
         info.copy_buff = reinterpret_cast<const char *>(info.vrt_hdr + info.ifpi.num_header_words32);
 
         //--------------------------------------------------------------
@@ -361,6 +490,7 @@ private:
         // - Handle the packet type yielded by the receive.
         // - Check the timestamps for alignment conditions.
         size_t iterations = 0;
+        _stats_sample_now = (_stats_tick++ & 0xf) == 0;
         while (curr_info.indexes_todo.any()){
 
             //get the index to process for this iteration
@@ -381,7 +511,7 @@ private:
                 ) % e.what() << std::endl;
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = false;
-                curr_info.metadata.time_spec = time_spec_t(0.0);
+                curr_info.time = tick_time_type();
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
@@ -409,13 +539,14 @@ private:
             case PACKET_INLINE_MESSAGE:
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = next_info[index].ifpi.has_tsi and next_info[index].ifpi.has_tsf;
-                curr_info.metadata.time_spec = next_info[index].time;
+                curr_info.time = next_info[index].time;
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
                 curr_info.metadata.end_of_burst = false;
                 curr_info.metadata.error_code = rx_metadata_t::error_code_t(get_context_code(next_info[index].vrt_hdr, next_info[index].ifpi));
                 if (curr_info.metadata.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW){
+                    _stats.num_overflows++;
                     _props[index].handle_overflow();
                     UHD_MSG(fastpath) << "O";
                 }
@@ -424,20 +555,22 @@ private:
             case PACKET_TIMEOUT_ERROR:
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = false;
-                curr_info.metadata.time_spec = time_spec_t(0.0);
+                curr_info.time = tick_time_type();
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
                 curr_info.metadata.end_of_burst = false;
                 curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_TIMEOUT;
+                _stats.num_timeouts++;
                 return;
 
             case PACKET_SEQUENCE_ERROR:
+                _stats.seq_errors[index]++;
                 alignment_check(index, curr_info);
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = prev_info.metadata.has_time_spec;
-                curr_info.metadata.time_spec = prev_info.metadata.time_spec + time_spec_t(0,
-                    prev_info[index].ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_otw_item, _samp_rate);
+                curr_info.time = _clock.add_samps(prev_info.time,
+                    prev_info[index].ifpi.num_payload_words32*sizeof(boost::uint32_t)/_bytes_per_otw_item);
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
@@ -457,7 +590,7 @@ private:
                 ) % iterations << std::endl;
                 std::swap(curr_info, next_info); //save progress from curr -> next
                 curr_info.metadata.has_time_spec = false;
-                curr_info.metadata.time_spec = time_spec_t(0.0);
+                curr_info.time = tick_time_type();
                 curr_info.metadata.more_fragments = false;
                 curr_info.metadata.fragment_offset = 0;
                 curr_info.metadata.start_of_burst = false;
@@ -470,13 +603,59 @@ private:
 
         //set the metadata from the buffer information at index zero
         curr_info.metadata.has_time_spec = curr_info[0].ifpi.has_tsi and curr_info[0].ifpi.has_tsf;
-        curr_info.metadata.time_spec = curr_info[0].time;
+        curr_info.time = curr_info[0].time;
         curr_info.metadata.more_fragments = false;
         curr_info.metadata.fragment_offset = 0;
         curr_info.metadata.start_of_burst = curr_info[0].ifpi.sob;
         curr_info.metadata.end_of_burst = curr_info[0].ifpi.eob;
         curr_info.metadata.error_code = rx_metadata_t::ERROR_CODE_NONE;
 
+        //count the aligned packets
+        _stats.align_iterations.add(iterations);
+        _stats.num_packets += curr_info.size();
+        BOOST_FOREACH(const per_buffer_info_type &buff_info, curr_info){
+            _stats.num_bytes += buff_info.ifpi.num_payload_bytes;
+        }
+    }
+
+    /*******************************************************************
+     * Parallel copy-convert:
+     * Fill the io buffer pointers for every channel on the caller's thread,
+     * then convert each channel with its own converter on the worker pool.
+     ******************************************************************/
+    UHD_INLINE void convert_parallel(
+        const buffers_info_type &info,
+        const uhd::rx_streamer::buffs_type &buffs,
+        const size_t buffer_offset_bytes,
+        const size_t nsamps_per_io_buff
+    ){
+        size_t buff_index = 0;
+        for (size_t i = 0; i < info.size(); i++){
+            BOOST_FOREACH(void *&io_buff, _conv_io_buffs[i]){
+                io_buff = reinterpret_cast<char *>(buffs[buff_index++]) + buffer_offset_bytes;
+            }
+        }
+        _conv_info = &info;
+        _conv_nsamps = nsamps_per_io_buff;
+        _convert_pool->run();
+    }
+
+    //! Copy-convert one channel, called from the worker pool
+    void convert_channel(const size_t index){
+        _conv_converters[index]->conv((*_conv_info)[index].copy_buff, _conv_io_buffs[index], _conv_nsamps);
+    }
+
+    //! Get the next aligned buffers if the current ones have expired
+    UHD_INLINE void get_next_buffs_if_expired(const double timeout){
+        if (get_curr_buffer_info().data_bytes_to_copy != 0) return;
+
+        //reset current buffer info members for reuse
+        get_curr_buffer_info().fragment_offset_in_samps = 0;
+        get_curr_buffer_info().alignment_time_valid = false;
+        get_curr_buffer_info().indexes_todo.set();
+
+        //perform receive with alignment logic
+        get_aligned_buffs(timeout);
     }
 
     /*******************************************************************
@@ -492,23 +671,13 @@ private:
         const double timeout,
         const size_t buffer_offset_bytes = 0
     ){
-        //get the next buffer if the current one has expired
-        if (get_curr_buffer_info().data_bytes_to_copy == 0){
-
-            //reset current buffer info members for reuse
-            get_curr_buffer_info().fragment_offset_in_samps = 0;
-            get_curr_buffer_info().alignment_time_valid = false;
-            get_curr_buffer_info().indexes_todo.set();
-
-            //perform receive with alignment logic
-            get_aligned_buffs(timeout);
-        }
+        this->get_next_buffs_if_expired(timeout);
 
         buffers_info_type &info = get_curr_buffer_info();
         metadata = info.metadata;
 
         //interpolate the time spec (useful when this is a fragment)
-        metadata.time_spec += time_spec_t(0, info.fragment_offset_in_samps, _samp_rate);
+        metadata.time_spec = _clock.to_time_spec(info.time, info.fragment_offset_in_samps);
 
         //extract the number of samples available to copy
         const size_t nsamps_available = info.data_bytes_to_copy/_bytes_per_otw_item;
@@ -516,20 +685,33 @@ private:
         const size_t bytes_to_copy = nsamps_to_copy*_bytes_per_otw_item;
         const size_t nsamps_to_copy_per_io_buff = nsamps_to_copy/_io_buffs.size();
 
-        size_t buff_index = 0;
-        BOOST_FOREACH(per_buffer_info_type &buff_info, info){
+        const time_spec_t convert_start = (_stats_sample_now)? time_spec_t::get_system_time() : time_spec_t(0.0);
+        if (_convert_pool){
+            //copy-convert the channels across the worker pool
+            this->convert_parallel(info, buffs, buffer_offset_bytes, nsamps_to_copy_per_io_buff);
+        }
+        else{
+            size_t buff_index = 0;
+            BOOST_FOREACH(per_buffer_info_type &buff_info, info){
 
-            //fill a vector with pointers to the io buffers
-            BOOST_FOREACH(void *&io_buff, _io_buffs){
-                io_buff = reinterpret_cast<char *>(buffs[buff_index++]) + buffer_offset_bytes;
-            }
+                //fill a vector with pointers to the io buffers
+                BOOST_FOREACH(void *&io_buff, _io_buffs){
+                    io_buff = reinterpret_cast<char *>(buffs[buff_index++]) + buffer_offset_bytes;
+                }
 
-            //copy-convert the samples from the recv buffer
-            _converter->conv(buff_info.copy_buff, _io_buffs, nsamps_to_copy_per_io_buff);
+                //copy-convert the samples from the recv buffer
+                _converter->conv(buff_info.copy_buff, _io_buffs, nsamps_to_copy_per_io_buff);
+            }
+        }
+        if (_stats_sample_now and nsamps_to_copy != 0){
+            _stats.convert_ns.add(elapsed_ns(convert_start));
+        }
 
-            //update the rx copy buffer to reflect the bytes copied
+        //update the rx copy buffers to reflect the bytes copied
+        BOOST_FOREACH(per_buffer_info_type &buff_info, info){
             buff_info.copy_buff += bytes_to_copy;
         }
+
         //update the copy buffer's availability
         info.data_bytes_to_copy -= bytes_to_copy;
 
@@ -573,6 +755,14 @@ public:
         return recv_packet_handler::recv(buffs, nsamps_per_buff, metadata, timeout, one_packet);
     }
 
+    size_t recv_view(
+        rx_streamer::recv_view_type &view,
+        uhd::rx_metadata_t &metadata,
+        const double timeout
+    ){
+        return recv_packet_handler::recv_view(view, metadata, timeout);
+    }
+
 private:
     size_t _max_num_samps;
 };
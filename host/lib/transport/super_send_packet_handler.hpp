@@ -25,12 +25,16 @@
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/metadata.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/transport/vrt_if_packet.hpp>
 #include <uhd/transport/zero_copy.hpp>
+#include "tick_time.hpp"
 #include <boost/thread/thread_time.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
 #include <iostream>
+#include <cstring>
 #include <vector>
 
 namespace uhd{ namespace transport{ namespace sph{
@@ -45,6 +49,8 @@ namespace uhd{ namespace transport{ namespace sph{
 class send_packet_handler{
 public:
     typedef boost::function<managed_send_buffer::sptr(double)> get_buff_type;
+    typedef boost::function<void(void)> flush_type;
+    typedef boost::function<void(managed_send_buffer &, size_t)> commit_type;
     typedef void(*vrt_packer_type)(boost::uint32_t *, vrt::if_packet_info_t &);
     //typedef boost::function<void(boost::uint32_t *, vrt::if_packet_info_t &)> vrt_packer_type;
 
@@ -53,7 +59,8 @@ public:
      * \param size the number of transport channels
      */
     send_packet_handler(const size_t size = 1):
-        _next_packet_seq(0)
+        _next_packet_seq(0),
+        _stats_tick(0)
     {
         this->resize(size);
     }
@@ -79,12 +86,12 @@ public:
 
     //! Set the rate of ticks per second
     void set_tick_rate(const double rate){
-        _tick_rate = rate;
+        _clock.set_tick_rate(rate);
     }
 
     //! Set the rate of samples per second
     void set_samp_rate(const double rate){
-        _samp_rate = rate;
+        _clock.set_samp_rate(rate);
     }
 
     /*!
@@ -96,6 +103,27 @@ public:
         _props.at(xport_chan).get_buff = get_buff;
     }
 
+    /*!
+     * Set the function to flush committed buffers.
+     * Called before send() returns, for transports that defer commits.
+     * \param xport_chan which transport channel
+     * \param flush the flush function
+     */
+    void set_xport_chan_flush(const size_t xport_chan, const flush_type &flush){
+        _props.at(xport_chan).flush = flush;
+    }
+
+    /*!
+     * Set the function to commit a filled buffer.
+     * Called in place of commit() on buffers that carry a packet,
+     * for devices that stamp each sent frame (ex: flow control).
+     * \param xport_chan which transport channel
+     * \param commit the commit function
+     */
+    void set_xport_chan_commit(const size_t xport_chan, const commit_type &commit){
+        _props.at(xport_chan).commit = commit;
+    }
+
     //! Set the conversion routine for all channels
     void set_converter(const uhd::convert::id_type &id){
         _io_buffs.resize(id.num_inputs);
@@ -122,7 +150,7 @@ public:
     /*******************************************************************
      * Send:
      * The entry point for the fast-path send calls.
-     * Dispatch into combinations of single packet send calls.
+     * Send the packets, then flush deferred commits.
      ******************************************************************/
     UHD_INLINE size_t send(
         const uhd::tx_streamer::buffs_type &buffs,
@@ -130,17 +158,182 @@ public:
         const uhd::tx_metadata_t &metadata,
         const double timeout
     ){
-        //translate the metadata to vrt if packet info
+        const size_t num_samps_sent = send_packets(buffs, nsamps_per_buff, metadata, timeout);
+
+        //flush any deferred commits before returning to the caller
+        BOOST_FOREACH(xport_chan_props_type &props, _props){
+            if (props.flush) props.flush();
+        }
+        return num_samps_sent;
+    }
+
+    /*!
+     * Get a snapshot of the fast path stats.
+     * The snapshot is taken without locking while the streamer runs,
+     * so a counter may be off by the packet being handled at that time.
+     * The flow control wait is filled in by the device that owns the monitor.
+     */
+    uhd::tx_stream_stats_t get_stats(void) const{
+        return _stats;
+    }
+
+    /*******************************************************************
+     * Send view:
+     * The entry points for the zero-copy send calls.
+     * Lend the next frame of every transport channel to the caller,
+     * then pack the header around the caller's samples on commit.
+     ******************************************************************/
+    UHD_INLINE size_t get_send_view(
+        uhd::tx_streamer::send_view_type &view,
+        const bool has_time_spec,
+        const double timeout
+    ){
+        view.release();
+
+        //the payload interleaves channels when a converter has many inputs
+        if (_io_buffs.size() != 1) throw uhd::not_implemented_error(
+            "send view: cannot lend a transport buffer shared by several channels"
+        );
+
+        //pack a header to learn where the payload starts
+        uhd::tx_metadata_t metadata;
+        metadata.has_time_spec = has_time_spec;
+        vrt::if_packet_info_t if_packet_info = this->metadata_to_if_packet_info(metadata);
+        if_packet_info.num_payload_bytes = 0;
+        if_packet_info.num_payload_words32 = 0;
+        boost::uint32_t hdr_mem[vrt::max_if_hdr_words32];
+        _vrt_packer(hdr_mem, if_packet_info);
+        const size_t payload_offset_words32 = _header_offset_words32 + if_packet_info.num_header_words32;
+
+        BOOST_FOREACH(xport_chan_props_type &props, _props){
+            managed_send_buffer::sptr buff = props.get_buff(timeout);
+            if (buff.get() == NULL){ //timeout
+                _stats.num_timeouts++;
+                view.release();
+                return 0;
+            }
+            view.buffs.push_back(buff->cast<boost::uint32_t *>() + payload_offset_words32);
+            view.leases.push_back(buff);
+        }
+        view.nsamps_per_buff = _max_samples_per_packet;
+        view.has_time_spec = has_time_spec;
+        return view.nsamps_per_buff;
+    }
+
+    UHD_INLINE size_t commit_send_view(
+        uhd::tx_streamer::send_view_type &view,
+        const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata
+    ){
+        if (view.leases.size() != this->size()) throw uhd::value_error(
+            "send view: commit of a view that did not come from this streamer"
+        );
+        if (nsamps_per_buff > view.nsamps_per_buff) throw uhd::value_error(
+            "send view: commit of more samples than the view can hold"
+        );
+        if (metadata.has_time_spec != view.has_time_spec) throw uhd::value_error(
+            "send view: commit with a time spec that does not match the reserved header"
+        );
+
+        //TODO remove this code when sample counts of zero are supported by hardware
+        #ifndef SSPH_DONT_PAD_TO_ONE
+        if (nsamps_per_buff == 0){
+            BOOST_FOREACH(void *buff, view.buffs){
+                std::memset(buff, 0, _bytes_per_otw_item);
+            }
+            return commit_send_view(view, 1, metadata) & 0x0;
+        }
+        #endif
+
+        vrt::if_packet_info_t if_packet_info = this->metadata_to_if_packet_info(metadata);
+        if_packet_info.num_payload_bytes = nsamps_per_buff*_bytes_per_otw_item;
+        if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3/*round up*/)/sizeof(boost::uint32_t);
+        if_packet_info.packet_count = _next_packet_seq;
+
+        for (size_t i = 0; i < this->size(); i++){
+            managed_send_buffer::sptr buff;
+            buff.swap(view.leases[i]);
+
+            //pack metadata into a vrt header in front of the samples
+            _vrt_packer(buff->cast<boost::uint32_t *>() + _header_offset_words32, if_packet_info);
+
+            //commit the samples to the zero-copy interface
+            size_t num_bytes_total = (_header_offset_words32+if_packet_info.num_packet_words32)*sizeof(boost::uint32_t);
+            this->commit_buff(_props[i], *buff, num_bytes_total);
+        }
+        _next_packet_seq++; //increment sequence after commits
+        _stats.num_packets += this->size();
+        _stats.num_bytes += this->size()*if_packet_info.num_payload_bytes;
+        view.release();
+
+        //flush any deferred commits before returning to the caller
+        BOOST_FOREACH(xport_chan_props_type &props, _props){
+            if (props.flush) props.flush();
+        }
+        return nsamps_per_buff;
+    }
+
+private:
+
+    vrt_packer_type _vrt_packer;
+    size_t _header_offset_words32;
+    tick_clock _clock;
+    struct xport_chan_props_type{
+        get_buff_type get_buff;
+        flush_type flush;
+        commit_type commit;
+    };
+    std::vector<xport_chan_props_type> _props;
+    std::vector<const void *> _io_buffs; //used in conversion
+    size_t _bytes_per_otw_item; //used in conversion
+    size_t _bytes_per_cpu_item; //used in conversion
+    uhd::convert::converter::sptr _converter; //used in conversion
+    size_t _max_samples_per_packet;
+    std::vector<const void *> _zero_buffs;
+    size_t _next_packet_seq;
+
+    //! fast path stats, durations are sampled on 1 in 16 packets
+    uhd::tx_stream_stats_t _stats;
+    size_t _stats_tick;
+
+    //! the nanoseconds since the start time, for the stats
+    static UHD_INLINE boost::uint64_t elapsed_ns(const time_spec_t &start){
+        return boost::uint64_t((time_spec_t::get_system_time() - start).get_real_secs()*1e9);
+    }
+
+    //! Commit a filled buffer through the channel's commit function
+    static UHD_INLINE void commit_buff(xport_chan_props_type &props, managed_send_buffer &buff, const size_t num_bytes){
+        if (props.commit) props.commit(buff, num_bytes);
+        else buff.commit(num_bytes);
+    }
+
+    //! Translate the metadata to vrt if packet info
+    UHD_INLINE vrt::if_packet_info_t metadata_to_if_packet_info(const uhd::tx_metadata_t &metadata){
         vrt::if_packet_info_t if_packet_info;
         if_packet_info.has_sid = false;
         if_packet_info.has_cid = false;
         if_packet_info.has_tlr = false;
         if_packet_info.has_tsi = metadata.has_time_spec;
         if_packet_info.has_tsf = metadata.has_time_spec;
-        if_packet_info.tsi     = boost::uint32_t(metadata.time_spec.get_full_secs());
-        if_packet_info.tsf     = boost::uint64_t(metadata.time_spec.get_tick_count(_tick_rate));
+        const tick_time_type time = _clock.from_time_spec(metadata.time_spec);
+        if_packet_info.tsi     = boost::uint32_t(time.secs);
+        if_packet_info.tsf     = boost::uint64_t(time.ticks);
         if_packet_info.sob     = metadata.start_of_burst;
         if_packet_info.eob     = metadata.end_of_burst;
+        return if_packet_info;
+    }
+
+    /*******************************************************************
+     * Send packets:
+     * Dispatch into combinations of single packet send calls.
+     ******************************************************************/
+    UHD_INLINE size_t send_packets(
+        const uhd::tx_streamer::buffs_type &buffs,
+        const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata,
+        const double timeout
+    ){
+        vrt::if_packet_info_t if_packet_info = this->metadata_to_if_packet_info(metadata);
 
         if (nsamps_per_buff <= _max_samples_per_packet){
 
@@ -155,6 +348,9 @@ public:
         }
         size_t total_num_samps_sent = 0;
 
+        //the fragments are offset in ticks from the first packet's time
+        const tick_time_type time(if_packet_info.tsi, boost::int64_t(if_packet_info.tsf));
+
         //false until final fragment
         if_packet_info.eob = false;
 
@@ -174,9 +370,9 @@ public:
             if (num_samps_sent == 0) return total_num_samps_sent;
 
             //setup metadata for the next fragment
-            const time_spec_t time_spec = metadata.time_spec + time_spec_t(0, total_num_samps_sent, _samp_rate);
-            if_packet_info.tsi = boost::uint32_t(time_spec.get_full_secs());
-            if_packet_info.tsf = boost::uint64_t(time_spec.get_tick_count(_tick_rate));
+            const tick_time_type frag_time = _clock.add_samps(time, total_num_samps_sent);
+            if_packet_info.tsi = boost::uint32_t(frag_time.secs);
+            if_packet_info.tsf = boost::uint64_t(frag_time.ticks);
             if_packet_info.sob = false;
 
         }
@@ -190,23 +386,6 @@ public:
         );
     }
 
-private:
-
-    vrt_packer_type _vrt_packer;
-    size_t _header_offset_words32;
-    double _tick_rate, _samp_rate;
-    struct xport_chan_props_type{
-        get_buff_type get_buff;
-    };
-    std::vector<xport_chan_props_type> _props;
-    std::vector<const void *> _io_buffs; //used in conversion
-    size_t _bytes_per_otw_item; //used in conversion
-    size_t _bytes_per_cpu_item; //used in conversion
-    uhd::convert::converter::sptr _converter; //used in conversion
-    size_t _max_samples_per_packet;
-    std::vector<const void *> _zero_buffs;
-    size_t _next_packet_seq;
-
     /*******************************************************************
      * Send a single packet:
      ******************************************************************/
@@ -222,10 +401,21 @@ private:
         if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3/*round up*/)/sizeof(boost::uint32_t);
         if_packet_info.packet_count = _next_packet_seq;
 
+        const bool sample_now = (_stats_tick++ & 0xf) == 0;
+
         size_t buff_index = 0;
         BOOST_FOREACH(xport_chan_props_type &props, _props){
-            managed_send_buffer::sptr buff = props.get_buff(timeout);
-            if (buff.get() == NULL) return 0; //timeout
+            managed_send_buffer::sptr buff;
+            if (sample_now){
+                const time_spec_t start = time_spec_t::get_system_time();
+                buff = props.get_buff(timeout);
+                _stats.get_buff_ns.add(elapsed_ns(start));
+            }
+            else buff = props.get_buff(timeout);
+            if (buff.get() == NULL){ //timeout
+                _stats.num_timeouts++;
+                return 0;
+            }
 
             //fill a vector with pointers to the io buffers
             BOOST_FOREACH(const void *&io_buff, _io_buffs){
@@ -238,14 +428,21 @@ private:
             otw_mem += if_packet_info.num_header_words32;
 
             //copy-convert the samples into the send buffer
-            _converter->conv(_io_buffs, otw_mem, nsamps_per_buff);
+            if (sample_now){
+                const time_spec_t start = time_spec_t::get_system_time();
+                _converter->conv(_io_buffs, otw_mem, nsamps_per_buff);
+                _stats.convert_ns.add(elapsed_ns(start));
+            }
+            else _converter->conv(_io_buffs, otw_mem, nsamps_per_buff);
 
             //commit the samples to the zero-copy interface
             size_t num_bytes_total = (_header_offset_words32+if_packet_info.num_packet_words32)*sizeof(boost::uint32_t);
-            buff->commit(num_bytes_total);
+            this->commit_buff(props, *buff, num_bytes_total);
 
         }
         _next_packet_seq++; //increment sequence after commits
+        _stats.num_packets += this->size();
+        _stats.num_bytes += this->size()*if_packet_info.num_payload_bytes;
         return nsamps_per_buff;
     }
 };
@@ -274,6 +471,22 @@ public:
         return send_packet_handler::send(buffs, nsamps_per_buff, metadata, timeout);
     }
 
+    size_t get_send_view(
+        tx_streamer::send_view_type &view,
+        const bool has_time_spec,
+        const double timeout
+    ){
+        return send_packet_handler::get_send_view(view, has_time_spec, timeout);
+    }
+
+    size_t commit_send_view(
+        tx_streamer::send_view_type &view,
+        const size_t nsamps_per_buff,
+        const uhd::tx_metadata_t &metadata
+    ){
+        return send_packet_handler::commit_send_view(view, nsamps_per_buff, metadata);
+    }
+
 private:
     size_t _max_num_samps;
 };
@@ -0,0 +1,154 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_TRANSPORT_TICK_TIME_HPP
+#define INCLUDED_LIBUHD_TRANSPORT_TICK_TIME_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/cstdint.hpp>
+#include <cmath>
+
+namespace uhd{ namespace transport{ namespace sph{
+
+/***********************************************************************
+ * Tick time
+ *
+ * A timestamp as whole seconds and ticks into the second,
+ * the same form the vrt header carries in tsi and tsf.
+ * Comparisons are exact integer comparisons.
+ **********************************************************************/
+struct tick_time_type{
+    tick_time_type(const boost::int64_t secs = 0, const boost::int64_t ticks = 0):
+        secs(secs), ticks(ticks)
+    {/* NOP */}
+    boost::int64_t secs;
+    boost::int64_t ticks;
+};
+
+UHD_INLINE bool operator==(const tick_time_type &lhs, const tick_time_type &rhs){
+    return lhs.secs == rhs.secs and lhs.ticks == rhs.ticks;
+}
+
+UHD_INLINE bool operator!=(const tick_time_type &lhs, const tick_time_type &rhs){
+    return not (lhs == rhs);
+}
+
+UHD_INLINE bool operator<(const tick_time_type &lhs, const tick_time_type &rhs){
+    return lhs.secs < rhs.secs or (lhs.secs == rhs.secs and lhs.ticks < rhs.ticks);
+}
+
+UHD_INLINE bool operator>(const tick_time_type &lhs, const tick_time_type &rhs){
+    return rhs < lhs;
+}
+
+/***********************************************************************
+ * Tick clock
+ *
+ * Holds the tick and sample rates of a packet handler and does the
+ * timestamp math in ticks. When the tick rate is a whole number and
+ * a whole number of ticks make a sample (the usual case, the DSP rate
+ * being the tick rate over an integer factor), the math is exact and
+ * free of floating point. Otherwise it falls back to time_spec_t math.
+ **********************************************************************/
+class tick_clock{
+public:
+    tick_clock(void){
+        this->set_rates(1.0, 1.0);
+    }
+
+    //! Set the rate of ticks per second
+    void set_tick_rate(const double rate){
+        this->set_rates(rate, _samp_rate);
+    }
+
+    //! Set the rate of samples per second
+    void set_samp_rate(const double rate){
+        this->set_rates(_tick_rate, rate);
+    }
+
+    //! Make a normalized tick time from the vrt tsi and tsf fields
+    UHD_INLINE tick_time_type from_packet(const boost::uint32_t tsi, const boost::uint64_t tsf) const{
+        tick_time_type time(tsi, boost::int64_t(tsf));
+        this->normalize(time);
+        return time;
+    }
+
+    //! Make a tick time from the time spec, rounded to the nearest tick
+    UHD_INLINE tick_time_type from_time_spec(const time_spec_t &time_spec) const{
+        tick_time_type time(time_spec.get_full_secs(), time_spec.get_tick_count(_tick_rate));
+        this->normalize(time);
+        return time;
+    }
+
+    //! Get the tick time a number of samples after the given time
+    UHD_INLINE tick_time_type add_samps(const tick_time_type &time, const size_t nsamps) const{
+        if (_ticks_per_samp == 0) return this->from_time_spec(this->inexact_time_spec(time, nsamps));
+        return this->exact_add_samps(time, nsamps);
+    }
+
+    //! Get the time spec of a number of samples after the given time
+    UHD_INLINE time_spec_t to_time_spec(const tick_time_type &time, const size_t nsamps = 0) const{
+        if (_ticks_per_samp == 0) return this->inexact_time_spec(time, nsamps);
+        const tick_time_type sum = this->exact_add_samps(time, nsamps);
+        return time_spec_t(time_t(sum.secs), long(sum.ticks), _tick_rate);
+    }
+
+private:
+    double _tick_rate, _samp_rate;
+    boost::int64_t _ticks_per_sec; //zero when the tick rate is not whole
+    boost::int64_t _ticks_per_samp; //zero when the math is not exact
+
+    void set_rates(const double tick_rate, const double samp_rate){
+        _tick_rate = tick_rate;
+        _samp_rate = samp_rate;
+        _ticks_per_sec = exact_ratio(tick_rate, 1.0);
+        _ticks_per_samp = (_ticks_per_sec == 0)? 0 : exact_ratio(tick_rate, samp_rate);
+    }
+
+    //! the whole number num/den, or zero when it is not whole
+    static boost::int64_t exact_ratio(const double num, const double den){
+        if (num <= 0 or den <= 0) return 0;
+        const double ratio = num/den;
+        const double whole = std::floor(ratio + 0.5);
+        if (whole < 1 or std::abs(ratio - whole) > 1e-9*whole) return 0;
+        return boost::int64_t(whole);
+    }
+
+    //! add whole ticks per sample, only when the ratio is exact
+    UHD_INLINE tick_time_type exact_add_samps(const tick_time_type &time, const size_t nsamps) const{
+        tick_time_type sum(time.secs, time.ticks + boost::int64_t(nsamps)*_ticks_per_samp);
+        this->normalize(sum);
+        return sum;
+    }
+
+    //! the time_spec_t math for rates that do not divide evenly
+    time_spec_t inexact_time_spec(const tick_time_type &time, const size_t nsamps) const{
+        return time_spec_t(time_t(time.secs), long(time.ticks), _tick_rate) + time_spec_t(0, long(nsamps), _samp_rate);
+    }
+
+    //! carry whole seconds out of the ticks (the wire is already normalized)
+    UHD_INLINE void normalize(tick_time_type &time) const{
+        if (_ticks_per_sec == 0 or time.ticks < _ticks_per_sec) return;
+        time.secs += time.ticks/_ticks_per_sec;
+        time.ticks %= _ticks_per_sec;
+    }
+};
+
+}}} //namespace uhd::transport::sph
+
+#endif /* INCLUDED_LIBUHD_TRANSPORT_TICK_TIME_HPP */
@@ -18,12 +18,23 @@
 #include "udp_common.hpp"
 #include <uhd/transport/udp_zero_copy.hpp>
 #include <uhd/transport/udp_simple.hpp> //mtu
-#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/transport/spsc_bounded_buffer.hpp>
+#include <uhd/utils/atomic.hpp>
 #include <uhd/transport/buffer_pool.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/log.hpp>
 #include <boost/format.hpp>
+#include <algorithm>
+#include <cstring>
 #include <list>
+#include <vector>
+#include <deque>
+#include <utility>
+#include <boost/scoped_ptr.hpp>
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
 
 using namespace uhd;
 using namespace uhd::transport;
@@ -32,6 +43,10 @@ namespace asio = boost::asio;
 //A reasonable number of frames for send/recv and async/sync
 static const size_t DEFAULT_NUM_FRAMES = 32;
 
+//The default number of frames per receive/send syscall (1 means no batching)
+static const size_t DEFAULT_RECV_BATCH_SIZE = 1;
+static const size_t DEFAULT_SEND_BATCH_SIZE = 1;
+
 /***********************************************************************
  * Check registry for correct fast-path setting (windows only)
  **********************************************************************/
@@ -65,13 +80,17 @@ static void check_registry_for_fast_send_threshold(const size_t mtu){
  **********************************************************************/
 class udp_zero_copy_asio_mrb : public managed_recv_buffer{
 public:
-    udp_zero_copy_asio_mrb(void *mem, bounded_buffer<udp_zero_copy_asio_mrb *> &pending):
-        _mem(mem), _len(0), _pending(pending){/* NOP */}
+    udp_zero_copy_asio_mrb(
+        void *mem, spsc_bounded_buffer<udp_zero_copy_asio_mrb *> &pending, spin_lock &release_lock
+    ):
+        _mem(mem), _len(0), _pending(pending), _release_lock(release_lock){/* NOP */}
 
     void release(void){
         if (_len == 0) return;
-        _pending.push_with_haste(this);
         _len = 0;
+        //a recv view may release its buffers on another thread
+        spin_lock::scoped_lock lock(_release_lock);
+        _pending.push_with_haste(this);
     }
 
     sptr get_new(size_t len){
@@ -87,24 +106,106 @@ private:
 
     void *_mem;
     size_t _len;
-    bounded_buffer<udp_zero_copy_asio_mrb *> &_pending;
+    spsc_bounded_buffer<udp_zero_copy_asio_mrb *> &_pending;
+    spin_lock &_release_lock;
+};
+
+/***********************************************************************
+ * Deferred send batch:
+ *  - Committed frames are queued instead of sent immediately.
+ *  - Flush sends all queued frames with one sendmmsg() call,
+ *    and pushes the managed send buffers back into the queue.
+ *  - The batch flushes itself when it fills up.
+ **********************************************************************/
+class udp_zero_copy_asio_msb;
+
+class udp_zero_copy_asio_send_batch{
+public:
+    udp_zero_copy_asio_send_batch(
+        size_t batch_size, spsc_bounded_buffer<udp_zero_copy_asio_msb *> &pending, int sock_fd
+    ):
+        _batch_size(batch_size), _num_queued(0), _pending(pending), _sock_fd(sock_fd)
+    {
+        #ifdef HAVE_SENDMMSG
+        _msbs.resize(_batch_size);
+        _iovs.resize(_batch_size);
+        _msgs.resize(_batch_size);
+        #endif /*HAVE_SENDMMSG*/
+    }
+
+    void push(udp_zero_copy_asio_msb *msb, void *mem, size_t len){
+        #ifdef HAVE_SENDMMSG
+        _msbs[_num_queued] = msb;
+        _iovs[_num_queued].iov_base = mem;
+        _iovs[_num_queued].iov_len = len;
+        if (++_num_queued == _batch_size) this->flush();
+        #endif /*HAVE_SENDMMSG*/
+    }
+
+    void flush(void){
+        #ifdef HAVE_SENDMMSG
+        if (_num_queued == 0) return;
+
+        for (size_t i = 0; i < _num_queued; i++){
+            std::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+            _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+            _msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        //sendmmsg may send a partial batch, loop until done or error
+        size_t num_sent = 0;
+        while (num_sent < _num_queued){
+            const int ret = ::sendmmsg(_sock_fd, &_msgs[num_sent], _num_queued - num_sent, 0);
+            if (ret <= 0) break; //errors are dropped like with ::send()
+            num_sent += size_t(ret);
+        }
+
+        for (size_t i = 0; i < _num_queued; i++){
+            _pending.push_with_haste(_msbs[i]);
+        }
+        _num_queued = 0;
+        #endif /*HAVE_SENDMMSG*/
+    }
+
+private:
+    const size_t _batch_size;
+    size_t _num_queued;
+    spsc_bounded_buffer<udp_zero_copy_asio_msb *> &_pending;
+    int _sock_fd;
+    #ifdef HAVE_SENDMMSG
+    std::vector<udp_zero_copy_asio_msb *> _msbs;
+    std::vector<iovec> _iovs;
+    std::vector<mmsghdr> _msgs;
+    #endif /*HAVE_SENDMMSG*/
 };
 
 /***********************************************************************
  * Reusable managed send buffer:
  *  - Initialize with memory and a commit callback.
  *  - Call get new with a length in bytes to re-use.
+ *  - Commit queues into the send batch when one is provided.
  **********************************************************************/
 class udp_zero_copy_asio_msb : public managed_send_buffer{
 public:
-    udp_zero_copy_asio_msb(void *mem, bounded_buffer<udp_zero_copy_asio_msb *> &pending, int sock_fd):
-        _mem(mem), _len(0), _pending(pending), _sock_fd(sock_fd){/* NOP */}
+    udp_zero_copy_asio_msb(
+        void *mem, spsc_bounded_buffer<udp_zero_copy_asio_msb *> &pending, int sock_fd,
+        udp_zero_copy_asio_send_batch *batch = NULL
+    ):
+        _mem(mem), _len(0), _pending(pending), _sock_fd(sock_fd), _batch(batch){/* NOP */}
 
     void commit(size_t len){
         if (_len == 0) return;
+        _len = 0;
+        if (len == 0){ //dropped without a commit, nothing to send
+            _pending.push_with_haste(this);
+            return;
+        }
+        if (_batch != NULL){
+            _batch->push(this, _mem, len);
+            return;
+        }
         ::send(_sock_fd, this->cast<const char *>(), len, 0);
         _pending.push_with_haste(this);
-        _len = 0;
     }
 
     sptr get_new(size_t len){
@@ -118,8 +219,9 @@ private:
 
     void *_mem;
     size_t _len;
-    bounded_buffer<udp_zero_copy_asio_msb *> &_pending;
+    spsc_bounded_buffer<udp_zero_copy_asio_msb *> &_pending;
     int _sock_fd;
+    udp_zero_copy_asio_send_batch *_batch;
 };
 
 /***********************************************************************
@@ -142,11 +244,14 @@ public:
         _num_recv_frames(size_t(hints.cast<double>("num_recv_frames", DEFAULT_NUM_FRAMES))),
         _send_frame_size(size_t(hints.cast<double>("send_frame_size", udp_simple::mtu))),
         _num_send_frames(size_t(hints.cast<double>("num_send_frames", DEFAULT_NUM_FRAMES))),
-        _recv_buffer_pool(buffer_pool::make(_num_recv_frames, _recv_frame_size)),
-        _send_buffer_pool(buffer_pool::make(_num_send_frames, _send_frame_size)),
+        _recv_batch_size(size_t(hints.cast<double>("recv_batch_size", DEFAULT_RECV_BATCH_SIZE))),
+        _send_batch_size(size_t(hints.cast<double>("send_batch_size", DEFAULT_SEND_BATCH_SIZE))),
+        _recv_buffer_pool(buffer_pool::make(_num_recv_frames, _recv_frame_size, hints)),
+        _send_buffer_pool(buffer_pool::make(_num_send_frames, _send_frame_size, hints)),
         _pending_recv_buffs(_num_recv_frames),
         _pending_send_buffs(_num_send_frames)
     {
+        _unfilled_recv_buffs.reserve(_num_recv_frames);
         UHD_LOG << boost::format("Creating udp transport for %s %s") % addr % port << std::endl;
 
         #ifdef UHD_PLATFORM_WIN32
@@ -164,10 +269,25 @@ public:
         _socket->connect(receiver_endpoint);
         _sock_fd = _socket->native();
 
+        //the batch size cannot exceed the number of send frames
+        _send_batch_size = std::max<size_t>(1, std::min(_send_batch_size, _num_send_frames));
+        #ifdef HAVE_SENDMMSG
+        if (_send_batch_size > 1) _send_batch.reset(new udp_zero_copy_asio_send_batch(
+            _send_batch_size, _pending_send_buffs, _sock_fd
+        ));
+        #else
+        if (_send_batch_size > 1) UHD_MSG(warning) << boost::format(
+            "Batched send (send_batch_size=%d) is not supported on this platform.\n"
+            "Falling back to one send call per frame.\n"
+        ) % _send_batch_size;
+        _send_batch_size = 1;
+        #endif /*HAVE_SENDMMSG*/
+        UHD_LOG << boost::format("Send batch size: %d frames") % _send_batch_size << std::endl;
+
         //allocate re-usable managed receive buffers
         for (size_t i = 0; i < get_num_recv_frames(); i++){
             _mrb_pool.push_back(udp_zero_copy_asio_mrb(
-                _recv_buffer_pool->at(i), _pending_recv_buffs
+                _recv_buffer_pool->at(i), _pending_recv_buffs, _recv_release_lock
             ));
             _pending_recv_buffs.push_with_haste(&_mrb_pool.back());
         }
@@ -175,10 +295,29 @@ public:
         //allocate re-usable managed send buffers
         for (size_t i = 0; i < get_num_send_frames(); i++){
             _msb_pool.push_back(udp_zero_copy_asio_msb(
-                _send_buffer_pool->at(i), _pending_send_buffs, _sock_fd
+                _send_buffer_pool->at(i), _pending_send_buffs, _sock_fd, _send_batch.get()
             ));
             _pending_send_buffs.push_with_haste(&_msb_pool.back());
         }
+
+        //the batch size cannot exceed the number of receive frames
+        _recv_batch_size = std::max<size_t>(1, std::min(_recv_batch_size, get_num_recv_frames()));
+        #ifdef HAVE_RECVMMSG
+        _recv_batch_mrbs.resize(_recv_batch_size);
+        _recv_batch_iovs.resize(_recv_batch_size);
+        _recv_batch_msgs.resize(_recv_batch_size);
+        #else
+        if (_recv_batch_size > 1) UHD_MSG(warning) << boost::format(
+            "Batched receive (recv_batch_size=%d) is not supported on this platform.\n"
+            "Falling back to one receive call per frame.\n"
+        ) % _recv_batch_size;
+        _recv_batch_size = 1;
+        #endif /*HAVE_RECVMMSG*/
+        UHD_LOG << boost::format("Receive batch size: %d frames") % _recv_batch_size << std::endl;
+    }
+
+    ~udp_zero_copy_asio_impl(void){
+        this->flush_send_buffs();
     }
 
     //get size for internal socket buffer
@@ -203,10 +342,18 @@ public:
      * Return the managed receive buffer with the new length.
      * When the caller is finished with the managed buffer,
      * the managed receive buffer is released back into the queue.
+     *
+     * The queue is single-producer single-consumer:
+     * only release() pushes and only this method pops.
+     * Frames claimed but left unfilled are kept aside for the next call.
      ******************************************************************/
     managed_recv_buffer::sptr get_recv_buff(double timeout){
+        #ifdef HAVE_RECVMMSG
+        if (_recv_batch_size > 1) return get_recv_buff_batched(timeout);
+        #endif /*HAVE_RECVMMSG*/
+
         udp_zero_copy_asio_mrb *mrb = NULL;
-        if (_pending_recv_buffs.pop_with_timed_wait(mrb, timeout)){
+        if (this->claim_recv_buff(mrb, timeout)){
 
             #ifdef MSG_DONTWAIT //try a non-blocking recv() if supported
             ssize_t ret = ::recv(_sock_fd, mrb->cast<char *>(), _recv_frame_size, MSG_DONTWAIT);
@@ -217,11 +364,76 @@ public:
                 ::recv(_sock_fd, mrb->cast<char *>(), _recv_frame_size, 0)
             );
 
-            _pending_recv_buffs.push_with_haste(mrb); //timeout: return the managed buffer to the queue
+            _unfilled_recv_buffs.push_back(mrb); //timeout: keep the managed buffer for the next call
         }
         return managed_recv_buffer::sptr();
     }
 
+    UHD_INLINE bool claim_recv_buff_with_haste(udp_zero_copy_asio_mrb *&mrb){
+        if (_unfilled_recv_buffs.empty()) return _pending_recv_buffs.pop_with_haste(mrb);
+        mrb = _unfilled_recv_buffs.back();
+        _unfilled_recv_buffs.pop_back();
+        return true;
+    }
+
+    UHD_INLINE bool claim_recv_buff(udp_zero_copy_asio_mrb *&mrb, double timeout){
+        if (this->claim_recv_buff_with_haste(mrb)) return true;
+        return _pending_recv_buffs.pop_with_timed_wait(mrb, timeout);
+    }
+
+    #ifdef HAVE_RECVMMSG
+    /*******************************************************************
+     * Batched receive implementation:
+     *
+     * Hand out frames that were filled by a previous batch first.
+     * Otherwise, claim up to batch size pending frames (waiting only
+     * for the first one) and fill them with a single recvmmsg() call,
+     * falling back to a blocking wait with timeout when nothing is ready.
+     * Unfilled frames are kept aside for the next batch.
+     ******************************************************************/
+    managed_recv_buffer::sptr get_recv_buff_batched(double timeout){
+        if (_recv_batch_ready.empty()) this->recv_batch(timeout);
+        if (_recv_batch_ready.empty()) return managed_recv_buffer::sptr();
+        const std::pair<udp_zero_copy_asio_mrb *, size_t> ready = _recv_batch_ready.front();
+        _recv_batch_ready.pop_front();
+        return ready.first->get_new(ready.second);
+    }
+
+    void recv_batch(double timeout){
+        //claim as many pending frames as available up to the batch size
+        size_t num_mrbs = 0;
+        if (not this->claim_recv_buff(_recv_batch_mrbs[num_mrbs], timeout)) return;
+        num_mrbs++;
+        while (num_mrbs < _recv_batch_size and this->claim_recv_buff_with_haste(_recv_batch_mrbs[num_mrbs])){
+            num_mrbs++;
+        }
+
+        //point each message header at the memory of a claimed frame
+        for (size_t i = 0; i < num_mrbs; i++){
+            _recv_batch_iovs[i].iov_base = _recv_batch_mrbs[i]->cast<char *>();
+            _recv_batch_iovs[i].iov_len = _recv_frame_size;
+            std::memset(&_recv_batch_msgs[i], 0, sizeof(_recv_batch_msgs[i]));
+            _recv_batch_msgs[i].msg_hdr.msg_iov = &_recv_batch_iovs[i];
+            _recv_batch_msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        //try a non-blocking batch, then wait for the socket and try again
+        int ret = ::recvmmsg(_sock_fd, &_recv_batch_msgs.front(), num_mrbs, MSG_DONTWAIT, NULL);
+        if (ret <= 0 and wait_for_recv_ready(_sock_fd, timeout)){
+            ret = ::recvmmsg(_sock_fd, &_recv_batch_msgs.front(), num_mrbs, MSG_DONTWAIT, NULL);
+        }
+        const size_t num_filled = (ret > 0)? size_t(ret) : 0;
+
+        //queue up the filled frames and keep the rest for the next batch
+        for (size_t i = 0; i < num_mrbs; i++){
+            if (i < num_filled) _recv_batch_ready.push_back(std::make_pair(
+                _recv_batch_mrbs[i], size_t(_recv_batch_msgs[i].msg_len)
+            ));
+            else _unfilled_recv_buffs.push_back(_recv_batch_mrbs[i]);
+        }
+    }
+    #endif /*HAVE_RECVMMSG*/
+
     size_t get_num_recv_frames(void) const {return _num_recv_frames;}
     size_t get_recv_frame_size(void) const {return _recv_frame_size;}
 
@@ -232,15 +444,30 @@ public:
      * The caller will fill the buffer and commit it when finished.
      * The commit routine will perform a blocking send operation,
      * and push the managed send buffer back into the queue.
+     *
+     * With batched send, the commit routine queues the buffer instead.
+     * Queued buffers are sent when the batch fills up,
+     * when the caller flushes, or when no free buffer is left.
      ******************************************************************/
     managed_send_buffer::sptr get_send_buff(double timeout){
         udp_zero_copy_asio_msb *msb = NULL;
-        if (_pending_send_buffs.pop_with_timed_wait(msb, timeout)){
+        if (_send_batch.get() != NULL and not _pending_send_buffs.pop_with_haste(msb)){
+            _send_batch->flush(); //free up the queued buffers
+        }
+        if (msb != NULL or _pending_send_buffs.pop_with_timed_wait(msb, timeout)){
             return msb->get_new(_send_frame_size);
         }
         return managed_send_buffer::sptr();
     }
 
+    void flush_send_buffs(void){
+        if (_send_batch.get() != NULL) _send_batch->flush();
+    }
+
+    int get_native_handle(void) const{
+        return _sock_fd;
+    }
+
     size_t get_num_send_frames(void) const {return _num_send_frames;}
     size_t get_send_frame_size(void) const {return _send_frame_size;}
 
@@ -248,11 +475,24 @@ private:
     //memory management -> buffers and fifos
     const size_t _recv_frame_size, _num_recv_frames;
     const size_t _send_frame_size, _num_send_frames;
+    size_t _recv_batch_size, _send_batch_size;
     buffer_pool::sptr _recv_buffer_pool, _send_buffer_pool;
-    bounded_buffer<udp_zero_copy_asio_mrb *> _pending_recv_buffs;
-    bounded_buffer<udp_zero_copy_asio_msb *> _pending_send_buffs;
+    //single producer (release/commit) and single consumer (get_*_buff)
+    spsc_bounded_buffer<udp_zero_copy_asio_mrb *> _pending_recv_buffs;
+    spin_lock _recv_release_lock; //serializes the releases onto the recv queue
+    spsc_bounded_buffer<udp_zero_copy_asio_msb *> _pending_send_buffs;
     std::list<udp_zero_copy_asio_msb> _msb_pool;
     std::list<udp_zero_copy_asio_mrb> _mrb_pool;
+    std::vector<udp_zero_copy_asio_mrb *> _unfilled_recv_buffs;
+    boost::scoped_ptr<udp_zero_copy_asio_send_batch> _send_batch;
+
+    #ifdef HAVE_RECVMMSG
+    //batched receive -> scratch space and frames filled by the last batch
+    std::vector<udp_zero_copy_asio_mrb *> _recv_batch_mrbs;
+    std::vector<iovec> _recv_batch_iovs;
+    std::vector<mmsghdr> _recv_batch_msgs;
+    std::deque<std::pair<udp_zero_copy_asio_mrb *, size_t> > _recv_batch_ready;
+    #endif /*HAVE_RECVMMSG*/
 
     //asio guts -> socket and service
     asio::io_service        _io_service;
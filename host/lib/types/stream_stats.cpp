@@ -0,0 +1,104 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/types/stream_stats.hpp>
+#include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <algorithm>
+#include <sstream>
+
+using namespace uhd;
+
+/***********************************************************************
+ * log2 histogram
+ **********************************************************************/
+log2_histogram_t::log2_histogram_t(void):
+    count(0), sum(0)
+{
+    std::fill(buckets, buckets+num_buckets, 0);
+}
+
+double log2_histogram_t::get_mean(void) const{
+    return (count == 0)? 0.0 : double(sum)/count;
+}
+
+boost::uint64_t log2_histogram_t::get_percentile(const double fraction) const{
+    const boost::uint64_t target = boost::uint64_t(fraction*count);
+    boost::uint64_t accum = 0;
+    for (size_t i = 0; i < num_buckets; i++){
+        accum += buckets[i];
+        if (accum > target or accum == count) return (boost::uint64_t(1) << i) - 1;
+    }
+    return 0; //empty
+}
+
+std::string log2_histogram_t::to_pp_string(void) const{
+    return str(boost::format("count %u, mean %.1f, p50 < %u, p99 < %u, max < %u")
+        % count % get_mean() % (get_percentile(0.5)+1) % (get_percentile(0.99)+1) % (get_percentile(1.0)+1)
+    );
+}
+
+/***********************************************************************
+ * stream stats
+ **********************************************************************/
+rx_stream_stats_t::rx_stream_stats_t(void):
+    num_packets(0), num_bytes(0), num_timeouts(0), num_overflows(0)
+{
+    /* NOP */
+}
+
+std::string rx_stream_stats_t::to_pp_string(void) const{
+    std::stringstream seq_errors_ss;
+    BOOST_FOREACH(const boost::uint64_t num, seq_errors){
+        seq_errors_ss << num << " ";
+    }
+    return str(boost::format(
+        "RX Stream Stats:\n"
+        "    Packets: %u\n"
+        "    Bytes: %u\n"
+        "    Timeouts: %u\n"
+        "    Overflows: %u\n"
+        "    Sequence errors per channel: %s\n"
+        "    Alignment iterations: %s\n"
+        "    Get buffer (ns): %s\n"
+        "    Convert (ns): %s\n"
+    )
+        % num_packets % num_bytes % num_timeouts % num_overflows % seq_errors_ss.str()
+        % align_iterations.to_pp_string() % get_buff_ns.to_pp_string() % convert_ns.to_pp_string()
+    );
+}
+
+tx_stream_stats_t::tx_stream_stats_t(void):
+    num_packets(0), num_bytes(0), num_timeouts(0)
+{
+    /* NOP */
+}
+
+std::string tx_stream_stats_t::to_pp_string(void) const{
+    return str(boost::format(
+        "TX Stream Stats:\n"
+        "    Packets: %u\n"
+        "    Bytes: %u\n"
+        "    Timeouts: %u\n"
+        "    Get buffer (ns): %s\n"
+        "    Convert (ns): %s\n"
+        "    Flow control wait (ns): %s\n"
+    )
+        % num_packets % num_bytes % num_timeouts
+        % get_buff_ns.to_pp_string() % convert_ns.to_pp_string() % fc_wait_ns.to_pp_string()
+    );
+}
@@ -0,0 +1,147 @@
+//
+// Copyright 2010-2011 Ettus Research LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_FLOW_CONTROL_MONITOR_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_FLOW_CONTROL_MONITOR_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/thread_time.hpp>
+
+/***********************************************************************
+ * flow control monitor for a single tx channel
+ *  - the pirate thread calls update
+ *  - the get send buffer calls check
+ *
+ * The ack counter is an atomic, so a check with an open
+ * window and an update with no waiter never take a lock.
+ * A throttled check spins briefly, then blocks on the condition.
+ * The time spent throttled is kept in a histogram for the stats.
+ **********************************************************************/
+class flow_control_monitor{
+public:
+    typedef boost::uint32_t seq_type;
+    typedef boost::shared_ptr<flow_control_monitor> sptr;
+
+    /*!
+     * Make a new flow control monitor.
+     * \param max_seqs_out num seqs before throttling
+     */
+    flow_control_monitor(seq_type max_seqs_out):_max_seqs_out(max_seqs_out){
+        this->clear();
+    }
+
+    //! Clear the monitor, Ex: when a streamer is created
+    void clear(void){
+        _last_seq_out = 0;
+        _last_seq_ack.write(0);
+        _wait_ns = uhd::log2_histogram_t();
+    }
+
+    //! Get the nanoseconds spent in each throttled check
+    uhd::log2_histogram_t get_wait_histogram(void) const{
+        return _wait_ns;
+    }
+
+    /*!
+     * Gets the current sequence number to go out.
+     * Increments the sequence for the next call
+     * \return the sequence to be sent to the dsp
+     */
+    UHD_INLINE seq_type get_curr_seq_out(void){
+        return _last_seq_out++;
+    }
+
+    /*!
+     * Check the flow control condition.
+     * \param timeout the timeout in seconds
+     * \return false on timeout
+     */
+    UHD_INLINE bool check_fc_condition(double timeout){
+        if (this->ready()) return true;
+        if (timeout <= 0.0) return false;
+        const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+        const bool is_ready = this->wait(timeout);
+        _wait_ns.add(boost::uint64_t((uhd::time_spec_t::get_system_time() - start).get_real_secs()*1e9));
+        return is_ready;
+    }
+
+    /*!
+     * Update the flow control condition.
+     * \param seq the last sequence number to be ACK'd
+     */
+    UHD_INLINE void update_fc_condition(seq_type seq){
+        //the cas is a full barrier between the ack store and the waiter load
+        _last_seq_ack.cas(seq, _last_seq_ack.read());
+        if (_waiting.read() == 0) return;
+        boost::mutex::scoped_lock lock(_fc_mutex);
+        _fc_cond.notify_one();
+    }
+
+private:
+    //poll this many times before blocking on the condition
+    static const size_t SPIN_COUNT = 1000;
+
+    bool ready(void){
+        return seq_type(_last_seq_out - _last_seq_ack.read()) < _max_seqs_out;
+    }
+
+    /*!
+     * Spin on the window, then block on the condition variable.
+     * The waiting flag is set with a full barrier before re-checking,
+     * and the update reads it after its own full barrier,
+     * so either we see the new ack or the update sees the flag.
+     */
+    bool wait(double timeout){
+        for (size_t i = 0; i < SPIN_COUNT; i++){
+            if (this->ready()) return true;
+        }
+
+        boost::this_thread::disable_interruption di; //disable because the wait can throw
+        const boost::system_time exit_time = boost::get_system_time() +
+            boost::posix_time::microseconds(long(timeout*1e6));
+        boost::mutex::scoped_lock lock(_fc_mutex);
+        _waiting.cas(1, 0);
+        bool is_ready = this->ready();
+        while (not is_ready){
+            const bool notified = _fc_cond.timed_wait(lock, exit_time);
+            is_ready = this->ready();
+            if (not notified) break; //timeout
+        }
+        _waiting.write(0);
+        return is_ready;
+    }
+
+    seq_type _last_seq_out; //only touched by the sending thread
+    uhd::atomic_uint32_t _last_seq_ack;
+    const seq_type _max_seqs_out;
+    uhd::log2_histogram_t _wait_ns; //only touched by the sending thread
+
+    //slow path: used only when the window is closed
+    boost::mutex _fc_mutex;
+    boost::condition _fc_cond;
+    uhd::atomic_uint32_t _waiting;
+};
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_FLOW_CONTROL_MONITOR_HPP */
@@ -0,0 +1,147 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "recv_reactor.hpp"
+#include <uhd/exception.hpp>
+#include <uhd/utils/assert_has.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <list>
+
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#else
+#include <boost/asio.hpp> //select
+#endif /*HAVE_EPOLL*/
+
+using namespace uhd;
+using namespace uhd::usrp;
+using namespace uhd::transport;
+
+/***********************************************************************
+ * Receive reactor implementation:
+ *  - wait on all transports with a 100ms timeout to poll for interrupts
+ *  - drain each ready transport without blocking, bounded by its frames
+ **********************************************************************/
+class recv_reactor_impl : public recv_reactor{
+public:
+    recv_reactor_impl(void){
+        #ifdef HAVE_EPOLL
+        _epoll_fd = ::epoll_create(1/*size hint, ignored*/);
+        if (_epoll_fd < 0) throw uhd::os_error("error in epoll_create");
+        #endif /*HAVE_EPOLL*/
+    }
+
+    ~recv_reactor_impl(void){
+        _task.reset(); //stop the thread before the transports go away
+        #ifdef HAVE_EPOLL
+        ::close(_epoll_fd);
+        #endif /*HAVE_EPOLL*/
+    }
+
+    void add_xport(udp_zero_copy::sptr xport, const handler_type &handler){
+        UHD_ASSERT_THROW(_task.get() == NULL);
+        _xports.push_back(xport_type(xport, handler));
+
+        #ifdef HAVE_EPOLL
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = &_xports.back();
+        if (::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, xport->get_native_handle(), &event) != 0){
+            throw uhd::os_error("error in epoll_ctl");
+        }
+        #endif /*HAVE_EPOLL*/
+    }
+
+    void start(const int cpu){
+        UHD_ASSERT_THROW(_task.get() == NULL);
+        _task = task::make(boost::bind(&recv_reactor_impl::reactor_loop, this, cpu));
+    }
+
+private:
+    struct xport_type{
+        xport_type(udp_zero_copy::sptr xport, const handler_type &handler):
+            xport(xport), handler(handler){}
+        udp_zero_copy::sptr xport;
+        handler_type handler;
+    };
+    std::list<xport_type> _xports; //list: the epoll events point to the entries
+    task::sptr _task;
+
+    void reactor_loop(const int cpu){
+        set_thread_priority_safe();
+        if (cpu >= 0) set_thread_affinity_safe(size_t(cpu));
+
+        while (not boost::this_thread::interruption_requested()){
+            this->wait_and_dispatch(0.1);
+        }
+    }
+
+    void dispatch(xport_type &xport){
+        //bounded so that a busy transport cannot starve the others
+        for (size_t i = 0; i < xport.xport->get_num_recv_frames(); i++){
+            managed_recv_buffer::sptr buff = xport.xport->get_recv_buff(0.0);
+            if (not buff.get()) return;
+            xport.handler(buff);
+        }
+    }
+
+    #ifdef HAVE_EPOLL
+    int _epoll_fd;
+
+    void wait_and_dispatch(const double timeout){
+        static const int max_events = 16;
+        epoll_event events[max_events];
+        const int num_events = ::epoll_wait(_epoll_fd, events, max_events, int(timeout*1000));
+        for (int i = 0; i < num_events; i++){ //nothing to do on timeout or EINTR
+            this->dispatch(*static_cast<xport_type *>(events[i].data.ptr));
+        }
+    }
+    #else
+    void wait_and_dispatch(const double timeout){
+        fd_set rset;
+        FD_ZERO(&rset);
+        int max_fd = 0;
+        BOOST_FOREACH(xport_type &xport, _xports){
+            const int fd = xport.xport->get_native_handle();
+            FD_SET(fd, &rset);
+            max_fd = std::max(max_fd, fd);
+        }
+
+        timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = int(timeout*1000000)%1000000;
+        if (::select(max_fd+1, &rset, NULL, NULL, &tv) <= 0) return;
+
+        BOOST_FOREACH(xport_type &xport, _xports){
+            if (FD_ISSET(xport.xport->get_native_handle(), &rset)) this->dispatch(xport);
+        }
+    }
+    #endif /*HAVE_EPOLL*/
+};
+
+/***********************************************************************
+ * Receive reactor factory function
+ **********************************************************************/
+recv_reactor::sptr recv_reactor::make(void){
+    return sptr(new recv_reactor_impl());
+}
@@ -0,0 +1,59 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_RECV_REACTOR_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_RECV_REACTOR_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/udp_zero_copy.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/utility.hpp>
+
+namespace uhd{ namespace usrp{
+
+    /*!
+     * The receive reactor serves many transports with a single thread.
+     * The thread waits on all of the transports at once (epoll on linux),
+     * and hands every received packet to the handler of its transport.
+     * Devices use it for the TX flow control and async message transports.
+     */
+    class recv_reactor : boost::noncopyable{
+    public:
+        typedef boost::shared_ptr<recv_reactor> sptr;
+        typedef boost::function<void(transport::managed_recv_buffer::sptr)> handler_type;
+
+        //! Make a new reactor, the thread is spawned by start()
+        static sptr make(void);
+
+        /*!
+         * Register a transport with the reactor before it is started.
+         * \param xport the transport to receive from
+         * \param handler called on the reactor thread for each packet
+         */
+        virtual void add_xport(transport::udp_zero_copy::sptr xport, const handler_type &handler) = 0;
+
+        /*!
+         * Spawn the reactor thread.
+         * \param cpu the core to pin the thread to, or -1 to not pin
+         */
+        virtual void start(const int cpu = -1) = 0;
+    };
+
+}} //namespace uhd::usrp
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_RECV_REACTOR_HPP */
@@ -0,0 +1,109 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_COMMON_TIMED_CMD_QUEUE_HPP
+#define INCLUDED_LIBUHD_USRP_COMMON_TIMED_CMD_QUEUE_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <deque>
+#include <utility>
+
+/***********************************************************************
+ * timed command queue
+ *  - commands run in the order they were queued
+ *  - the front command holds back the rest until its time comes
+ *  - a late command runs as soon as it reaches the front
+ *
+ * The device firmware keeps such a queue of register writes,
+ * the host keeps a mirror of it to never overflow the device queue.
+ * The time is passed in, so a simulated clock can drive the queue.
+ **********************************************************************/
+template <typename cmd_type> class timed_cmd_queue{
+public:
+    timed_cmd_queue(const size_t depth): _depth(depth){
+        /* NOP */
+    }
+
+    size_t depth(void) const{
+        return _depth;
+    }
+
+    size_t size(void) const{
+        return _queue.size();
+    }
+
+    bool empty(void) const{
+        return _queue.empty();
+    }
+
+    bool full(void) const{
+        return _queue.size() >= _depth;
+    }
+
+    void clear(void){
+        _queue.clear();
+    }
+
+    //! Queue a command for the given time, false when the queue is full
+    bool push(const uhd::time_spec_t &time, const cmd_type &cmd){
+        if (this->full()) return false;
+        _queue.push_back(std::make_pair(time, cmd));
+        return true;
+    }
+
+    //! The time of the front command, the queue must not be empty
+    const uhd::time_spec_t &front_time(void) const{
+        return _queue.front().first;
+    }
+
+    //! The time left until the front command runs, zero when it is due or the queue is empty
+    uhd::time_spec_t get_wait(const uhd::time_spec_t &now) const{
+        if (_queue.empty() or this->front_time() <= now) return uhd::time_spec_t(0.0);
+        return this->front_time() - now;
+    }
+
+    /*!
+     * Run the commands that are due at the given time.
+     * \param now the current device time
+     * \param handler called with each due command, in order
+     * \return the number of commands run
+     */
+    template <typename handler_type> size_t run(const uhd::time_spec_t &now, handler_type handler){
+        size_t num_run = 0;
+        while (not _queue.empty() and this->front_time() <= now){
+            const cmd_type cmd = _queue.front().second;
+            _queue.pop_front();
+            handler(cmd);
+            num_run++;
+        }
+        return num_run;
+    }
+
+    //! Drop the commands that are due at the given time, Ex: in a host mirror
+    size_t retire(const uhd::time_spec_t &now){
+        return this->run(now, &timed_cmd_queue::ignore);
+    }
+
+private:
+    static void ignore(const cmd_type &){}
+
+    const size_t _depth;
+    std::deque<std::pair<uhd::time_spec_t, cmd_type> > _queue;
+};
+
+#endif /* INCLUDED_LIBUHD_USRP_COMMON_TIMED_CMD_QUEUE_HPP */
@@ -79,14 +79,13 @@ class umtrx_lms6002d_dev: public lms6002d_dev {
 public:
     umtrx_lms6002d_dev(dboard_iface::sptr db_iface) : _db_iface(db_iface) {};
 
-    virtual void write_reg(uint8_t addr, uint8_t data) {
+    virtual void spi_write_reg(uint8_t addr, uint8_t data) {
         if (verbosity>2) printf("db_lms6002d::write_reg(addr=0x%x, data=0x%x)\n", addr, data);
         uint16_t command = (((uint16_t)0x80 | (uint16_t)addr) << 8) | (uint16_t)data;
         _db_iface->write_spi(uhd::usrp::dboard_iface::UNIT_LMS,
                                      spi_config_t::EDGE_RISE, command, 16);
     }
-    virtual uint8_t read_reg(uint8_t addr) {
-        if(addr > 127) return 0; // incorrect address, 7 bit long expected
+    virtual uint8_t spi_read_reg(uint8_t addr) {
         uint8_t data = _db_iface->read_write_spi(uhd::usrp::dboard_iface::UNIT_LMS,
             spi_config_t::EDGE_RISE, addr << 8, 16);
         if (verbosity>2) printf("db_lms6002d::read_reg(addr=0x%x) data=0x%x\n", addr, data);
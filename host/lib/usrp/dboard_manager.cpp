@@ -75,6 +75,15 @@ bool operator==(const dboard_key_t &lhs, const dboard_key_t &rhs){
     return false;
 }
 
+std::size_t hash_value(const dboard_key_t &key){
+    //a non-xcvr key holds the same id for rx and tx
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.is_xcvr());
+    boost::hash_combine(seed, key.is_xcvr()? key.rx_id().to_uint16() : key.xx_id().to_uint16());
+    boost::hash_combine(seed, key.is_xcvr()? key.tx_id().to_uint16() : key.xx_id().to_uint16());
+    return seed;
+}
+
 /***********************************************************************
  * storage and registering for dboards
  **********************************************************************/
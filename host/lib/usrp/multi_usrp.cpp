@@ -356,12 +356,22 @@ public:
         return true;
     }
 
-    void set_command_time(const time_spec_t &, size_t){
-        throw uhd::not_implemented_error("Not implemented yet, but we have a very good idea of how to do it.");
+    void set_command_time(const time_spec_t &time_spec, size_t mboard){
+        if (mboard != ALL_MBOARDS){
+            if (not _tree->exists(mb_root(mboard) / "time/cmd")){
+                throw uhd::not_implemented_error("Timed commands are not supported on this device.");
+            }
+            _tree->access<time_spec_t>(mb_root(mboard) / "time/cmd").set(time_spec);
+            return;
+        }
+        for (size_t m = 0; m < get_num_mboards(); m++){
+            set_command_time(time_spec, m);
+        }
     }
 
-    void clear_command_time(size_t){
-        throw uhd::not_implemented_error("Not implemented yet, but we have a very good idea of how to do it.");
+    void clear_command_time(size_t mboard){
+        //a zero time clears the command time
+        set_command_time(time_spec_t(0.0), mboard);
     }
 
     void issue_stream_cmd(const stream_cmd_t &stream_cmd, size_t chan){
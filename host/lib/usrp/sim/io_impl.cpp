@@ -0,0 +1,382 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "validate_subdev_spec.hpp"
+#include "../../transport/super_recv_packet_handler.hpp"
+#include "../../transport/super_send_packet_handler.hpp"
+#include "sim_impl.hpp"
+#include <uhd/utils/msg.hpp>
+#include <uhd/utils/tasks.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <list>
+
+using namespace uhd;
+using namespace uhd::usrp;
+using namespace uhd::transport;
+
+/***********************************************************************
+ * constants
+ **********************************************************************/
+static const size_t vrt_send_header_offset_words32 = 1;
+
+/***********************************************************************
+ * io impl details (internal to this file)
+ * - the same flow control and async handling as USRP2
+ **********************************************************************/
+struct sim_impl::io_impl{
+
+    io_impl(void):
+        async_msg_fifo(100/*messages deep*/)
+    {
+        /* NOP */
+    }
+
+    ~io_impl(void){
+        //Manually deconstuct the tasks, since this was not happening automatically.
+        pirate_tasks.clear();
+    }
+
+    managed_send_buffer::sptr get_send_buff(size_t chan, double timeout){
+        flow_control_monitor &fc_mon = *fc_mons[chan];
+
+        //wait on flow control w/ timeout
+        if (not fc_mon.check_fc_condition(timeout)) return managed_send_buffer::sptr();
+
+        //get a buffer from the transport w/ timeout
+        return tx_xports[chan]->get_send_buff(timeout);
+    }
+
+    void commit_send_buff(size_t chan, managed_send_buffer &buff, size_t num_bytes){
+        //write the flow control word into the buffer,
+        //only a frame that goes out takes a sequence number
+        buff.cast<boost::uint32_t *>()[0] = uhd::htonx(fc_mons[chan]->get_curr_seq_out());
+        buff.commit(num_bytes);
+    }
+
+    //tx dsp: xports and flow control monitors
+    std::vector<zero_copy_if::sptr> tx_xports;
+    std::vector<flow_control_monitor::sptr> fc_mons;
+
+    //methods and variables for the pirate crew
+    void recv_pirate_loop(zero_copy_if::sptr, size_t);
+    std::list<task::sptr> pirate_tasks;
+    bounded_buffer<async_metadata_t> async_msg_fifo;
+    double tick_rate;
+};
+
+/***********************************************************************
+ * Receive Pirate Loop
+ * - update flow control condition count
+ * - put async message packets into queue
+ **********************************************************************/
+void sim_impl::io_impl::recv_pirate_loop(
+    zero_copy_if::sptr err_xport, size_t index
+){
+    set_thread_priority_safe();
+
+    flow_control_monitor &fc_mon = *(this->fc_mons[index]);
+
+    while (not boost::this_thread::interruption_requested()){
+        managed_recv_buffer::sptr buff = err_xport->get_recv_buff();
+        if (not buff.get()) continue; //ignore timeout buffers
+
+        try{
+            //extract the vrt header packet info
+            vrt::if_packet_info_t if_packet_info;
+            if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
+            const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
+            vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info);
+            if (if_packet_info.sid != SIM_TX_ASYNC_SID or if_packet_info.packet_type == vrt::if_packet_info_t::PACKET_TYPE_DATA) continue;
+
+            //fill in the async metadata
+            async_metadata_t metadata;
+            metadata.channel = index;
+            metadata.has_time_spec = if_packet_info.has_tsi and if_packet_info.has_tsf;
+            metadata.time_spec = time_spec_t(
+                time_t(if_packet_info.tsi), long(if_packet_info.tsf), tick_rate
+            );
+            metadata.event_code = async_metadata_t::event_code_t(sph::get_context_code(vrt_hdr, if_packet_info));
+
+            //catch the flow control packets and react
+            if (metadata.event_code == 0){
+                boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
+                fc_mon.update_fc_condition(uhd::ntohx(fc_word32));
+                continue;
+            }
+            async_msg_fifo.push_with_pop_on_full(metadata);
+
+            if (metadata.event_code &
+                ( async_metadata_t::EVENT_CODE_UNDERFLOW
+                | async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET)
+            ) UHD_MSG(fastpath) << "U";
+            else if (metadata.event_code &
+                ( async_metadata_t::EVENT_CODE_SEQ_ERROR
+                | async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST)
+            ) UHD_MSG(fastpath) << "S";
+            else if (metadata.event_code &
+                async_metadata_t::EVENT_CODE_TIME_ERROR
+            ) UHD_MSG(fastpath) << "L";
+        }catch(const std::exception &e){
+            UHD_MSG(error) << "Error in recv pirate loop: " << e.what() << std::endl;
+        }
+    }
+}
+
+/***********************************************************************
+ * Helper Functions
+ **********************************************************************/
+void sim_impl::io_init(void){
+    //create new io impl
+    _io_impl = UHD_PIMPL_MAKE(io_impl, ());
+    _io_impl->tick_rate = _time->get_tick_rate();
+
+    //init first so we dont have an access race
+    BOOST_FOREACH(sim_tx_dsp::sptr tx_dsp, _tx_dsps){
+        _io_impl->tx_xports.push_back(tx_dsp);
+        _io_impl->fc_mons.push_back(flow_control_monitor::sptr(new flow_control_monitor(
+            SIM_SRAM_BYTES/tx_dsp->get_send_frame_size()
+        )));
+    }
+
+    //allocate streamer weak ptrs containers
+    _rx_streamers.resize(_rx_dsps.size());
+    _tx_streamers.resize(_tx_dsps.size());
+
+    //create a new pirate thread for each tx dsp
+    for (size_t i = 0; i < _tx_dsps.size(); i++){
+        _io_impl->pirate_tasks.push_back(task::make(boost::bind(
+            &sim_impl::io_impl::recv_pirate_loop, _io_impl.get(), _tx_dsps[i], i
+        )));
+    }
+}
+
+void sim_impl::update_tick_rate(const double rate){
+    _io_impl->tick_rate = rate; //shadow for async msg
+
+    //update the tick rate on all existing streamers -> thread safe
+    for (size_t i = 0; i < _rx_streamers.size(); i++){
+        boost::shared_ptr<sph::recv_packet_streamer> my_streamer =
+            boost::dynamic_pointer_cast<sph::recv_packet_streamer>(_rx_streamers[i].lock());
+        if (my_streamer.get() == NULL) continue;
+        my_streamer->set_tick_rate(rate);
+    }
+    for (size_t i = 0; i < _tx_streamers.size(); i++){
+        boost::shared_ptr<sph::send_packet_streamer> my_streamer =
+            boost::dynamic_pointer_cast<sph::send_packet_streamer>(_tx_streamers[i].lock());
+        if (my_streamer.get() == NULL) continue;
+        my_streamer->set_tick_rate(rate);
+    }
+}
+
+void sim_impl::update_rx_samp_rate(const size_t dsp, const double rate){
+    boost::shared_ptr<sph::recv_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<sph::recv_packet_streamer>(_rx_streamers[dsp].lock());
+    if (my_streamer.get() == NULL) return;
+
+    my_streamer->set_samp_rate(rate);
+}
+
+void sim_impl::update_tx_samp_rate(const size_t dsp, const double rate){
+    boost::shared_ptr<sph::send_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<sph::send_packet_streamer>(_tx_streamers[dsp].lock());
+    if (my_streamer.get() == NULL) return;
+
+    my_streamer->set_samp_rate(rate);
+}
+
+uhd::rx_stream_stats_t sim_impl::get_rx_stats(const size_t dsp){
+    boost::shared_ptr<sph::recv_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<sph::recv_packet_streamer>(_rx_streamers[dsp].lock());
+    if (my_streamer.get() == NULL) return uhd::rx_stream_stats_t();
+    return my_streamer->get_stats();
+}
+
+uhd::tx_stream_stats_t sim_impl::get_tx_stats(const size_t dsp){
+    boost::shared_ptr<sph::send_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<sph::send_packet_streamer>(_tx_streamers[dsp].lock());
+    if (my_streamer.get() == NULL) return uhd::tx_stream_stats_t();
+    uhd::tx_stream_stats_t stats = my_streamer->get_stats();
+    stats.fc_wait_ns = _io_impl->fc_mons[dsp]->get_wait_histogram();
+    return stats;
+}
+
+void sim_impl::update_rates(void){
+    const fs_path root = "/mboards/0";
+    _tree->access<double>(root / "tick_rate").update();
+
+    //and now that the tick rate is set, init the host rates to something
+    BOOST_FOREACH(const std::string &name, _tree->list(root / "rx_dsps")){
+        _tree->access<double>(root / "rx_dsps" / name / "rate" / "value").update();
+    }
+    BOOST_FOREACH(const std::string &name, _tree->list(root / "tx_dsps")){
+        _tree->access<double>(root / "tx_dsps" / name / "rate" / "value").update();
+    }
+}
+
+void sim_impl::update_rx_subdev_spec(const subdev_spec_t &spec){
+    validate_subdev_spec(_tree, spec, "rx");
+    if (spec.size() > _rx_dsps.size()) throw uhd::value_error(str(boost::format(
+        "the rx subdevice specification has %u channels, but there are only %u rx dsps"
+    ) % spec.size() % _rx_dsps.size()));
+}
+
+void sim_impl::update_tx_subdev_spec(const subdev_spec_t &spec){
+    validate_subdev_spec(_tree, spec, "tx");
+    if (spec.size() > _tx_dsps.size()) throw uhd::value_error(str(boost::format(
+        "the tx subdevice specification has %u channels, but there are only %u tx dsps"
+    ) % spec.size() % _tx_dsps.size()));
+}
+
+/***********************************************************************
+ * Async Data
+ **********************************************************************/
+bool sim_impl::recv_async_msg(
+    async_metadata_t &async_metadata, double timeout
+){
+    boost::this_thread::disable_interruption di; //disable because the wait can throw
+    return _io_impl->async_msg_fifo.pop_with_timed_wait(async_metadata, timeout);
+}
+
+/***********************************************************************
+ * Receive streamer
+ **********************************************************************/
+rx_streamer::sptr sim_impl::get_rx_stream(const uhd::stream_args_t &args_){
+    stream_args_t args = args_;
+
+    //setup defaults for unspecified values
+    args.otw_format = args.otw_format.empty()? "sc16" : args.otw_format;
+    args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
+
+    //calculate packet size
+    static const size_t hdr_size = 0
+        + vrt::max_if_hdr_words32*sizeof(boost::uint32_t)
+        + sizeof(vrt::if_packet_info_t().tlr) //forced to have trailer
+        - sizeof(vrt::if_packet_info_t().cid) //no class id ever used
+    ;
+    const size_t bpp = _rx_dsps.front()->get_recv_frame_size() - hdr_size;
+    const size_t spp = bpp/convert::get_bytes_per_item(args.otw_format);
+
+    //make the new streamer given the samples per packet
+    boost::shared_ptr<sph::recv_packet_streamer> my_streamer = boost::make_shared<sph::recv_packet_streamer>(spp);
+
+    //init some streamer stuff
+    my_streamer->resize(args.channels.size());
+    my_streamer->set_vrt_unpacker(&vrt::if_hdr_unpack_be);
+
+    //set the converter
+    uhd::convert::id_type id;
+    id.input_format = args.otw_format + "_item32_be";
+    id.num_inputs = 1;
+    id.output_format = args.cpu_format;
+    id.num_outputs = 1;
+    my_streamer->set_converter(id);
+    my_streamer->set_convert_threads(args.args.cast<size_t>("convert_threads", 0));
+
+    //bind callbacks for the handler
+    for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++){
+        const size_t dsp = args.channels[chan_i];
+        if (dsp >= _rx_dsps.size()) throw uhd::index_error(str(boost::format(
+            "the simulated device has no rx channel %u"
+        ) % dsp));
+        _rx_dsps[dsp]->set_nsamps_per_packet(spp);
+        if (not args.args.has_key("noclear")) _rx_dsps[dsp]->clear();
+        _rx_dsps[dsp]->set_format(args.otw_format);
+        my_streamer->set_xport_chan_get_buff(chan_i, boost::bind(
+            &zero_copy_if::get_recv_buff, _rx_dsps[dsp], _1
+        ));
+        _rx_streamers[dsp] = my_streamer; //store weak pointer
+    }
+
+    //sets all tick and samp rates on this streamer
+    this->update_rates();
+
+    //the simulated samples are full scale for the wire format
+    if (args.otw_format == "sc8") my_streamer->set_scale_factor(1/127.);
+
+    return my_streamer;
+}
+
+/***********************************************************************
+ * Transmit streamer
+ **********************************************************************/
+tx_streamer::sptr sim_impl::get_tx_stream(const uhd::stream_args_t &args_){
+    stream_args_t args = args_;
+
+    //setup defaults for unspecified values
+    args.otw_format = args.otw_format.empty()? "sc16" : args.otw_format;
+    args.channels = args.channels.empty()? std::vector<size_t>(1, 0) : args.channels;
+
+    if (args.otw_format != "sc16"){
+        throw uhd::value_error("sim TX cannot handle requested wire format: " + args.otw_format);
+    }
+
+    //calculate packet size
+    static const size_t hdr_size = 0
+        + vrt::max_if_hdr_words32*sizeof(boost::uint32_t)
+        + vrt_send_header_offset_words32*sizeof(boost::uint32_t)
+        - sizeof(vrt::if_packet_info_t().cid) //no class id ever used
+    ;
+    const size_t bpp = _tx_dsps.front()->get_send_frame_size() - hdr_size;
+    const size_t spp = bpp/convert::get_bytes_per_item(args.otw_format);
+
+    //make the new streamer given the samples per packet
+    boost::shared_ptr<sph::send_packet_streamer> my_streamer = boost::make_shared<sph::send_packet_streamer>(spp);
+
+    //init some streamer stuff
+    my_streamer->resize(args.channels.size());
+    my_streamer->set_vrt_packer(&vrt::if_hdr_pack_be, vrt_send_header_offset_words32);
+
+    //set the converter
+    uhd::convert::id_type id;
+    id.input_format = args.cpu_format;
+    id.num_inputs = 1;
+    id.output_format = args.otw_format + "_item32_be";
+    id.num_outputs = 1;
+    my_streamer->set_converter(id);
+
+    //bind callbacks for the handler
+    for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++){
+        const size_t dsp = args.channels[chan_i];
+        if (dsp >= _tx_dsps.size()) throw uhd::index_error(str(boost::format(
+            "the simulated device has no tx channel %u"
+        ) % dsp));
+        if (not args.args.has_key("noclear")){
+            _tx_dsps[dsp]->clear();
+            _io_impl->fc_mons[dsp]->clear();
+        }
+        my_streamer->set_xport_chan_get_buff(chan_i, boost::bind(
+            &sim_impl::io_impl::get_send_buff, _io_impl.get(), dsp, _1
+        ));
+        my_streamer->set_xport_chan_commit(chan_i, boost::bind(
+            &sim_impl::io_impl::commit_send_buff, _io_impl.get(), dsp, _1, _2
+        ));
+        _tx_streamers[dsp] = my_streamer; //store weak pointer
+    }
+
+    //sets all tick and samp rates on this streamer
+    this->update_rates();
+
+    return my_streamer;
+}
@@ -0,0 +1,774 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "sim_dsp.hpp"
+#include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/transport/buffer_pool.hpp>
+#include <uhd/transport/spsc_bounded_buffer.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/exception.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <algorithm>
+#include <cstring>
+#include <complex>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+using namespace uhd;
+using namespace uhd::transport;
+namespace pt = boost::posix_time;
+
+static const size_t DEFAULT_FRAME_SIZE = 1472; //same as a UDP transport
+static const size_t DEFAULT_NUM_FRAMES = 32;
+static const size_t DEFAULT_NUM_ASYNC_FRAMES = 8;
+static const size_t MAX_DECIM = 512;
+static const size_t TONE_PERIOD = 16; //samples per period of the RX test tone
+static const double PI = 3.14159265358979323846;
+
+/***********************************************************************
+ * helpers
+ **********************************************************************/
+static UHD_INLINE pt::time_duration to_time_dur(double timeout){
+    return pt::microseconds(long(timeout*1e6));
+}
+
+static UHD_INLINE boost::uint64_t time_to_ticks(const time_spec_t &time, const double tick_rate){
+    return boost::uint64_t(time.get_full_secs())*boost::uint64_t(tick_rate) + time.get_tick_count(tick_rate);
+}
+
+static UHD_INLINE time_spec_t ticks_to_time(const boost::uint64_t ticks, const double tick_rate){
+    const boost::uint64_t rate = boost::uint64_t(tick_rate);
+    return time_spec_t(time_t(ticks/rate), long(ticks%rate), tick_rate);
+}
+
+static size_t rate_to_decim(const double rate, const double tick_rate){
+    const int decim = boost::math::iround(tick_rate/rate);
+    return std::max<size_t>(1, std::min<size_t>(MAX_DECIM, size_t(std::max(decim, 1))));
+}
+
+static meta_range_t decim_rates(const double tick_rate){
+    meta_range_t range;
+    for (size_t decim = MAX_DECIM; decim >= 1; decim--){
+        range.push_back(range_t(tick_rate/decim));
+    }
+    return range;
+}
+
+/***********************************************************************
+ * Reusable managed buffers over the frames of a buffer pool:
+ * Release and commit return the frame to the free list.
+ **********************************************************************/
+class sim_mrb : public managed_recv_buffer{
+public:
+    sim_mrb(void *mem, spsc_bounded_buffer<sim_mrb *> &free_buffs, spin_lock &release_lock):
+        _mem(mem), _len(0), _free_buffs(free_buffs), _release_lock(release_lock){/* NOP */}
+
+    void release(void){
+        //a recv view may release its buffers on another thread
+        spin_lock::scoped_lock lock(_release_lock);
+        _free_buffs.push_with_haste(this);
+    }
+
+    sptr get_new(size_t len){
+        _len = len;
+        return make_managed_buffer(this);
+    }
+
+    template <class T> T cast(void) const{return static_cast<T>(_mem);}
+
+private:
+    const void *get_buff(void) const{return _mem;}
+    size_t get_size(void) const{return _len;}
+
+    void *_mem;
+    size_t _len;
+    spsc_bounded_buffer<sim_mrb *> &_free_buffs;
+    spin_lock &_release_lock;
+};
+
+class sim_msb : public managed_send_buffer{
+public:
+    typedef boost::function<void(const void *, size_t)> handler_type;
+
+    sim_msb(void *mem, size_t len, spsc_bounded_buffer<sim_msb *> &free_buffs, const handler_type &handler):
+        _mem(mem), _len(len), _free_buffs(free_buffs), _handler(handler){/* NOP */}
+
+    void commit(size_t len){
+        if (len != 0) _handler(_mem, len);
+        _free_buffs.push_with_haste(this);
+    }
+
+    sptr get_new(void){
+        return make_managed_buffer(this);
+    }
+
+private:
+    void *get_buff(void) const{return _mem;}
+    size_t get_size(void) const{return _len;}
+
+    void *_mem;
+    size_t _len;
+    spsc_bounded_buffer<sim_msb *> &_free_buffs;
+    handler_type _handler;
+};
+
+/***********************************************************************
+ * A set of recv frames with their free list
+ **********************************************************************/
+struct sim_recv_frames{
+    sim_recv_frames(const size_t num_frames, const size_t frame_size):
+        pool(buffer_pool::make(num_frames, frame_size)),
+        free_buffs(num_frames),
+        frame_size(frame_size)
+    {
+        for (size_t i = 0; i < num_frames; i++){
+            mrbs.push_back(boost::shared_ptr<sim_mrb>(new sim_mrb(pool->at(i), free_buffs, release_lock)));
+            free_buffs.push_with_haste(mrbs.back().get());
+        }
+    }
+
+    buffer_pool::sptr pool;
+    spsc_bounded_buffer<sim_mrb *> free_buffs;
+    spin_lock release_lock; //serializes the releases onto the free list
+    std::vector<boost::shared_ptr<sim_mrb> > mrbs;
+    const size_t frame_size;
+};
+
+/***********************************************************************
+ * Time core implementation
+ **********************************************************************/
+class sim_time_core_impl : public sim_time_core{
+public:
+    sim_time_core_impl(const double tick_rate):
+        _tick_rate(tick_rate), _pps_pending(false)
+    {
+        this->set_time_now(time_spec_t(0.0));
+    }
+
+    void set_tick_rate(const double rate){
+        boost::mutex::scoped_lock lock(_mutex);
+        _tick_rate = rate;
+    }
+
+    double get_tick_rate(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        return _tick_rate;
+    }
+
+    time_spec_t get_time_now(void){
+        const time_spec_t system_now = time_spec_t::get_system_time();
+        boost::mutex::scoped_lock lock(_mutex);
+        this->handle_pps(system_now);
+        return _time_base + (system_now - _system_base);
+    }
+
+    time_spec_t get_time_last_pps(void){
+        const time_spec_t system_now = time_spec_t::get_system_time();
+        boost::mutex::scoped_lock lock(_mutex);
+        this->handle_pps(system_now);
+        return _time_base + (time_spec_t(system_now.get_full_secs()) - _system_base);
+    }
+
+    void set_time_now(const time_spec_t &time){
+        const time_spec_t system_now = time_spec_t::get_system_time();
+        boost::mutex::scoped_lock lock(_mutex);
+        _time_base = time;
+        _system_base = system_now;
+        _pps_pending = false;
+    }
+
+    void set_time_next_pps(const time_spec_t &time){
+        const time_spec_t system_now = time_spec_t::get_system_time();
+        boost::mutex::scoped_lock lock(_mutex);
+        _pps_time = time;
+        _pps_system = time_spec_t(system_now.get_full_secs() + 1);
+        _pps_pending = true;
+    }
+
+private:
+    //latch the time when the pps edge has passed
+    void handle_pps(const time_spec_t &system_now){
+        if (not _pps_pending or system_now < _pps_system) return;
+        _time_base = _pps_time;
+        _system_base = _pps_system;
+        _pps_pending = false;
+    }
+
+    boost::mutex _mutex;
+    double _tick_rate;
+    time_spec_t _time_base, _system_base;
+    bool _pps_pending;
+    time_spec_t _pps_time, _pps_system;
+};
+
+sim_time_core::sptr sim_time_core::make(const double tick_rate){
+    return sptr(new sim_time_core_impl(tick_rate));
+}
+
+/***********************************************************************
+ * RX DSP implementation
+ **********************************************************************/
+class sim_rx_dsp_impl : public sim_rx_dsp{
+public:
+    sim_rx_dsp_impl(sim_time_core::sptr time, const boost::uint32_t sid, const device_addr_t &args):
+        _time(time), _sid(sid),
+        _frames(
+            size_t(args.cast<double>("num_recv_frames", DEFAULT_NUM_FRAMES)),
+            size_t(args.cast<double>("recv_frame_size", DEFAULT_FRAME_SIZE))
+        ),
+        _throttle(args.cast<int>("throttle", 1) != 0),
+        _inject_seq_error(size_t(args.cast<double>("inject_seq_error", 0))),
+        _inject_overflow(size_t(args.cast<double>("inject_overflow", 0))),
+        _inject_time_error(size_t(args.cast<double>("inject_time_error", 0))),
+        _decim(1), _freq(0.0), _nsamps_per_packet(1), _bytes_per_item(4),
+        _streaming(false), _continuous(false), _late_command(false)
+    {
+        this->set_format("sc16");
+        this->clear();
+    }
+
+    size_t get_num_recv_frames(void) const{return _frames.mrbs.size();}
+    size_t get_recv_frame_size(void) const{return _frames.frame_size;}
+
+    managed_recv_buffer::sptr get_recv_buff(double timeout){
+        sim_mrb *mrb = NULL;
+        if (not _frames.free_buffs.pop_with_timed_wait(mrb, timeout)) return managed_recv_buffer::sptr();
+
+        boost::mutex::scoped_lock lock(_mutex);
+        const size_t len = this->generate_packet(lock, mrb->cast<boost::uint32_t *>(), timeout);
+        if (len == 0){
+            lock.unlock();
+            mrb->release();
+            return managed_recv_buffer::sptr();
+        }
+        return mrb->get_new(len);
+    }
+
+    size_t get_num_send_frames(void) const{return 0;}
+    size_t get_send_frame_size(void) const{return 0;}
+
+    managed_send_buffer::sptr get_send_buff(double){
+        throw uhd::not_implemented_error("sim rx dsp has no send buffers");
+    }
+
+    void set_nsamps_per_packet(const size_t nsamps){
+        boost::mutex::scoped_lock lock(_mutex);
+        _nsamps_per_packet = nsamps;
+    }
+
+    void set_format(const std::string &format){
+        if (format != "sc16" and format != "sc8"){
+            throw uhd::value_error("sim rx dsp cannot handle requested wire format: " + format);
+        }
+        boost::mutex::scoped_lock lock(_mutex);
+        _bytes_per_item = (format == "sc16")? 4 : 2;
+
+        //one period of a full scale tone, repeated to cover one frame
+        //so that the payload of any packet is a single copy
+        const size_t num_items = TONE_PERIOD + _frames.frame_size/_bytes_per_item;
+        _tone.resize(num_items*_bytes_per_item);
+        const double full_scale = (format == "sc16")? 32767*0.7 : 127*0.7;
+        for (size_t i = 0; i < num_items; i++){
+            const std::complex<double> samp = std::polar(full_scale, 2*PI*double(i%TONE_PERIOD)/TONE_PERIOD);
+            const boost::int32_t re = boost::math::iround(samp.real());
+            const boost::int32_t im = boost::math::iround(samp.imag());
+            if (format == "sc16"){
+                //item32 be: I in the upper half, Q in the lower half
+                boost::uint32_t *item = reinterpret_cast<boost::uint32_t *>(&_tone[i*4]);
+                *item = uhd::htonx(boost::uint32_t((boost::uint32_t(re) << 16) | (boost::uint32_t(im) & 0xffff)));
+            }
+            else{
+                //item32 be of two samples: I1 Q1 I0 Q0 in byte order
+                _tone[(i^1)*2 + 0] = char(re);
+                _tone[(i^1)*2 + 1] = char(im);
+            }
+        }
+    }
+
+    meta_range_t get_host_rates(void){
+        return decim_rates(_time->get_tick_rate());
+    }
+
+    double set_host_rate(const double rate){
+        const double tick_rate = _time->get_tick_rate();
+        boost::mutex::scoped_lock lock(_mutex);
+        _decim = rate_to_decim(rate, tick_rate);
+        return tick_rate/_decim;
+    }
+
+    double set_freq(const double freq){
+        const double tick_rate = _time->get_tick_rate();
+        _freq = std::max(-tick_rate/2, std::min(tick_rate/2, freq));
+        return _freq;
+    }
+
+    meta_range_t get_freq_range(void){
+        const double tick_rate = _time->get_tick_rate();
+        return meta_range_t(-tick_rate/2, +tick_rate/2);
+    }
+
+    void issue_stream_command(const stream_cmd_t &stream_cmd){
+        const double tick_rate = _time->get_tick_rate();
+        const time_spec_t time_now = _time->get_time_now();
+        boost::mutex::scoped_lock lock(_mutex);
+
+        if (stream_cmd.stream_mode == stream_cmd_t::STREAM_MODE_STOP_CONTINUOUS){
+            _streaming = false;
+            return;
+        }
+
+        _continuous = stream_cmd.stream_mode == stream_cmd_t::STREAM_MODE_START_CONTINUOUS;
+        _eob_at_end = stream_cmd.stream_mode == stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE;
+        _nsamps_left = stream_cmd.num_samps;
+        _start_of_burst = true;
+        _streaming = true;
+
+        //a timed command in the past is reported late and not executed
+        const time_spec_t time = stream_cmd.stream_now? time_now : stream_cmd.time_spec;
+        _late_command = not stream_cmd.stream_now and time < time_now;
+        _next_ticks = time_to_ticks(_late_command? time_now : time, tick_rate);
+
+        lock.unlock();
+        _cond.notify_all();
+    }
+
+    void clear(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _packet_count = 0;
+        _num_packets = 0;
+    }
+
+private:
+    /*!
+     * Generate one packet into the frame, waiting for the simulated time.
+     * \return the packet length in bytes, or 0 on timeout
+     */
+    size_t generate_packet(boost::mutex::scoped_lock &lock, boost::uint32_t *frame, const double timeout){
+        const time_spec_t exit_time = time_spec_t::get_system_time() + time_spec_t(timeout);
+        const double tick_rate = _time->get_tick_rate();
+
+        while (true){
+            //wait for a stream command
+            const double time_left = (exit_time - time_spec_t::get_system_time()).get_real_secs();
+            if (not _streaming){
+                if (time_left <= 0.0) return 0;
+                _cond.timed_wait(lock, to_time_dur(time_left));
+                continue;
+            }
+
+            if (_late_command){
+                _late_command = false;
+                _streaming = false;
+                return this->pack_context(frame, _next_ticks, tick_rate, rx_metadata_t::ERROR_CODE_LATE_COMMAND);
+            }
+
+            //wait for the time of the last sample in the packet
+            const size_t nsamps = this->get_packet_nsamps();
+            const boost::uint64_t end_ticks = _next_ticks + nsamps*_decim;
+            if (_throttle){
+                const double wait = (ticks_to_time(end_ticks, tick_rate) - _time->get_time_now()).get_real_secs();
+                if (wait > 0.0){
+                    if (time_left <= 0.0) return 0;
+                    _cond.timed_wait(lock, to_time_dur(std::min(wait, time_left)));
+                    continue;
+                }
+            }
+
+            _num_packets++;
+
+            //overflow: the samples of this packet are lost and the message is sent in their place
+            if (this->inject(_inject_overflow)){
+                const size_t len = this->pack_context(frame, _next_ticks, tick_rate, rx_metadata_t::ERROR_CODE_OVERFLOW);
+                this->advance(nsamps, end_ticks);
+                return len;
+            }
+
+            //sequence error: the packet is lost on the way to the host
+            if (this->inject(_inject_seq_error)){
+                _packet_count++;
+                _start_of_burst = false;
+                this->advance(nsamps, end_ticks);
+                continue;
+            }
+
+            //time error: the timestamps jump back by one packet
+            if (this->inject(_inject_time_error)){
+                _next_ticks -= std::min<boost::uint64_t>(_next_ticks, nsamps*_decim);
+            }
+
+            return this->pack_data(frame, nsamps, end_ticks, tick_rate);
+        }
+    }
+
+    size_t get_packet_nsamps(void){
+        static const size_t hdr_size = 0
+            + vrt::max_if_hdr_words32*sizeof(boost::uint32_t)
+            + sizeof(vrt::if_packet_info_t().tlr) //always has a trailer
+            - sizeof(vrt::if_packet_info_t().cid) //never has a class id
+        ;
+        const size_t max_nsamps = (_frames.frame_size - hdr_size)/_bytes_per_item;
+        size_t nsamps = std::min(_nsamps_per_packet, max_nsamps);
+        if (not _continuous) nsamps = std::min(nsamps, _nsamps_left);
+        return std::max<size_t>(nsamps, 1);
+    }
+
+    bool inject(const size_t every){
+        return every != 0 and _num_packets % every == 0;
+    }
+
+    void advance(const size_t nsamps, const boost::uint64_t end_ticks){
+        _next_ticks = end_ticks;
+        if (_continuous) return;
+        _nsamps_left -= std::min(_nsamps_left, nsamps);
+        if (_nsamps_left == 0) _streaming = false;
+    }
+
+    void init_packet_info(vrt::if_packet_info_t &if_packet_info, const boost::uint64_t ticks, const double tick_rate){
+        const boost::uint64_t rate = boost::uint64_t(tick_rate);
+        if_packet_info.packet_count = _packet_count++;
+        if_packet_info.has_sid = true;
+        if_packet_info.sid = _sid;
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tsi = true;
+        if_packet_info.has_tsf = true;
+        if_packet_info.tsi = boost::uint32_t(ticks/rate);
+        if_packet_info.tsf = ticks%rate;
+        if_packet_info.has_tlr = true;
+        if_packet_info.tlr = 0;
+        if_packet_info.sob = false;
+        if_packet_info.eob = false;
+    }
+
+    size_t pack_context(boost::uint32_t *frame, const boost::uint64_t ticks, const double tick_rate, const boost::uint32_t code){
+        vrt::if_packet_info_t if_packet_info;
+        this->init_packet_info(if_packet_info, ticks, tick_rate);
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_CONTEXT;
+        if_packet_info.num_payload_words32 = 1;
+        if_packet_info.num_payload_bytes = sizeof(boost::uint32_t);
+        vrt::if_hdr_pack_be(frame, if_packet_info);
+        frame[if_packet_info.num_header_words32] = uhd::htonx(code);
+        return if_packet_info.num_packet_words32*sizeof(boost::uint32_t);
+    }
+
+    size_t pack_data(boost::uint32_t *frame, const size_t nsamps, const boost::uint64_t end_ticks, const double tick_rate){
+        vrt::if_packet_info_t if_packet_info;
+        this->init_packet_info(if_packet_info, _next_ticks, tick_rate);
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        if_packet_info.num_payload_bytes = nsamps*_bytes_per_item;
+        if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3)/sizeof(boost::uint32_t);
+        if_packet_info.sob = _start_of_burst;
+        _start_of_burst = false;
+
+        //copy the tone, continuing the phase of the last packet
+        //(sc8 keeps the sample pairs of an item, so the offset is even)
+        size_t tone_offset = (_next_ticks/_decim)%TONE_PERIOD;
+        if (_bytes_per_item == 2) tone_offset &= ~size_t(1);
+        this->advance(nsamps, end_ticks);
+        if_packet_info.eob = _eob_at_end and not _streaming;
+
+        vrt::if_hdr_pack_be(frame, if_packet_info);
+        std::memcpy(
+            frame + if_packet_info.num_header_words32,
+            &_tone[tone_offset*_bytes_per_item], if_packet_info.num_payload_bytes
+        );
+        return if_packet_info.num_packet_words32*sizeof(boost::uint32_t);
+    }
+
+    sim_time_core::sptr _time;
+    const boost::uint32_t _sid;
+    sim_recv_frames _frames;
+    const bool _throttle;
+    const size_t _inject_seq_error, _inject_overflow, _inject_time_error;
+
+    boost::mutex _mutex;
+    boost::condition _cond;
+    size_t _decim;
+    double _freq;
+    size_t _nsamps_per_packet, _bytes_per_item;
+    std::vector<char> _tone;
+
+    //stream state
+    bool _streaming, _continuous, _eob_at_end, _start_of_burst, _late_command;
+    size_t _nsamps_left, _packet_count, _num_packets;
+    boost::uint64_t _next_ticks;
+};
+
+sim_rx_dsp::sptr sim_rx_dsp::make(sim_time_core::sptr time, const boost::uint32_t sid, const device_addr_t &args){
+    return sptr(new sim_rx_dsp_impl(time, sid, args));
+}
+
+/***********************************************************************
+ * TX DSP implementation
+ **********************************************************************/
+class sim_tx_dsp_impl : public sim_tx_dsp{
+public:
+    sim_tx_dsp_impl(sim_time_core::sptr time, const boost::uint32_t sid, const device_addr_t &args):
+        _time(time), _sid(sid),
+        _async_frames(DEFAULT_NUM_ASYNC_FRAMES, DEFAULT_FRAME_SIZE),
+        _send_frame_size(size_t(args.cast<double>("send_frame_size", DEFAULT_FRAME_SIZE))),
+        _send_pool(buffer_pool::make(size_t(args.cast<double>("num_send_frames", DEFAULT_NUM_FRAMES)), _send_frame_size)),
+        _free_msbs(_send_pool->size()),
+        _throttle(args.cast<int>("throttle", 1) != 0),
+        _decim(1), _freq(0.0), _updates(1)
+    {
+        for (size_t i = 0; i < _send_pool->size(); i++){
+            _msbs.push_back(boost::shared_ptr<sim_msb>(new sim_msb(
+                _send_pool->at(i), _send_frame_size, _free_msbs,
+                boost::bind(&sim_tx_dsp_impl::handle_packet, this, _1, _2)
+            )));
+            _free_msbs.push_with_haste(_msbs.back().get());
+        }
+        this->clear();
+    }
+
+    size_t get_num_recv_frames(void) const{return _async_frames.mrbs.size();}
+    size_t get_recv_frame_size(void) const{return _async_frames.frame_size;}
+
+    //! The async reports, polled by the host
+    managed_recv_buffer::sptr get_recv_buff(double timeout){
+        sim_mrb *mrb = NULL;
+        if (not _async_frames.free_buffs.pop_with_timed_wait(mrb, timeout)) return managed_recv_buffer::sptr();
+
+        boost::mutex::scoped_lock lock(_mutex);
+        const size_t len = this->generate_report(lock, mrb->cast<boost::uint32_t *>(), timeout);
+        if (len == 0){
+            lock.unlock();
+            mrb->release();
+            return managed_recv_buffer::sptr();
+        }
+        return mrb->get_new(len);
+    }
+
+    size_t get_num_send_frames(void) const{return _msbs.size();}
+    size_t get_send_frame_size(void) const{return _send_frame_size;}
+
+    managed_send_buffer::sptr get_send_buff(double timeout){
+        sim_msb *msb = NULL;
+        if (not _free_msbs.pop_with_timed_wait(msb, timeout)) return managed_send_buffer::sptr();
+        return msb->get_new();
+    }
+
+    meta_range_t get_host_rates(void){
+        return decim_rates(_time->get_tick_rate());
+    }
+
+    double set_host_rate(const double rate){
+        const double tick_rate = _time->get_tick_rate();
+        boost::mutex::scoped_lock lock(_mutex);
+        _decim = rate_to_decim(rate, tick_rate);
+        return tick_rate/_decim;
+    }
+
+    double set_freq(const double freq){
+        const double tick_rate = _time->get_tick_rate();
+        _freq = std::max(-tick_rate/2, std::min(tick_rate/2, freq));
+        return _freq;
+    }
+
+    meta_range_t get_freq_range(void){
+        const double tick_rate = _time->get_tick_rate();
+        return meta_range_t(-tick_rate/2, +tick_rate/2);
+    }
+
+    void set_updates(const size_t packets){
+        boost::mutex::scoped_lock lock(_mutex);
+        _updates = std::max<size_t>(packets, 1);
+    }
+
+    void clear(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _packet_count = 0;
+        _in_burst = false;
+        _dropping = false;
+        _num_unacked = 0;
+        _play_ticks = 0;
+        _last_seq_played = 0;
+        _played.clear();
+        _reports.clear();
+    }
+
+private:
+    struct played_type{
+        boost::uint32_t seq;
+        boost::uint64_t end_ticks;
+        bool eob;
+    };
+
+    struct report_type{
+        boost::uint32_t code;
+        boost::uint64_t ticks;
+    };
+
+    void push_report(const boost::uint32_t code, const boost::uint64_t ticks){
+        report_type report;
+        report.code = code;
+        report.ticks = ticks;
+        _reports.push_back(report);
+    }
+
+    //! Called on commit of a send buffer: validate and schedule the packet
+    void handle_packet(const void *mem, size_t len){
+        const boost::uint32_t *words = reinterpret_cast<const boost::uint32_t *>(mem);
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.num_packet_words32 = len/sizeof(boost::uint32_t) - 1;
+        vrt::if_hdr_unpack_be(words + 1, if_packet_info);
+
+        const double tick_rate = _time->get_tick_rate();
+        const boost::uint64_t now_ticks = time_to_ticks(_time->get_time_now(), tick_rate);
+        const size_t nsamps = if_packet_info.num_payload_bytes/sizeof(boost::uint32_t);
+
+        boost::mutex::scoped_lock lock(_mutex);
+
+        //check the packet count
+        if (if_packet_info.packet_count != _packet_count){
+            this->push_report(_in_burst?
+                async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST :
+                async_metadata_t::EVENT_CODE_SEQ_ERROR, now_ticks
+            );
+        }
+        _packet_count = (if_packet_info.packet_count + 1)%16;
+
+        //schedule the packet: a late burst is dropped until the end of burst
+        if (not _in_burst){
+            _in_burst = true;
+            const bool timed = if_packet_info.has_tsi and if_packet_info.has_tsf;
+            _play_ticks = timed?
+                boost::uint64_t(if_packet_info.tsi)*boost::uint64_t(tick_rate) + if_packet_info.tsf : now_ticks;
+            _dropping = _throttle and _play_ticks < now_ticks;
+            if (_dropping) this->push_report(async_metadata_t::EVENT_CODE_TIME_ERROR, _play_ticks);
+        }
+        else if (_throttle and not _dropping and _play_ticks < now_ticks){
+            this->push_report(async_metadata_t::EVENT_CODE_UNDERFLOW, _play_ticks);
+            _play_ticks = now_ticks;
+        }
+        if (not _dropping) _play_ticks += nsamps*_decim;
+        if (if_packet_info.eob) _in_burst = false;
+
+        //the packet is consumed when its last sample was played
+        const bool notify = _played.empty() or not _reports.empty();
+        played_type played;
+        played.seq = uhd::ntohx(words[0]);
+        played.end_ticks = (_throttle and not _dropping)? _play_ticks : 0;
+        played.eob = if_packet_info.eob and not _dropping;
+        _played.push_back(played);
+
+        lock.unlock();
+        if (notify) _cond.notify_one();
+    }
+
+    /*!
+     * Generate one report into the frame, waiting for the played packets.
+     * \return the packet length in bytes, or 0 on timeout
+     */
+    size_t generate_report(boost::mutex::scoped_lock &lock, boost::uint32_t *frame, const double timeout){
+        const time_spec_t exit_time = time_spec_t::get_system_time() + time_spec_t(timeout);
+        const double tick_rate = _time->get_tick_rate();
+
+        while (true){
+            //consume the played packets
+            const boost::uint64_t now_ticks = time_to_ticks(_time->get_time_now(), tick_rate);
+            while (not _played.empty() and _played.front().end_ticks <= now_ticks){
+                _last_seq_played = _played.front().seq;
+                _num_unacked++;
+                if (_played.front().eob){
+                    this->push_report(async_metadata_t::EVENT_CODE_BURST_ACK, _played.front().end_ticks);
+                }
+                _played.pop_front();
+            }
+
+            if (not _reports.empty()){
+                const report_type report = _reports.front();
+                _reports.pop_front();
+                return this->pack_report(frame, report.code, 0, report.ticks, tick_rate);
+            }
+
+            //flow control: ack every few packets and when the fifo runs empty
+            if (_num_unacked >= _updates or (_num_unacked != 0 and _played.empty())){
+                _num_unacked = 0;
+                return this->pack_report(frame, 0, _last_seq_played, now_ticks, tick_rate);
+            }
+
+            double wait = (exit_time - time_spec_t::get_system_time()).get_real_secs();
+            if (wait <= 0.0) return 0;
+            if (not _played.empty()){
+                wait = std::min(wait, (ticks_to_time(_played.front().end_ticks, tick_rate) - _time->get_time_now()).get_real_secs());
+            }
+            _cond.timed_wait(lock, to_time_dur(std::max(wait, 0.0)));
+        }
+    }
+
+    size_t pack_report(
+        boost::uint32_t *frame, const boost::uint32_t code, const boost::uint32_t seq,
+        const boost::uint64_t ticks, const double tick_rate
+    ){
+        const boost::uint64_t rate = boost::uint64_t(tick_rate);
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_CONTEXT;
+        if_packet_info.packet_count = 0;
+        if_packet_info.has_sid = true;
+        if_packet_info.sid = _sid;
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tsi = true;
+        if_packet_info.has_tsf = true;
+        if_packet_info.tsi = boost::uint32_t(ticks/rate);
+        if_packet_info.tsf = ticks%rate;
+        if_packet_info.has_tlr = false;
+        if_packet_info.sob = false;
+        if_packet_info.eob = false;
+        if_packet_info.num_payload_words32 = 2;
+        if_packet_info.num_payload_bytes = 2*sizeof(boost::uint32_t);
+        vrt::if_hdr_pack_be(frame, if_packet_info);
+        frame[if_packet_info.num_header_words32 + 0] = uhd::htonx(code);
+        frame[if_packet_info.num_header_words32 + 1] = uhd::htonx(seq);
+        return if_packet_info.num_packet_words32*sizeof(boost::uint32_t);
+    }
+
+    sim_time_core::sptr _time;
+    const boost::uint32_t _sid;
+    sim_recv_frames _async_frames;
+    const size_t _send_frame_size;
+    buffer_pool::sptr _send_pool;
+    spsc_bounded_buffer<sim_msb *> _free_msbs;
+    std::vector<boost::shared_ptr<sim_msb> > _msbs;
+    const bool _throttle;
+
+    boost::mutex _mutex;
+    boost::condition _cond;
+    size_t _decim;
+    double _freq;
+    size_t _updates;
+
+    //burst and flow control state
+    size_t _packet_count, _num_unacked;
+    bool _in_burst, _dropping;
+    boost::uint64_t _play_ticks;
+    boost::uint32_t _last_seq_played;
+    std::deque<played_type> _played;
+    std::deque<report_type> _reports;
+};
+
+sim_tx_dsp::sptr sim_tx_dsp::make(sim_time_core::sptr time, const boost::uint32_t sid, const device_addr_t &args){
+    return sptr(new sim_tx_dsp_impl(time, sid, args));
+}
@@ -0,0 +1,128 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_LIBUHD_USRP_SIM_DSP_HPP
+#define INCLUDED_LIBUHD_USRP_SIM_DSP_HPP
+
+#include <uhd/config.hpp>
+#include <uhd/transport/zero_copy.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <uhd/types/ranges.hpp>
+#include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/utility.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/cstdint.hpp>
+#include <string>
+
+/*!
+ * The simulated device time, shared by the DSPs of the motherboard.
+ * The time advances with the host system clock.
+ */
+class sim_time_core : boost::noncopyable{
+public:
+    typedef boost::shared_ptr<sim_time_core> sptr;
+
+    static sptr make(const double tick_rate);
+
+    virtual void set_tick_rate(const double rate) = 0;
+
+    virtual double get_tick_rate(void) = 0;
+
+    virtual uhd::time_spec_t get_time_now(void) = 0;
+
+    virtual uhd::time_spec_t get_time_last_pps(void) = 0;
+
+    virtual void set_time_now(const uhd::time_spec_t &time) = 0;
+
+    //! PPS edges are simulated at every whole second of the system clock
+    virtual void set_time_next_pps(const uhd::time_spec_t &time) = 0;
+};
+
+/*!
+ * A simulated RX DSP:
+ * The DSP is also the in-memory transport that carries its samples.
+ * Each get_recv_buff() generates one VRT packet (big endian, like USRP2)
+ * when the simulated time reaches the last sample in the packet.
+ *
+ * Recognized args (all optional):
+ *  - throttle: 0 to generate packets as fast as they are read
+ *  - inject_seq_error: drop every Nth packet (a sequence gap)
+ *  - inject_overflow: replace every Nth packet with an overflow message
+ *  - inject_time_error: step the time back by one packet every Nth packet
+ *  - recv_frame_size, num_recv_frames: the transport frames
+ */
+class sim_rx_dsp : public uhd::transport::zero_copy_if{
+public:
+    typedef boost::shared_ptr<sim_rx_dsp> sptr;
+
+    static sptr make(sim_time_core::sptr time, const boost::uint32_t sid, const uhd::device_addr_t &args);
+
+    virtual void set_nsamps_per_packet(const size_t nsamps) = 0;
+
+    //! Set the wire format: sc16 or sc8
+    virtual void set_format(const std::string &format) = 0;
+
+    virtual uhd::meta_range_t get_host_rates(void) = 0;
+
+    virtual double set_host_rate(const double rate) = 0;
+
+    virtual double set_freq(const double freq) = 0;
+
+    virtual uhd::meta_range_t get_freq_range(void) = 0;
+
+    virtual void issue_stream_command(const uhd::stream_cmd_t &stream_cmd) = 0;
+
+    //! Reset the packet count, Ex: when a streamer is created
+    virtual void clear(void) = 0;
+};
+
+/*!
+ * A simulated TX DSP:
+ * The send side of the transport consumes VRT packets (big endian,
+ * with the flow control sequence in the word before the header).
+ * The receive side yields async report packets: flow control ACKs,
+ * burst ACKs, and sequence, time, and underflow errors.
+ * A throttled DSP plays the samples out at the sample rate,
+ * and ACKs each packet after its last sample was played.
+ *
+ * Recognized args (all optional):
+ *  - throttle: 0 to consume packets as soon as they are sent
+ *  - send_frame_size, num_send_frames: the transport frames
+ */
+class sim_tx_dsp : public uhd::transport::zero_copy_if{
+public:
+    typedef boost::shared_ptr<sim_tx_dsp> sptr;
+
+    static sptr make(sim_time_core::sptr time, const boost::uint32_t sid, const uhd::device_addr_t &args);
+
+    virtual uhd::meta_range_t get_host_rates(void) = 0;
+
+    virtual double set_host_rate(const double rate) = 0;
+
+    virtual double set_freq(const double freq) = 0;
+
+    virtual uhd::meta_range_t get_freq_range(void) = 0;
+
+    //! Send a flow control ACK after this many consumed packets
+    virtual void set_updates(const size_t packets) = 0;
+
+    //! Reset the sequence and burst state, Ex: when a streamer is created
+    virtual void clear(void) = 0;
+};
+
+#endif /* INCLUDED_LIBUHD_USRP_SIM_DSP_HPP */
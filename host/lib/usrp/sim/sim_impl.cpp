@@ -0,0 +1,276 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "sim_impl.hpp"
+#include <uhd/utils/msg.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/types/ranges.hpp>
+#include <uhd/utils/static.hpp>
+#include <uhd/utils/safe_call.hpp>
+#include <uhd/usrp/mboard_eeprom.hpp>
+#include <uhd/usrp/dboard_eeprom.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
+#include <boost/assign/list_of.hpp>
+#include <algorithm>
+#include <complex>
+#include <cmath>
+
+using namespace uhd;
+using namespace uhd::usrp;
+
+static const double sim_freq_max = 6e9;
+static const uhd::dict<std::string, gain_range_t> sim_gain_ranges = boost::assign::map_list_of
+    ("PGA0", gain_range_t(0, 30, 1))
+;
+
+/***********************************************************************
+ * Discovery
+ **********************************************************************/
+static device_addrs_t sim_find(const device_addr_t &hint){
+    device_addrs_t sim_addrs;
+
+    //the simulated device is only found when asked for by type,
+    //so that it never shows up among the hardware devices
+    if (not hint.has_key("type") or hint["type"] != "sim") return sim_addrs;
+
+    device_addr_t new_addr;
+    new_addr["type"] = "sim";
+    new_addr["name"] = "";
+    new_addr["serial"] = "sim0";
+    if (
+        (not hint.has_key("name")   or hint["name"]   == new_addr["name"]) and
+        (not hint.has_key("serial") or hint["serial"] == new_addr["serial"])
+    ){
+        sim_addrs.push_back(new_addr);
+    }
+    return sim_addrs;
+}
+
+/***********************************************************************
+ * Make
+ **********************************************************************/
+static device::sptr sim_make(const device_addr_t &device_addr){
+    return device::sptr(new sim_impl(device_addr));
+}
+
+UHD_STATIC_BLOCK(register_sim_device){
+    device::register_device(&sim_find, &sim_make);
+}
+
+/***********************************************************************
+ * Frontend helpers:
+ * The simulated frontends only store their settings.
+ **********************************************************************/
+static double clip_freq(const double freq){
+    return freq_range_t(0.0, sim_freq_max).clip(freq);
+}
+
+static double clip_gain(const std::string &name, const double gain){
+    return sim_gain_ranges[name].clip(gain);
+}
+
+static sensor_value_t get_lo_locked(void){
+    return sensor_value_t("LO", true, "locked", "unlocked");
+}
+
+static void make_frontend(property_tree::sptr tree, const fs_path &fe_path, const std::string &name, const std::string &antenna){
+    tree->create<std::string>(fe_path / "name").set(name);
+    tree->create<int>(fe_path / "gains"); //phony property so this dir exists
+    BOOST_FOREACH(const std::string &gain_name, sim_gain_ranges.keys()){
+        tree->create<double>(fe_path / "gains" / gain_name / "value")
+            .coerce(boost::bind(&clip_gain, gain_name, _1))
+            .set(sim_gain_ranges[gain_name].start());
+        tree->create<meta_range_t>(fe_path / "gains" / gain_name / "range")
+            .set(sim_gain_ranges[gain_name]);
+    }
+    tree->create<double>(fe_path / "freq" / "value")
+        .coerce(&clip_freq)
+        .set(0.0);
+    tree->create<meta_range_t>(fe_path / "freq" / "range")
+        .set(freq_range_t(0.0, sim_freq_max));
+    tree->create<std::string>(fe_path / "antenna" / "value").set(antenna);
+    tree->create<std::vector<std::string> >(fe_path / "antenna" / "options")
+        .set(std::vector<std::string>(1, antenna));
+    tree->create<sensor_value_t>(fe_path / "sensors" / "lo_locked")
+        .publish(&get_lo_locked);
+    tree->create<std::string>(fe_path / "connection").set("IQ");
+    tree->create<bool>(fe_path / "enabled").set(false);
+    tree->create<bool>(fe_path / "use_lo_offset").set(false);
+    tree->create<double>(fe_path / "bandwidth" / "value").set(sim_freq_max);
+    tree->create<meta_range_t>(fe_path / "bandwidth" / "range")
+        .set(freq_range_t(sim_freq_max, sim_freq_max));
+}
+
+/***********************************************************************
+ * Structors
+ **********************************************************************/
+sim_impl::sim_impl(const device_addr_t &device_addr){
+    UHD_MSG(status) << "Opening a simulated device..." << std::endl;
+
+    const size_t num_rx_dsps = device_addr.cast<size_t>("num_rx_dsps", 2);
+    const size_t num_tx_dsps = device_addr.cast<size_t>("num_tx_dsps", 1);
+    const double tick_rate = device_addr.cast<double>("master_clock_rate", SIM_DEFAULT_TICK_RATE);
+    if (num_rx_dsps == 0 or num_tx_dsps == 0){
+        throw uhd::value_error("the simulated device needs at least one rx and one tx dsp");
+    }
+
+    _tree = property_tree::make();
+    _tree->create<std::string>("/name").set("Simulated Device");
+    const fs_path mb_path = "/mboards/0";
+    _tree->create<std::string>(mb_path / "name").set("SIM");
+    _tree->create<mboard_eeprom_t>(mb_path / "eeprom").set(mboard_eeprom_t());
+
+    ////////////////////////////////////////////////////////////////
+    // create the clock and time
+    ////////////////////////////////////////////////////////////////
+    _time = sim_time_core::make(tick_rate);
+    _tree->create<double>(mb_path / "tick_rate")
+        .set(tick_rate)
+        .coerce(boost::bind(&sim_impl::set_tick_rate, this, _1))
+        .subscribe(boost::bind(&sim_impl::update_tick_rate, this, _1));
+    _tree->create<time_spec_t>(mb_path / "time/now")
+        .publish(boost::bind(&sim_time_core::get_time_now, _time))
+        .subscribe(boost::bind(&sim_time_core::set_time_now, _time, _1));
+    _tree->create<time_spec_t>(mb_path / "time/pps")
+        .publish(boost::bind(&sim_time_core::get_time_last_pps, _time))
+        .subscribe(boost::bind(&sim_time_core::set_time_next_pps, _time, _1));
+    static const std::vector<std::string> time_sources = boost::assign::list_of("none")("external");
+    _tree->create<std::string>(mb_path / "time_source/value");
+    _tree->create<std::vector<std::string> >(mb_path / "time_source/options").set(time_sources);
+    static const std::vector<std::string> clock_sources = boost::assign::list_of("internal")("external");
+    _tree->create<std::string>(mb_path / "clock_source/value");
+    _tree->create<std::vector<std::string> >(mb_path / "clock_source/options").set(clock_sources);
+    _tree->create<sensor_value_t>(mb_path / "sensors/ref_locked")
+        .publish(boost::bind(&sim_impl::get_ref_locked, this));
+
+    ////////////////////////////////////////////////////////////////
+    // create the codecs and mboard frontends
+    ////////////////////////////////////////////////////////////////
+    _tree->create<int>(mb_path / "rx_codecs/A/gains"); //phony property so this dir exists
+    _tree->create<int>(mb_path / "tx_codecs/A/gains"); //phony property so this dir exists
+    _tree->create<std::string>(mb_path / "rx_codecs/A/name").set("Simulated ADC");
+    _tree->create<std::string>(mb_path / "tx_codecs/A/name").set("Simulated DAC");
+
+    _tree->create<subdev_spec_t>(mb_path / "rx_subdev_spec")
+        .subscribe(boost::bind(&sim_impl::update_rx_subdev_spec, this, _1));
+    _tree->create<subdev_spec_t>(mb_path / "tx_subdev_spec")
+        .subscribe(boost::bind(&sim_impl::update_tx_subdev_spec, this, _1));
+
+    const fs_path rx_fe_path = mb_path / "rx_frontends" / "A";
+    const fs_path tx_fe_path = mb_path / "tx_frontends" / "A";
+    _tree->create<std::complex<double> >(rx_fe_path / "dc_offset" / "value")
+        .set(std::complex<double>(0.0, 0.0));
+    _tree->create<bool>(rx_fe_path / "dc_offset" / "enable")
+        .set(false);
+    _tree->create<std::complex<double> >(rx_fe_path / "iq_balance" / "value")
+        .set(std::polar<double>(1.0, 0.0));
+    _tree->create<std::complex<double> >(tx_fe_path / "dc_offset" / "value")
+        .set(std::complex<double>(0.0, 0.0));
+    _tree->create<std::complex<double> >(tx_fe_path / "iq_balance" / "value")
+        .set(std::polar<double>(1.0, 0.0));
+
+    ////////////////////////////////////////////////////////////////
+    // create the dsps
+    ////////////////////////////////////////////////////////////////
+    for (size_t dspno = 0; dspno < num_rx_dsps; dspno++){
+        _rx_dsps.push_back(sim_rx_dsp::make(_time, SIM_RX_SID_BASE + dspno, device_addr));
+        const fs_path rx_dsp_path = mb_path / str(boost::format("rx_dsps/%u") % dspno);
+        _tree->create<meta_range_t>(rx_dsp_path / "rate/range")
+            .publish(boost::bind(&sim_rx_dsp::get_host_rates, _rx_dsps[dspno]));
+        _tree->create<double>(rx_dsp_path / "rate/value")
+            .set(1e6) //some default
+            .coerce(boost::bind(&sim_rx_dsp::set_host_rate, _rx_dsps[dspno], _1))
+            .subscribe(boost::bind(&sim_impl::update_rx_samp_rate, this, dspno, _1));
+        _tree->create<double>(rx_dsp_path / "freq/value")
+            .coerce(boost::bind(&sim_rx_dsp::set_freq, _rx_dsps[dspno], _1));
+        _tree->create<meta_range_t>(rx_dsp_path / "freq/range")
+            .publish(boost::bind(&sim_rx_dsp::get_freq_range, _rx_dsps[dspno]));
+        _tree->create<stream_cmd_t>(rx_dsp_path / "stream_cmd")
+            .subscribe(boost::bind(&sim_rx_dsp::issue_stream_command, _rx_dsps[dspno], _1));
+        _tree->create<rx_stream_stats_t>(rx_dsp_path / "stats")
+            .publish(boost::bind(&sim_impl::get_rx_stats, this, dspno));
+    }
+
+    for (size_t dspno = 0; dspno < num_tx_dsps; dspno++){
+        _tx_dsps.push_back(sim_tx_dsp::make(_time, SIM_TX_ASYNC_SID, device_addr));
+        const fs_path tx_dsp_path = mb_path / str(boost::format("tx_dsps/%u") % dspno);
+        _tree->create<meta_range_t>(tx_dsp_path / "rate/range")
+            .publish(boost::bind(&sim_tx_dsp::get_host_rates, _tx_dsps[dspno]));
+        _tree->create<double>(tx_dsp_path / "rate/value")
+            .set(1e6) //some default
+            .coerce(boost::bind(&sim_tx_dsp::set_host_rate, _tx_dsps[dspno], _1))
+            .subscribe(boost::bind(&sim_impl::update_tx_samp_rate, this, dspno, _1));
+        _tree->create<double>(tx_dsp_path / "freq/value")
+            .coerce(boost::bind(&sim_tx_dsp::set_freq, _tx_dsps[dspno], _1));
+        _tree->create<meta_range_t>(tx_dsp_path / "freq/range")
+            .publish(boost::bind(&sim_tx_dsp::get_freq_range, _tx_dsps[dspno]));
+        _tree->create<tx_stream_stats_t>(tx_dsp_path / "stats")
+            .publish(boost::bind(&sim_impl::get_tx_stats, this, dspno));
+
+        //setup dsp flow control
+        const double ups_per_fifo = device_addr.cast<double>("ups_per_fifo", 8.0);
+        _tx_dsps[dspno]->set_updates(size_t(SIM_SRAM_BYTES/ups_per_fifo/_tx_dsps[dspno]->get_send_frame_size()));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    // create the dboard frontends: one per dsp
+    ////////////////////////////////////////////////////////////////
+    const fs_path db_path = mb_path / "dboards/A";
+    _tree->create<dboard_eeprom_t>(db_path / "rx_eeprom").set(dboard_eeprom_t());
+    _tree->create<dboard_eeprom_t>(db_path / "tx_eeprom").set(dboard_eeprom_t());
+    _tree->create<dboard_eeprom_t>(db_path / "gdb_eeprom").set(dboard_eeprom_t());
+    for (size_t i = 0; i < num_rx_dsps; i++){
+        make_frontend(_tree, db_path / "rx_frontends" / str(boost::format("%u") % i), "Simulated RX", "RX");
+    }
+    for (size_t i = 0; i < num_tx_dsps; i++){
+        make_frontend(_tree, db_path / "tx_frontends" / str(boost::format("%u") % i), "Simulated TX", "TX");
+    }
+
+    //initialize io handling
+    this->io_init();
+
+    //do some post-init tasks
+    this->update_rates();
+    std::string rx_spec, tx_spec;
+    BOOST_FOREACH(const std::string &name, _tree->list(db_path / "rx_frontends")){
+        rx_spec += (rx_spec.empty()? "A:" : " A:") + name;
+    }
+    BOOST_FOREACH(const std::string &name, _tree->list(db_path / "tx_frontends")){
+        tx_spec += (tx_spec.empty()? "A:" : " A:") + name;
+    }
+    _tree->access<subdev_spec_t>(mb_path / "rx_subdev_spec").set(subdev_spec_t(rx_spec));
+    _tree->access<subdev_spec_t>(mb_path / "tx_subdev_spec").set(subdev_spec_t(tx_spec));
+    _tree->access<std::string>(mb_path / "clock_source/value").set("internal");
+    _tree->access<std::string>(mb_path / "time_source/value").set("none");
+}
+
+sim_impl::~sim_impl(void){
+    /* NOP */
+}
+
+sensor_value_t sim_impl::get_ref_locked(void){
+    return sensor_value_t("Ref", true, "locked", "unlocked");
+}
+
+double sim_impl::set_tick_rate(const double rate){
+    //timestamps are integer ticks, so is the rate
+    const double tick_rate = std::max(1.0, std::floor(rate + 0.5));
+    _time->set_tick_rate(tick_rate);
+    return tick_rate;
+}
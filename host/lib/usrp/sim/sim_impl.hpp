@@ -0,0 +1,83 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef INCLUDED_SIM_IMPL_HPP
+#define INCLUDED_SIM_IMPL_HPP
+
+#include "sim_dsp.hpp"
+#include "flow_control_monitor.hpp"
+#include <uhd/property_tree.hpp>
+#include <uhd/device.hpp>
+#include <uhd/utils/pimpl.hpp>
+#include <uhd/types/device_addr.hpp>
+#include <uhd/types/sensors.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/usrp/subdev_spec.hpp>
+#include <boost/weak_ptr.hpp>
+#include <vector>
+
+static const double SIM_DEFAULT_TICK_RATE = 100e6;
+static const size_t SIM_SRAM_BYTES = size_t(1 << 20); //same as USRP2
+static const boost::uint32_t SIM_TX_ASYNC_SID = 2;
+static const boost::uint32_t SIM_RX_SID_BASE = 4;
+
+/*!
+ * Simulated device implementation guts:
+ * A motherboard with N RX DSPs and M TX DSPs, each one a frontend,
+ * streaming VRT packets through in-memory transports.
+ * It exercises the whole host streaming stack without hardware.
+ */
+class sim_impl : public uhd::device{
+public:
+    sim_impl(const uhd::device_addr_t &);
+    ~sim_impl(void);
+
+    //the io interface
+    uhd::rx_streamer::sptr get_rx_stream(const uhd::stream_args_t &args);
+    uhd::tx_streamer::sptr get_tx_stream(const uhd::stream_args_t &args);
+    bool recv_async_msg(uhd::async_metadata_t &, double);
+
+private:
+    uhd::property_tree::sptr _tree;
+    sim_time_core::sptr _time;
+    std::vector<sim_rx_dsp::sptr> _rx_dsps;
+    std::vector<sim_tx_dsp::sptr> _tx_dsps;
+    std::vector<boost::weak_ptr<uhd::rx_streamer> > _rx_streamers;
+    std::vector<boost::weak_ptr<uhd::tx_streamer> > _tx_streamers;
+
+    uhd::sensor_value_t get_ref_locked(void);
+    double set_tick_rate(const double rate);
+
+    //device properties interface
+    uhd::property_tree::sptr get_tree(void) const{
+        return _tree;
+    }
+
+    //io impl methods and members
+    UHD_PIMPL_DECL(io_impl) _io_impl;
+    void io_init(void);
+    void update_tick_rate(const double rate);
+    void update_rx_samp_rate(const size_t, const double rate);
+    void update_tx_samp_rate(const size_t, const double rate);
+    uhd::rx_stream_stats_t get_rx_stats(const size_t);
+    uhd::tx_stream_stats_t get_tx_stats(const size_t);
+    void update_rates(void);
+    void update_rx_subdev_spec(const uhd::usrp::subdev_spec_t &);
+    void update_tx_subdev_spec(const uhd::usrp::subdev_spec_t &);
+};
+
+#endif /* INCLUDED_SIM_IMPL_HPP */
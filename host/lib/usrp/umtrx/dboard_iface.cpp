@@ -76,7 +76,9 @@ public:
 
     void write_spi(unit_t spi_device, const spi_config_t &config, boost::uint32_t data, size_t num_bits) {
         if (spi_device == uhd::usrp::dboard_iface::UNIT_LMS) {
-            // Access LMS
+            // Access LMS, the register writes are pipelined,
+            // the next readback or flush collects their ACKs
+            usrp2_iface::scoped_pipelined_writes pipelined(*_iface);
             _iface->write_spi(_lms_spi_number, config, data, num_bits);
         } else if (spi_device == uhd::usrp::dboard_iface::UNIT_SYNT) {
             // Access ADF4350 synthetiser
@@ -17,16 +17,15 @@
 //
 
 #include "validate_subdev_spec.hpp"
+#include "recv_reactor.hpp"
 #include "../../transport/super_recv_packet_handler.hpp"
 #include "../../transport/super_send_packet_handler.hpp"
 #include "umtrx_impl.hpp"
 #include "umtrx_regs.hpp"
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/msg.hpp>
-#include <uhd/utils/tasks.hpp>
 #include <uhd/exception.hpp>
 #include <uhd/utils/byteswap.hpp>
-#include <uhd/utils/thread_priority.hpp>
 #include <uhd/transport/bounded_buffer.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/format.hpp>
@@ -48,7 +47,7 @@ static const size_t vrt_send_header_offset_words32 = 1;
 
 /***********************************************************************
  * io impl details (internal to this file)
- * - pirate crew
+ * - async reactor
  * - alignment buffer
  * - thread loop
  * - vrt packet handler states
@@ -62,108 +61,106 @@ struct umtrx_impl::io_impl {
     }
 
     ~io_impl(void){
-        //Manually deconstuct the tasks, since this was not happening automatically.
-        pirate_tasks.clear();
+        //stop the reactor thread before the members it uses go away
+        async_reactor.reset();
     }
 
     managed_send_buffer::sptr get_send_buff(size_t chan, double timeout){
         flow_control_monitor &fc_mon = *fc_mons[chan];
 
-        //wait on flow control w/ timeout
-        if (not fc_mon.check_fc_condition(timeout)) return managed_send_buffer::sptr();
+        //wait on flow control w/ timeout,
+        //flush deferred sends first so the device can ACK them
+        if (not fc_mon.check_fc_condition(0.0)){
+            tx_xports[chan]->flush_send_buffs();
+            if (not fc_mon.check_fc_condition(timeout)) return managed_send_buffer::sptr();
+        }
 
         //get a buffer from the transport w/ timeout
-        managed_send_buffer::sptr buff = tx_xports[chan]->get_send_buff(timeout);
-
-        //write the flow control word into the buffer
-        if (buff.get()) buff->cast<boost::uint32_t *>()[0] = uhd::htonx(fc_mon.get_curr_seq_out());
+        return tx_xports[chan]->get_send_buff(timeout);
+    }
 
-        return buff;
+    void commit_send_buff(size_t chan, managed_send_buffer &buff, size_t num_bytes){
+        //write the flow control word into the buffer,
+        //only a frame that goes out takes a sequence number
+        buff.cast<boost::uint32_t *>()[0] = uhd::htonx(fc_mons[chan]->get_curr_seq_out());
+        buff.commit(num_bytes);
     }
 
     //tx dsp: xports and flow control monitors
-    std::vector<zero_copy_if::sptr> tx_xports;
+    std::vector<udp_zero_copy::sptr> tx_xports;
     std::vector<flow_control_monitor::sptr> fc_mons;
 
-    //methods and variables for the pirate crew
-    void recv_pirate_loop(zero_copy_if::sptr, size_t);
-    std::list<task::sptr> pirate_tasks;
+    //methods and variables for the async reactor
+    void handle_async_packet(managed_recv_buffer::sptr, size_t);
+    recv_reactor::sptr async_reactor;
     bounded_buffer<async_metadata_t> async_msg_fifo;
     double tick_rate;
 };
 
 /***********************************************************************
- * Receive Pirate Loop
- * - while raiding, loot for message packet
+ * Async packet handler (called on the reactor thread)
  * - update flow control condition count
  * - put async message packets into queue
  **********************************************************************/
-void umtrx_impl::io_impl::recv_pirate_loop(
-    zero_copy_if::sptr err_xport, size_t index
+void umtrx_impl::io_impl::handle_async_packet(
+    managed_recv_buffer::sptr buff, size_t index
 ){
-    set_thread_priority_safe();
-
     //store a reference to the flow control monitor (offset by max dsps)
     flow_control_monitor &fc_mon = *(this->fc_mons[index]);
 
-    while (not boost::this_thread::interruption_requested()){
-        managed_recv_buffer::sptr buff = err_xport->get_recv_buff();
-        if (not buff.get()) continue; //ignore timeout/error buffers
-
-        try{
-            //extract the vrt header packet info
-            vrt::if_packet_info_t if_packet_info;
-            if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
-            const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
-            vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info);
-
-            //handle a tx async report message
-            if ((if_packet_info.sid == USRP2_TX_ASYNC_SID_BASE+0 or if_packet_info.sid == USRP2_TX_ASYNC_SID_BASE+1)
-                and if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA){
-
-                //fill in the async metadata
-                async_metadata_t metadata;
-                metadata.channel = index;
-                metadata.has_time_spec = if_packet_info.has_tsi and if_packet_info.has_tsf;
-                metadata.time_spec = time_spec_t(
-                    time_t(if_packet_info.tsi), size_t(if_packet_info.tsf), tick_rate
-                );
-                metadata.event_code = async_metadata_t::event_code_t(sph::get_context_code(vrt_hdr, if_packet_info));
-
-                //catch the flow control packets and react
-                if (metadata.event_code == 0){
-                    boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
-                    fc_mon.update_fc_condition(uhd::ntohx(fc_word32));
-                    continue;
-                }
-                //else UHD_MSG(often) << "metadata.event_code " << metadata.event_code << std::endl;
-                async_msg_fifo.push_with_pop_on_full(metadata);
-
-                if (metadata.event_code &
-                    ( async_metadata_t::EVENT_CODE_UNDERFLOW
-                    | async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET)
-                ) UHD_MSG(fastpath) << "U";
-                else if (metadata.event_code &
-                    ( async_metadata_t::EVENT_CODE_SEQ_ERROR
-                    | async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST)
-                ) UHD_MSG(fastpath) << "S";
-                else if (metadata.event_code &
-                    async_metadata_t::EVENT_CODE_TIME_ERROR
-                ) UHD_MSG(fastpath) << "L";
+    try{
+        //extract the vrt header packet info
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.num_packet_words32 = buff->size()/sizeof(boost::uint32_t);
+        const boost::uint32_t *vrt_hdr = buff->cast<const boost::uint32_t *>();
+        vrt::if_hdr_unpack_be(vrt_hdr, if_packet_info);
+
+        //handle a tx async report message
+        if ((if_packet_info.sid == USRP2_TX_ASYNC_SID_BASE+0 or if_packet_info.sid == USRP2_TX_ASYNC_SID_BASE+1)
+            and if_packet_info.packet_type != vrt::if_packet_info_t::PACKET_TYPE_DATA){
+
+            //fill in the async metadata
+            async_metadata_t metadata;
+            metadata.channel = index;
+            metadata.has_time_spec = if_packet_info.has_tsi and if_packet_info.has_tsf;
+            metadata.time_spec = time_spec_t(
+                time_t(if_packet_info.tsi), size_t(if_packet_info.tsf), tick_rate
+            );
+            metadata.event_code = async_metadata_t::event_code_t(sph::get_context_code(vrt_hdr, if_packet_info));
+
+            //catch the flow control packets and react
+            if (metadata.event_code == 0){
+                boost::uint32_t fc_word32 = (vrt_hdr + if_packet_info.num_header_words32)[1];
+                fc_mon.update_fc_condition(uhd::ntohx(fc_word32));
+                return;
             }
-            else{
-                //TODO unknown received packet, may want to print error...
-            }
-        }catch(const std::exception &e){
-            UHD_MSG(error) << "Error in recv pirate loop: " << e.what() << std::endl;
+            //else UHD_MSG(often) << "metadata.event_code " << metadata.event_code << std::endl;
+            async_msg_fifo.push_with_pop_on_full(metadata);
+
+            if (metadata.event_code &
+                ( async_metadata_t::EVENT_CODE_UNDERFLOW
+                | async_metadata_t::EVENT_CODE_UNDERFLOW_IN_PACKET)
+            ) UHD_MSG(fastpath) << "U";
+            else if (metadata.event_code &
+                ( async_metadata_t::EVENT_CODE_SEQ_ERROR
+                | async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST)
+            ) UHD_MSG(fastpath) << "S";
+            else if (metadata.event_code &
+                async_metadata_t::EVENT_CODE_TIME_ERROR
+            ) UHD_MSG(fastpath) << "L";
+        }
+        else{
+            //TODO unknown received packet, may want to print error...
         }
+    }catch(const std::exception &e){
+        UHD_MSG(error) << "Error in async packet handler: " << e.what() << std::endl;
     }
 }
 
 /***********************************************************************
  * Helper Functions
  **********************************************************************/
-void umtrx_impl::io_init(void) {
+void umtrx_impl::io_init(const device_addr_t &device_addr) {
     //create new io impl
     _io_impl = UHD_PIMPL_MAKE(io_impl, ());
 
@@ -186,19 +183,18 @@ void umtrx_impl::io_init(void) {
         _mbc[mb].tx_streamers.resize(_mbc[mb].tx_dsps.size());
     }
 
-    //create a new pirate thread for each zc if (yarr!!)
+    //one reactor thread serves the async transports of all boards
+    _io_impl->async_reactor = recv_reactor::make();
     size_t index = 0;
     BOOST_FOREACH(const std::string &mb, _mbc.keys()){
-        //spawn a new pirate to plunder the recv booty
-        _io_impl->pirate_tasks.push_back(task::make(boost::bind(
-            &umtrx_impl::io_impl::recv_pirate_loop, _io_impl.get(),
-            _mbc[mb].tx_dsp_xports[0], index++
-        )));
-        _io_impl->pirate_tasks.push_back(task::make(boost::bind(
-            &umtrx_impl::io_impl::recv_pirate_loop, _io_impl.get(),
-            _mbc[mb].tx_dsp_xports[1], index++
-        )));
+        _io_impl->async_reactor->add_xport(_mbc[mb].tx_dsp_xports[0], boost::bind(
+            &umtrx_impl::io_impl::handle_async_packet, _io_impl.get(), _1, index++
+        ));
+        _io_impl->async_reactor->add_xport(_mbc[mb].tx_dsp_xports[1], boost::bind(
+            &umtrx_impl::io_impl::handle_async_packet, _io_impl.get(), _1, index++
+        ));
     }
+    _io_impl->async_reactor->start(device_addr.cast<int>("reactor_cpu", -1));
 }
 
 void umtrx_impl::update_tick_rate(const double rate){
@@ -239,6 +235,29 @@ void umtrx_impl::update_tx_samp_rate(const std::string &mb, const size_t dsp, co
     my_streamer->set_samp_rate(rate);
 }
 
+uhd::rx_stream_stats_t umtrx_impl::get_rx_stats(const std::string &mb, const size_t dsp){
+    boost::shared_ptr<sph::recv_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<sph::recv_packet_streamer>(_mbc[mb].rx_streamers[dsp].lock());
+    if (my_streamer.get() == NULL) return uhd::rx_stream_stats_t();
+    return my_streamer->get_stats();
+}
+
+uhd::tx_stream_stats_t umtrx_impl::get_tx_stats(const std::string &mb, const size_t dsp){
+    boost::shared_ptr<sph::send_packet_streamer> my_streamer =
+        boost::dynamic_pointer_cast<sph::send_packet_streamer>(_mbc[mb].tx_streamers[dsp].lock());
+    if (my_streamer.get() == NULL) return uhd::tx_stream_stats_t();
+    uhd::tx_stream_stats_t stats = my_streamer->get_stats();
+
+    //the flow control monitors are indexed like the tx transports
+    size_t abs = 0;
+    BOOST_FOREACH(const std::string &name, _mbc.keys()){
+        if (name == mb) break;
+        abs += 2; //assume 2 tx dsp
+    }
+    stats.fc_wait_ns = _io_impl->fc_mons[abs+dsp]->get_wait_histogram();
+    return stats;
+}
+
 void umtrx_impl::update_rates(void){
     BOOST_FOREACH(const std::string &mb, _mbc.keys()){
         fs_path root = "/mboards/" + mb;
@@ -354,6 +373,7 @@ rx_streamer::sptr umtrx_impl::get_rx_stream(const uhd::stream_args_t &args_){
     id.output_format = args.cpu_format;
     id.num_outputs = 1;
     my_streamer->set_converter(id);
+    my_streamer->set_convert_threads(args.args.cast<size_t>("convert_threads", 0));
 
     //bind callbacks for the handler
     for (size_t chan_i = 0; chan_i < args.channels.size(); chan_i++){
@@ -440,6 +460,12 @@ tx_streamer::sptr umtrx_impl::get_tx_stream(const uhd::stream_args_t &args_){
                 my_streamer->set_xport_chan_get_buff(chan_i, boost::bind(
                     &umtrx_impl::io_impl::get_send_buff, _io_impl.get(), abs+dsp, _1
                 ));
+                my_streamer->set_xport_chan_commit(chan_i, boost::bind(
+                    &umtrx_impl::io_impl::commit_send_buff, _io_impl.get(), abs+dsp, _1, _2
+                ));
+                my_streamer->set_xport_chan_flush(chan_i, boost::bind(
+                    &udp_zero_copy::flush_send_buffs, _io_impl->tx_xports[abs+dsp]
+                ));
                 _mbc[mb].tx_streamers[dsp] = my_streamer; //store weak pointer
                 break;
             }
@@ -42,7 +42,7 @@ void lms6002d_dev::dump()
             case 0x6D:
                 continue;
         }
-        printf("reg[0x%02x] = 0x%02x\n", i, read_reg(i));
+        printf("reg[0x%02x] = 0x%02x\n", i, spi_read_reg(i));
     }
 }
 
@@ -70,6 +70,28 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
 
     if (verbosity>0) printf("lms6002d_dev::txrx_pll_tune(ref_clock=%f, out_freq=%f)\n", ref_clock, out_freq);
 
+    // A frequency we've tuned to before: restore the PLL settings
+    // and check that the VCO still locks with the remembered VCOCAP
+    pll_tune_key key;
+    key.reg = reg;
+    key.ref_clock = ref_clock;
+    key.out_freq = out_freq;
+    std::map<pll_tune_key, std::list<pll_tune_entry>::iterator>::iterator cached = _tune_cache_index.find(key);
+    if (cached != _tune_cache_index.end()) {
+        const pll_tune_entry entry = *cached->second;
+        _tune_cache.erase(cached->second);
+        _tune_cache_index.erase(cached);
+        for (int i = 0; i < 4; i++) write_reg(reg + i, entry.regs[i]);
+        lms_write_bits(reg + 0x5, (0x3f << 2), (entry.freqsel << 2)); // FREQSEL[5:0]
+        if (txrx_pll_vtune(reg, entry.vcocap) == 0x00) {
+            if (verbosity>0) printf("Cached FREQSEL=%d VCOCAP=%d ACTUAL_FREQ=%f\n", (int)entry.freqsel, (int)entry.vcocap, entry.actual_freq);
+            _tune_cache.push_front(entry);
+            _tune_cache_index[key] = _tune_cache.begin();
+            return entry.actual_freq;
+        }
+        // The VCO has drifted away, search anew
+    }
+
     // Find frequency range and FREQSEL for the given frequency
     int8_t found_freqsel = -1;
     for (unsigned i = 0; i < (int)sizeof(freqsel) / sizeof(freqsel[0]); i++) {
@@ -93,10 +115,13 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
     if (verbosity>0) printf("FREQSEL=%d VCO_X=%d NINT=%d  NFRAC=%d ACTUAL_FREQ=%f\n\n", (int)found_freqsel, (int)vco_x, (int)nint, (int)nfrac, actual_freq);
 
     // Write NINT, NFRAC
-    write_reg(reg + 0x0, (nint >> 1) & 0xff);    // NINT[8:1]
-    write_reg(reg + 0x1, ((nfrac >> 16) & 0x7f) | ((nint & 0x1) << 7)); //NINT[0] nfrac[22:16]
-    write_reg(reg + 0x2, (nfrac >> 8) & 0xff);  // NFRAC[15:8]
-    write_reg(reg + 0x3, (nfrac) & 0xff);     // NFRAC[7:0]
+    pll_tune_entry entry;
+    entry.key = key;
+    entry.regs[0] = (nint >> 1) & 0xff;                           // NINT[8:1]
+    entry.regs[1] = ((nfrac >> 16) & 0x7f) | ((nint & 0x1) << 7); // NINT[0] nfrac[22:16]
+    entry.regs[2] = (nfrac >> 8) & 0xff;                          // NFRAC[15:8]
+    entry.regs[3] = (nfrac) & 0xff;                               // NFRAC[7:0]
+    for (int i = 0; i < 4; i++) write_reg(reg + i, entry.regs[i]);
     // Write FREQSEL
     lms_write_bits(reg + 0x5, (0x3f << 2), (found_freqsel << 2)); // FREQSEL[5:0]
     // Reset VOVCOREG, OFFDOWN to default
@@ -108,59 +133,88 @@ double lms6002d_dev::txrx_pll_tune(uint8_t reg, double ref_clock, double out_fre
     // DEBUG
     //reg_dump();
 
-    // Poll VOVCO
-    int start_i = -1;
-    int stop_i = -1;
-    enum State { VCO_HIGH, VCO_NORM, VCO_LOW } state = VCO_HIGH;
-    for (int i = 0; i < 64; i++) {
-        // Update VCOCAP
-        lms_write_bits(reg + 0x9, 0x3f, i);
-        //usleep(50);
-
-        int comp = read_reg(reg + 0x0a);
-        switch (comp >> 6) {
-        case 0x02: //HIGH
-            break;
-        case 0x01: //LOW
-            if (state == VCO_NORM) {
-                stop_i = i - 1;
-                state = VCO_LOW;
-                if (verbosity>1) printf("Low\n");
-            }
-            break;
-        case 0x00: //NORMAL
-            if (state == VCO_HIGH) {
-                start_i = i;
-                state = VCO_NORM;
-                if (verbosity>1) printf("Norm\n");
-            }
-            break;
-        default: //ERROR
+    // Tune to the middle of the found VCOCAP range
+    int avg_i = txrx_pll_vcocap_search(reg);
+    if (avg_i == -1) return -1;
+    lms_write_bits(reg + 0x09, 0x3f, avg_i);
+
+    // Remember the tuning, dropping the least recently used one
+    entry.freqsel = found_freqsel;
+    entry.vcocap = avg_i;
+    entry.actual_freq = actual_freq;
+    if (_tune_cache.size() >= tune_cache_size) {
+        _tune_cache_index.erase(_tune_cache.back().key);
+        _tune_cache.pop_back();
+    }
+    _tune_cache.push_front(entry);
+    _tune_cache_index[key] = _tune_cache.begin();
+
+    // Return actual frequency we've tuned to
+    return actual_freq;
+}
+
+uint8_t lms6002d_dev::txrx_pll_vtune(uint8_t reg, int vcocap)
+{
+    // Update VCOCAP
+    lms_write_bits(reg + 0x9, 0x3f, vcocap);
+    //usleep(50);
+    uint8_t comp = read_reg(reg + 0x0a) >> 6;
+    if (verbosity>1) printf("VOVCO[%d]=%x\n", vcocap, comp);
+    return comp;
+}
+
+int lms6002d_dev::txrx_pll_vcocap_search(uint8_t reg)
+{
+    // The comparator reads HIGH, then NORMAL, then LOW as VCOCAP grows,
+    // so bisect for both edges of the NORMAL range instead of polling all 64 values.
+    // Comparator readings, -1 if not read yet
+    int comp[64];
+    for (int i = 0; i < 64; i++) comp[i] = -1;
+
+    // Find the first VCOCAP where the comparator is not HIGH
+    int lo = 0, hi = 64;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        comp[mid] = txrx_pll_vtune(reg, mid);
+        if (comp[mid] == 0x03) {
+            printf("ERROR: Incorrect VCOCAP reading while tuning\n");
+            return -1;
+        }
+        if (comp[mid] == 0x02) lo = mid + 1; //HIGH
+        else hi = mid;
+    }
+    int start_i = lo;
+
+    // Find the first VCOCAP where the comparator is LOW
+    hi = 64;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (comp[mid] == -1) comp[mid] = txrx_pll_vtune(reg, mid);
+        if (comp[mid] == 0x03) {
             printf("ERROR: Incorrect VCOCAP reading while tuning\n");
             return -1;
         }
-        if (verbosity>1) printf("VOVCO[%d]=%x\n", i, (comp>>6));
+        if (comp[mid] == 0x01) hi = mid; //LOW
+        else lo = mid + 1;
     }
-    if (VCO_NORM == state)
-        stop_i = 63;
+    int stop_i = lo - 1;
 
-    if (start_i == -1 || stop_i == -1) {
+    if (start_i == 64 || stop_i < start_i) {
         printf("ERROR: Can't find VCOCAP value while tuning\n");
         return -1;
     }
 
-    // Tune to the middle of the found VCOCAP range
     int avg_i = (start_i + stop_i) / 2;
     if (verbosity>0) printf("START=%d STOP=%d SET=%d\n", start_i, stop_i, avg_i);
-    lms_write_bits(reg + 0x09, 0x3f, avg_i);
-
-    // Return actual frequency we've tuned to
-    return actual_freq;
+    return avg_i;
 }
 
 void lms6002d_dev::init()
 {
     if (verbosity>0) printf("lms6002d_dev::init()\n");
+    // The chip was just reset, read the register defaults anew
+    invalidate_shadow();
+    clear_tune_cache();
     write_reg(0x09, 0x00); // RXOUTSW (disabled), CLK_EN (all disabled)
     write_reg(0x17, 0xE0);
     write_reg(0x27, 0xE3);
@@ -19,8 +19,11 @@
 #define INCLUDED_LMS6002D_HPP
 
 #include <stdio.h>
+#include <string.h>
 #include <inttypes.h>
 #include <assert.h>
+#include <list>
+#include <map>
 
 /*!
  * LMS6002D control class
@@ -35,8 +38,10 @@ public:
 
     lms6002d_dev()
         :_lpf_rccal(3) // Value recommended by LimeMicro
-    {}
-    ~lms6002d_dev() {}
+    {
+        invalidate_shadow();
+    }
+    virtual ~lms6002d_dev() {}
 
     /** Dump chip registers to console (for debug use only) */
     void dump();
@@ -51,9 +56,57 @@ public:
                                             txrx_interleaving tx_interleaving);
 
     /** Write through SPI */
-    virtual void write_reg(uint8_t addr, uint8_t val) = 0;
+    virtual void spi_write_reg(uint8_t addr, uint8_t val) = 0;
     /** Read through SPI */
-    virtual uint8_t read_reg(uint8_t addr) = 0;
+    virtual uint8_t spi_read_reg(uint8_t addr) = 0;
+
+    /** Write a register through SPI and keep its value in the shadow */
+    void write_reg(uint8_t addr, uint8_t val) {
+        spi_write_reg(addr, val);
+        if (addr < num_regs and not is_volatile_reg(addr)) {
+            _shadow[addr] = val;
+            _shadow_valid[addr] = true;
+        }
+    }
+
+    /** Read a register from the shadow.
+        Only the first read of a register and volatile registers go to SPI. */
+    uint8_t read_reg(uint8_t addr) {
+        if (addr >= num_regs) return 0; // incorrect address, 7 bit long expected
+        if (_shadow_valid[addr]) return _shadow[addr];
+        uint8_t val = spi_read_reg(addr);
+        if (not is_volatile_reg(addr)) {
+            _shadow[addr] = val;
+            _shadow_valid[addr] = true;
+        }
+        return val;
+    }
+
+    /** Forget the shadowed values, ex: after the chip was reset */
+    void invalidate_shadow() {
+        memset(_shadow_valid, 0, sizeof(_shadow_valid));
+    }
+
+    /** Registers with bits the chip changes by itself: status,
+        comparators and calibration results. They are never shadowed. */
+    static bool is_volatile_reg(uint8_t addr) {
+        switch (addr) {
+        case 0x00: case 0x01: // Top DC calibration result, status, RCCAL_LPFCAL
+        case 0x1a: case 0x2a: // Tx/Rx PLL VTUNE comparators
+        case 0x30: case 0x31: // Tx LPF DC calibration result, status
+        case 0x50: case 0x51: // Rx LPF DC calibration result, status
+        case 0x60: case 0x61: // RxVGA2 DC calibration result, status
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    /** Forget the PLL settings remembered by the tuning cache */
+    void clear_tune_cache() {
+        _tune_cache.clear();
+        _tune_cache_index.clear();
+    }
 
     /** Tune TX PLL to a given frequency. */
     double tx_pll_tune(double ref_clock, double out_freq) {
@@ -472,6 +525,13 @@ public:
 protected:
     double txrx_pll_tune(uint8_t reg, double ref_clock, double out_freq);
 
+    /** Set VCOCAP and read the VTUNE comparator, VOVCO[1:0] */
+    uint8_t txrx_pll_vtune(uint8_t reg, int vcocap);
+
+    /** Bisect VCOCAP for the range where the VTUNE comparator reads normal.
+        Returns the middle of the range or -1 on error. */
+    int txrx_pll_vcocap_search(uint8_t reg);
+
     void lms_set_bits(uint8_t address, uint8_t mask) {
         write_reg(address, read_reg(address) | (mask));
     }
@@ -490,6 +550,32 @@ protected:
 
     uint8_t _lpf_rccal;  // Saved value for RCCAL_LPFCAL
 
+    // Write-through shadow of the register map
+    static const uint8_t num_regs = 128;
+    uint8_t _shadow[num_regs];
+    bool _shadow_valid[num_regs];
+
+    // LRU cache of the PLL settings per PLL, reference clock and frequency,
+    // the most recently used tuning is at the front of the list
+    struct pll_tune_key {
+        uint8_t reg;
+        double ref_clock, out_freq;
+        bool operator<(const pll_tune_key &rhs) const {
+            if (reg != rhs.reg) return reg < rhs.reg;
+            if (ref_clock != rhs.ref_clock) return ref_clock < rhs.ref_clock;
+            return out_freq < rhs.out_freq;
+        }
+    };
+    struct pll_tune_entry {
+        pll_tune_key key;
+        uint8_t regs[4]; // NINT, NFRAC
+        uint8_t freqsel, vcocap;
+        double actual_freq;
+    };
+    static const size_t tune_cache_size = 128; // LRU over both PLLs and all ref clocks: holds a hopping set, not a whole band
+    std::list<pll_tune_entry> _tune_cache;
+    std::map<pll_tune_key, std::list<pll_tune_entry>::iterator> _tune_cache_index;
+
 };
 
 #endif /* INCLUDED_LMS6002D_HPP */
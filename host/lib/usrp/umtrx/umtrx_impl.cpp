@@ -69,7 +69,7 @@ UHD_STATIC_BLOCK(register_umtrx_device){
  * Helpers
  **********************************************************************/
 
-static zero_copy_if::sptr make_xport(
+static udp_zero_copy::sptr make_xport(
     const std::string &addr,
     const std::string &port,
     const device_addr_t &hints,
@@ -84,7 +84,7 @@ static zero_copy_if::sptr make_xport(
     }
 
     //make the transport object with the filtered hints
-    zero_copy_if::sptr xport = udp_zero_copy::make(addr, port, filtered_hints);
+    udp_zero_copy::sptr xport = udp_zero_copy::make(addr, port, filtered_hints);
 
     //Send a small data packet so the umtrx knows the udp source port.
     //This setup must happen before further initialization occurs
@@ -96,6 +96,7 @@ static zero_copy_if::sptr make_xport(
     transport::managed_send_buffer::sptr send_buff = xport->get_send_buff();
     std::memcpy(send_buff->cast<void*>(), &data, sizeof(data));
     send_buff->commit(sizeof(data));
+    xport->flush_send_buffs();
 
     return xport;
 }
@@ -285,6 +286,8 @@ umtrx_impl::umtrx_impl(const device_addr_t &_device_addr)
         ////////////////////////////////////////////////////////////////
         // create frontend control objects
         ////////////////////////////////////////////////////////////////
+        //the frontend and dsp setup is all register writes, pipeline them
+        _mbc[mb].iface->set_pipelined_writes(true);
         _mbc[mb].rx_fes.push_back(rx_frontend_core_200::make(
             _mbc[mb].iface, U2_REG_SR_ADDR(SR_RX_FRONT0)
         ));
@@ -352,6 +355,8 @@ umtrx_impl::umtrx_impl(const device_addr_t &_device_addr)
                 .publish(boost::bind(&rx_dsp_core_200::get_freq_range, _mbc[mb].rx_dsps[dspno]));
             _tree->create<stream_cmd_t>(rx_dsp_path / "stream_cmd")
                 .subscribe(boost::bind(&rx_dsp_core_200::issue_stream_command, _mbc[mb].rx_dsps[dspno], _1));
+            _tree->create<rx_stream_stats_t>(rx_dsp_path / "stats")
+                .publish(boost::bind(&umtrx_impl::get_rx_stats, this, mb, dspno));
         }
 
         ////////////////////////////////////////////////////////////////
@@ -378,6 +383,8 @@ umtrx_impl::umtrx_impl(const device_addr_t &_device_addr)
                 .coerce(boost::bind(&tx_dsp_core_200::set_freq, _mbc[mb].tx_dsps[dspno], _1));
             _tree->create<meta_range_t>(tx_dsp_path / "freq/range")
                 .publish(boost::bind(&tx_dsp_core_200::get_freq_range, _mbc[mb].tx_dsps[dspno]));
+            _tree->create<tx_stream_stats_t>(tx_dsp_path / "stats")
+                .publish(boost::bind(&umtrx_impl::get_tx_stats, this, mb, dspno));
         }
 
         //setup dsp flow control
@@ -392,6 +399,8 @@ umtrx_impl::umtrx_impl(const device_addr_t &_device_addr)
             (ups_per_sec > 0.0)? size_t(get_master_clock_rate()/*approx tick rate*//ups_per_sec) : 0,
             (ups_per_fifo > 0.0)? size_t(UMTRX_SRAM_BYTES/ups_per_fifo/send_frame_size) : 0
         );
+        _mbc[mb].iface->set_pipelined_writes(false);
+        _mbc[mb].iface->flush_writes();
 
         ////////////////////////////////////////////////////////////////
         // create time control objects
@@ -412,6 +421,10 @@ umtrx_impl::umtrx_impl(const device_addr_t &_device_addr)
         _tree->create<time_spec_t>(mb_path / "time/pps")
             .publish(boost::bind(&time64_core_200::get_time_last_pps, _mbc[mb].time64))
             .subscribe(boost::bind(&time64_core_200::set_time_next_pps, _mbc[mb].time64, _1));
+        _tree->access<double>(mb_path / "tick_rate")
+            .subscribe(boost::bind(&usrp2_iface::set_tick_rate, _mbc[mb].iface, _1));
+        _tree->create<time_spec_t>(mb_path / "time/cmd")
+            .subscribe(boost::bind(&usrp2_iface::set_command_time, _mbc[mb].iface, _1));
         //setup time source props
         _tree->create<std::string>(mb_path / "time_source/value")
             .subscribe(boost::bind(&time64_core_200::set_time_source, _mbc[mb].time64, _1));
@@ -496,10 +509,13 @@ umtrx_impl::umtrx_impl(const device_addr_t &_device_addr)
                 .subscribe(boost::bind(&umtrx_impl::set_tcxo_dac, this, mb, _1))
                 .set(boost::lexical_cast<uint16_t>(_mbc[mb].iface->mb_eeprom["tcxo-dac"]));
         }
+
+        //collect the ACKs of the pipelined LMS writes
+        _mbc[mb].iface->flush_writes();
     }
 
     //initialize io handling
-    this->io_init();
+    this->io_init(device_addr);
 
     //do some post-init tasks
     this->update_rates();
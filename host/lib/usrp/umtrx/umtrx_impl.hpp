@@ -36,6 +36,7 @@
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/dict.hpp>
 #include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/stream_stats.hpp>
 #include <uhd/types/clock_config.hpp>
 #include <uhd/usrp/dboard_eeprom.hpp>
 #include <boost/shared_ptr.hpp>
@@ -92,7 +93,7 @@ private:
         std::vector<tx_dsp_core_200::sptr> tx_dsps;
         time64_core_200::sptr time64;
         std::vector<uhd::transport::zero_copy_if::sptr> rx_dsp_xports;
-        std::vector<uhd::transport::zero_copy_if::sptr> tx_dsp_xports;
+        std::vector<uhd::transport::udp_zero_copy::sptr> tx_dsp_xports;
         struct db_container_type{
             uhd::usrp::dboard_iface::sptr dboard_iface;
             uhd::usrp::dboard_manager::sptr dboard_manager;
@@ -124,10 +125,12 @@ private:
 
     //io impl methods and members
     UHD_PIMPL_DECL(io_impl) _io_impl;
-    void io_init(void);
+    void io_init(const uhd::device_addr_t &);
     void update_tick_rate(const double rate);
     void update_rx_samp_rate(const std::string &, const size_t, const double rate);
     void update_tx_samp_rate(const std::string &, const size_t, const double rate);
+    uhd::rx_stream_stats_t get_rx_stats(const std::string &, const size_t);
+    uhd::tx_stream_stats_t get_tx_stats(const std::string &, const size_t);
     void update_rates(void);
     //update spec methods are coercers until we only accept db_name == A
     void update_rx_subdev_spec(const std::string &, const uhd::usrp::subdev_spec_t &);
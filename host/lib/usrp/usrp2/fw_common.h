@@ -95,6 +95,9 @@ typedef enum{
     USRP2_CTRL_ID_HOLLER_AT_ME_BRO = 'l',
     USRP2_CTRL_ID_HOLLER_BACK_DUDE = 'L',
 
+    USRP2_CTRL_ID_DO_THIS_AT_TIME_BRO = 't',
+    USRP2_CTRL_ID_WILL_DO_AT_TIME_DUDE = 'T',
+
     UMTRX_CTRL_ID_ZPU_REQUEST  = 'z',
     UMTRX_CTRL_ID_ZPU_RESPONSE = 'Z',
 
@@ -118,9 +121,13 @@ typedef enum{
     USRP2_REG_ACTION_FPGA_POKE32 = 3,
     USRP2_REG_ACTION_FPGA_POKE16 = 4,
     USRP2_REG_ACTION_FW_PEEK32   = 5,
-    USRP2_REG_ACTION_FW_POKE32   = 6
+    USRP2_REG_ACTION_FW_POKE32   = 6,
+    USRP2_REG_ACTION_SPI_WRITE   = 7  //timed commands only
 } usrp2_reg_action_t;
 
+//timed register writes held in the firmware at once
+#define USRP2_TIMED_CMD_QUEUE_DEPTH 16
+
 typedef enum{
     UMTRX_ZPU_REQUEST_GET_VCTCXO_DAC = 1,
     UMTRX_ZPU_REQUEST_SET_VCTCXO_DAC = 2
@@ -154,6 +161,16 @@ typedef struct{
         struct {
             uint32_t len;
         } echo_args;
+        struct {
+            uint32_t secs;
+            uint32_t ticks;
+            uint32_t addr; //register address or spi slave
+            uint32_t data;
+            uint8_t action; //fpga poke or spi write
+            uint8_t num_bits; //spi write only
+            uint8_t mosi_edge; //spi write only
+            uint8_t queued; //reply: 0 when the queue was full
+        } timed_args;
         struct {
             uint32_t action;
             uint32_t data;
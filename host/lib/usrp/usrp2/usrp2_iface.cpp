@@ -18,6 +18,7 @@
 #include "usrp2_regs.hpp"
 #include "fw_common.h"
 #include "usrp2_iface.hpp"
+#include "../common/timed_cmd_queue.hpp"
 #include <uhd/exception.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/tasks.hpp>
@@ -32,6 +33,7 @@
 #include <boost/tokenizer.hpp>
 #include <boost/functional/hash.hpp>
 #include <algorithm>
+#include <deque>
 #include <iostream>
 #undef NDEBUG //evil hack for debug
 #include <cassert>
@@ -42,6 +44,7 @@ using namespace uhd::transport;
 
 static const double CTRL_RECV_TIMEOUT = 1.0;
 static const size_t CTRL_RECV_RETRIES = 3;
+static const size_t CTRL_PIPELINE_WINDOW = 8; //ACKs outstanding, bounded by the firmware buffering
 
 //custom timeout error for retry logic to catch/retry
 struct timeout_error : uhd::runtime_error
@@ -95,7 +98,10 @@ public:
     usrp2_iface_impl(udp_simple::sptr ctrl_transport):
         _ctrl_transport(ctrl_transport),
         _ctrl_seq_num(0),
-        _protocol_compat(0) //initialized below...
+        _protocol_compat(0), //initialized below...
+        _pipeline_depth(0),
+        _tick_rate(100e6), //updated by the device
+        _timed_cmds(USRP2_TIMED_CMD_QUEUE_DEPTH)
     {
         bool is_umtrx = false;
         //Obtain the firmware's compat number.
@@ -189,6 +195,13 @@ public:
 
     template <class T, usrp2_reg_action_t action>
     T get_reg(wb_addr_type addr, T data = 0){
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+        return this->get_reg_unlocked<T, action>(addr, data);
+    }
+
+    //! Access a register, called with the lock held
+    template <class T, usrp2_reg_action_t action>
+    T get_reg_unlocked(wb_addr_type addr, T data = 0){
         //setup the out data
         usrp2_ctrl_data_t out_data = usrp2_ctrl_data_t();
         out_data.id = htonl(USRP2_CTRL_ID_GET_THIS_REGISTER_FOR_ME_BRO);
@@ -196,8 +209,20 @@ public:
         out_data.data.reg_args.data = htonl(boost::uint32_t(data));
         out_data.data.reg_args.action = action;
 
+        //queue timed fpga writes in the firmware
+        if (_command_time != time_spec_t(0.0) and (action == USRP2_REG_ACTION_FPGA_POKE32 or action == USRP2_REG_ACTION_FPGA_POKE16)){
+            this->ctrl_send_timed(action, addr, boost::uint32_t(data));
+            return data;
+        }
+
+        //pipeline fpga writes, the readback of a poke is not used
+        if (_pipeline_depth != 0 and (action == USRP2_REG_ACTION_FPGA_POKE32 or action == USRP2_REG_ACTION_FPGA_POKE16)){
+            this->ctrl_send_pipelined(out_data, USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE, MIN_PROTO_COMPAT_REG);
+            return data;
+        }
+
         //send and recv
-        usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv(out_data, MIN_PROTO_COMPAT_REG);
+        usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv_unlocked(out_data, MIN_PROTO_COMPAT_REG);
         UHD_ASSERT_THROW(ntohl(in_data.id) == USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE);
         return T(ntohl(in_data.data.reg_args.data));
     }
@@ -227,8 +252,22 @@ public:
         out_data.data.spi_args.num_bits = num_bits;
         out_data.data.spi_args.data = htonl(data);
 
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+
+        //queue timed writes in the firmware
+        if (_command_time != time_spec_t(0.0) and not readback){
+            this->ctrl_send_timed(USRP2_REG_ACTION_SPI_WRITE, which_slave, data, num_bits, spi_edge_to_otw[config.mosi_edge]);
+            return 0;
+        }
+
+        //pipeline writes, there is no readback to wait on
+        if (_pipeline_depth != 0 and not readback){
+            this->ctrl_send_pipelined(out_data, USRP2_CTRL_ID_OMG_TRANSACTED_SPI_DUDE, MIN_PROTO_COMPAT_SPI);
+            return 0;
+        }
+
         //send and recv
-        usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv(out_data, MIN_PROTO_COMPAT_SPI);
+        usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv_unlocked(out_data, MIN_PROTO_COMPAT_SPI);
         UHD_ASSERT_THROW(ntohl(in_data.id) == USRP2_CTRL_ID_OMG_TRANSACTED_SPI_DUDE);
 
         return ntohl(in_data.data.spi_args.data);
@@ -295,6 +334,153 @@ public:
         return ntohl(in_data.data.zpu_action.data);
     }
 
+/***********************************************************************
+ * Timed writes
+ **********************************************************************/
+    void set_command_time(const time_spec_t &time){
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+        _command_time = time;
+    }
+
+    void set_tick_rate(const double rate){
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+        _tick_rate = rate;
+    }
+
+    time_spec_t get_time_now(void){
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+        return this->get_time_now_unlocked();
+    }
+
+    //! Read the device time, called with the lock held
+    time_spec_t get_time_now_unlocked(void){
+        //read the seconds twice to detect a rollover
+        for (size_t i = 0; i < 10; i++){
+            const boost::uint32_t secs = this->get_reg_unlocked<boost::uint32_t, USRP2_REG_ACTION_FPGA_PEEK32>(U2_REG_TIME64_SECS_RB_IMM);
+            const boost::uint32_t ticks = this->get_reg_unlocked<boost::uint32_t, USRP2_REG_ACTION_FPGA_PEEK32>(U2_REG_TIME64_TICKS_RB_IMM);
+            if (secs == this->get_reg_unlocked<boost::uint32_t, USRP2_REG_ACTION_FPGA_PEEK32>(U2_REG_TIME64_SECS_RB_IMM)) return time_spec_t(time_t(secs), long(ticks), _tick_rate);
+        }
+        throw uhd::runtime_error("usrp2_iface: get_time_now - time readback failed");
+    }
+
+    //! Queue a write in the firmware to run at the command time, called with the lock held
+    void ctrl_send_timed(
+        const boost::uint8_t action, const boost::uint32_t addr, const boost::uint32_t data,
+        const size_t num_bits = 0, const boost::uint8_t mosi_edge = USRP2_CLK_EDGE_RISE
+    ){
+        //the mirror of the firmware queue: wait for the device time to free a slot
+        while (_timed_cmds.full()){
+            const time_spec_t now = this->get_time_now_unlocked();
+            if (_timed_cmds.retire(now) != 0) break;
+            boost::this_thread::sleep(boost::posix_time::microseconds(long(_timed_cmds.get_wait(now).get_real_secs()*1e6)));
+        }
+
+        usrp2_ctrl_data_t out_data = usrp2_ctrl_data_t();
+        out_data.id = htonl(USRP2_CTRL_ID_DO_THIS_AT_TIME_BRO);
+        out_data.data.timed_args.secs = htonl(boost::uint32_t(_command_time.get_full_secs()));
+        out_data.data.timed_args.ticks = htonl(boost::uint32_t(_command_time.get_tick_count(_tick_rate)));
+        out_data.data.timed_args.addr = htonl(addr);
+        out_data.data.timed_args.data = htonl(data);
+        out_data.data.timed_args.action = action;
+        out_data.data.timed_args.num_bits = num_bits;
+        out_data.data.timed_args.mosi_edge = mosi_edge;
+
+        usrp2_ctrl_data_t in_data = this->ctrl_send_and_recv_unlocked(out_data, MIN_PROTO_COMPAT_REG);
+        if (ntohl(in_data.id) == USRP2_CTRL_ID_HUH_WHAT) throw uhd::not_implemented_error(
+            "usrp2_iface: timed commands are not supported by the firmware, please update the firmware"
+        );
+        UHD_ASSERT_THROW(ntohl(in_data.id) == USRP2_CTRL_ID_WILL_DO_AT_TIME_DUDE);
+        if (in_data.data.timed_args.queued == 0){
+            _timed_cmds.clear(); //out of sync with the firmware, Ex: another host queued commands
+            throw uhd::runtime_error("usrp2_iface: the timed command queue in the firmware is full");
+        }
+        _timed_cmds.push(_command_time, addr);
+    }
+
+/***********************************************************************
+ * Pipelined writes
+ **********************************************************************/
+    void set_pipelined_writes(const bool enb){
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+        if (enb) _pipeline_depth++;
+        else if (_pipeline_depth != 0) _pipeline_depth--;
+    }
+
+    void flush_writes(void){
+        boost::mutex::scoped_lock lock(_ctrl_mutex);
+        this->ctrl_flush_pending();
+    }
+
+    //! Send without waiting, when the window is full wait for the oldest ACK, called with the lock held
+    void ctrl_send_pipelined(
+        const usrp2_ctrl_data_t &out_data, boost::uint32_t ack_id,
+        boost::uint32_t lo, boost::uint32_t hi = USRP2_FW_COMPAT_NUM
+    ){
+        while (_ctrl_pending.size() >= CTRL_PIPELINE_WINDOW) this->ctrl_retire_pending();
+
+        ctrl_pending_type pending;
+        pending.data = out_data;
+        pending.data.proto_ver = htonl(_protocol_compat);
+        pending.data.seq = htonl(++_ctrl_seq_num);
+        pending.ack_id = ack_id;
+        pending.lo = lo;
+        pending.hi = hi;
+        pending.acked = false;
+        _ctrl_transport->send(boost::asio::buffer(&pending.data, sizeof(usrp2_ctrl_data_t)));
+        _ctrl_pending.push_back(pending);
+    }
+
+    //! Wait for all outstanding ACKs, called with the lock held
+    void ctrl_flush_pending(void){
+        while (not _ctrl_pending.empty()) this->ctrl_retire_pending();
+    }
+
+    /*!
+     * Wait for the ACK of the oldest pipelined write, called with the lock held.
+     * The ACKs of newer writes that arrive first are marked along the way.
+     * On a timeout, go back: send the oldest write and all writes after it again.
+     * When the oldest write was lost, the later ones already landed out of order;
+     * landing again in order, the last value of each register is the right one.
+     */
+    void ctrl_retire_pending(void){
+        for (size_t i = 0; i < CTRL_RECV_RETRIES; i++){
+            if (this->ctrl_recv_pending(CTRL_RECV_TIMEOUT/CTRL_RECV_RETRIES)){
+                while (not _ctrl_pending.empty() and _ctrl_pending.front().acked) _ctrl_pending.pop_front();
+                return;
+            }
+            UHD_MSG(error)
+                << "Control packet attempt " << i
+                << ", sequence number " << ntohl(_ctrl_pending.front().data.seq)
+                << ":\nno control response, possible packet loss" << std::endl;
+            BOOST_FOREACH(ctrl_pending_type &pending, _ctrl_pending){
+                pending.acked = false;
+                _ctrl_transport->send(boost::asio::buffer(&pending.data, sizeof(usrp2_ctrl_data_t)));
+            }
+        }
+        _ctrl_pending.clear();
+        throw uhd::runtime_error("link dead: timeout waiting for control packet ACK");
+    }
+
+    //! Receive ACKs until the oldest write is ACK'd, false on timeout
+    bool ctrl_recv_pending(const double timeout){
+        boost::uint8_t usrp2_ctrl_data_in_mem[udp_simple::mtu]; //allocate max bytes for recv
+        const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(usrp2_ctrl_data_in_mem);
+        while (not _ctrl_pending.front().acked){
+            const size_t len = _ctrl_transport->recv(boost::asio::buffer(usrp2_ctrl_data_in_mem), timeout);
+            if (len == 0) return false; //timeout
+            if (len < sizeof(usrp2_ctrl_data_t)) continue; //bad packet
+            const boost::uint32_t seq = ntohl(ctrl_data_in->seq);
+            BOOST_FOREACH(ctrl_pending_type &pending, _ctrl_pending){
+                if (ntohl(pending.data.seq) != seq) continue;
+                this->check_compat(ntohl(ctrl_data_in->proto_ver), pending.lo, pending.hi);
+                UHD_ASSERT_THROW(ntohl(ctrl_data_in->id) == pending.ack_id);
+                pending.acked = true;
+            }
+            //otherwise a late ACK from before a resend, continue looking...
+        }
+        return true;
+    }
+
 /***********************************************************************
  * Send/Recv over control
  **********************************************************************/
@@ -304,6 +490,16 @@ public:
         boost::uint32_t hi = USRP2_FW_COMPAT_NUM
     ){
         boost::mutex::scoped_lock lock(_ctrl_mutex);
+        return this->ctrl_send_and_recv_unlocked(out_data, lo, hi);
+    }
+
+    //! Send and wait for the reply, called with the lock held
+    usrp2_ctrl_data_t ctrl_send_and_recv_unlocked(
+        const usrp2_ctrl_data_t &out_data,
+        boost::uint32_t lo = USRP2_FW_COMPAT_NUM,
+        boost::uint32_t hi = USRP2_FW_COMPAT_NUM
+    ){
+        this->ctrl_flush_pending(); //the writes before this one must land first
 
         for (size_t i = 0; i < CTRL_RECV_RETRIES; i++){
             try{
@@ -335,15 +531,7 @@ public:
         const usrp2_ctrl_data_t *ctrl_data_in = reinterpret_cast<const usrp2_ctrl_data_t *>(usrp2_ctrl_data_in_mem);
         while(true){
             size_t len = _ctrl_transport->recv(boost::asio::buffer(usrp2_ctrl_data_in_mem), timeout);
-            boost::uint32_t compat = ntohl(ctrl_data_in->proto_ver);
-            if(len >= sizeof(boost::uint32_t) and (hi < compat or lo > compat)){
-                throw uhd::runtime_error(str(boost::format(
-                    "\nPlease update the firmware and FPGA images for your device.\n"
-                    "See the application notes for USRP2/N-Series for instructions.\n"
-                    "Expected protocol compatibility number %s, but got %d:\n"
-                    "The firmware build is not compatible with the host code build."
-                ) % ((lo == hi)? (boost::format("%d") % hi) : (boost::format("[%d to %d]") % lo % hi)) % compat));
-            }
+            if (len >= sizeof(boost::uint32_t)) this->check_compat(ntohl(ctrl_data_in->proto_ver), lo, hi);
             if (len >= sizeof(usrp2_ctrl_data_t) and ntohl(ctrl_data_in->seq) == _ctrl_seq_num){
                 return *ctrl_data_in;
             }
@@ -353,6 +541,17 @@ public:
         throw timeout_error("no control response, possible packet loss");
     }
 
+    void check_compat(boost::uint32_t compat, boost::uint32_t lo, boost::uint32_t hi){
+        if (hi < compat or lo > compat){
+            throw uhd::runtime_error(str(boost::format(
+                "\nPlease update the firmware and FPGA images for your device.\n"
+                "See the application notes for USRP2/N-Series for instructions.\n"
+                "Expected protocol compatibility number %s, but got %d:\n"
+                "The firmware build is not compatible with the host code build."
+            ) % ((lo == hi)? (boost::format("%d") % hi) : (boost::format("[%d to %d]") % lo % hi)) % compat));
+        }
+    }
+
     rev_type get_rev(void){
         std::string hw = mb_eeprom["hardware"];
         if (hw.empty()) return USRP_NXXX;
@@ -397,6 +596,20 @@ private:
     boost::uint32_t _ctrl_seq_num;
     boost::uint32_t _protocol_compat;
 
+    //used in pipelined writes
+    struct ctrl_pending_type{
+        usrp2_ctrl_data_t data;
+        boost::uint32_t ack_id, lo, hi;
+        bool acked;
+    };
+    std::deque<ctrl_pending_type> _ctrl_pending;
+    size_t _pipeline_depth;
+
+    //used in timed writes
+    double _tick_rate;
+    time_spec_t _command_time;
+    timed_cmd_queue<boost::uint32_t> _timed_cmds;
+
     //lock thread stuff
     task::sptr _lock_task;
 };
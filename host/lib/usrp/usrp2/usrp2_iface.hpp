@@ -20,6 +20,7 @@
 
 #include <uhd/transport/udp_simple.hpp>
 #include <uhd/types/serial.hpp>
+#include <uhd/types/time_spec.hpp>
 #include <uhd/usrp/mboard_eeprom.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/utility.hpp>
@@ -72,6 +73,51 @@ public:
     //! A hack: Perform an action on the ZPU
     virtual uint32_t send_zpu_action(uint32_t action, uint32_t data) = 0;
 
+    /*!
+     * Pipeline the write transactions: pokes and SPI writes without readback.
+     * A pipelined write is sent without waiting for its ACK,
+     * and the ACKs are matched by sequence number later on.
+     * Any other transaction waits for the outstanding ACKs first.
+     * When an ACK times out, the write and all writes after it are sent again.
+     * The firmware does not reorder: when the write itself was lost,
+     * the writes after it land first, then all of them land again in order.
+     * So the final register state is right, but a register may briefly
+     * hold a later value; only pipeline writes that may be repeated
+     * and briefly reordered, ex: register settings, not strobes.
+     * Calls nest; writes are pipelined until the outermost disable.
+     * \param enb true to enable, false to undo one enable
+     */
+    virtual void set_pipelined_writes(const bool enb) = 0;
+
+    //! Wait for the ACKs of all pipelined writes
+    virtual void flush_writes(void) = 0;
+
+    //! Pipeline the writes while in scope, undone also when a write throws
+    class scoped_pipelined_writes : boost::noncopyable{
+    public:
+        scoped_pipelined_writes(usrp2_iface &iface): _iface(iface){
+            _iface.set_pipelined_writes(true);
+        }
+        ~scoped_pipelined_writes(void){
+            _iface.set_pipelined_writes(false);
+        }
+    private:
+        usrp2_iface &_iface;
+    };
+
+    /*!
+     * Set the time at which the register writes take effect.
+     * While a command time is set, pokes and SPI writes without readback
+     * are queued in the firmware and run in order at the command time.
+     * Readbacks are never timed, they happen right away.
+     * The host waits when the firmware queue is full.
+     * \param time the command time, time_spec_t(0.0) to clear it
+     */
+    virtual void set_command_time(const uhd::time_spec_t &time) = 0;
+
+    //! Set the tick rate of the time64 core, used to convert the command time
+    virtual void set_tick_rate(const double rate) = 0;
+
     //motherboard eeprom map structure
     uhd::usrp::mboard_eeprom_t mb_eeprom;
 };
@@ -61,7 +61,7 @@ UHD_STATIC_BLOCK(register_usrp2_device){
  * Helpers
  **********************************************************************/
 
-static zero_copy_if::sptr make_xport(
+static udp_zero_copy::sptr make_xport(
     const std::string &addr,
     const std::string &port,
     const device_addr_t &hints,
@@ -76,7 +76,7 @@ static zero_copy_if::sptr make_xport(
     }
 
     //make the transport object with the filtered hints
-    zero_copy_if::sptr xport = udp_zero_copy::make(addr, port, filtered_hints);
+    udp_zero_copy::sptr xport = udp_zero_copy::make(addr, port, filtered_hints);
 
     //Send a small data packet so the usrp2 knows the udp source port.
     //This setup must happen before further initialization occurs
@@ -88,6 +88,7 @@ static zero_copy_if::sptr make_xport(
     transport::managed_send_buffer::sptr send_buff = xport->get_send_buff();
     std::memcpy(send_buff->cast<void*>(), &data, sizeof(data));
     send_buff->commit(sizeof(data));
+    xport->flush_send_buffs();
 
     return xport;
 }
@@ -275,6 +276,8 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
         ////////////////////////////////////////////////////////////////
         // create frontend control objects
         ////////////////////////////////////////////////////////////////
+        //the frontend and dsp setup is all register writes, pipeline them
+        _mbc[mb].iface->set_pipelined_writes(true);
         _mbc[mb].rx_fe = rx_frontend_core_200::make(
             _mbc[mb].iface, U2_REG_SR_ADDR(SR_RX_FRONT)
         );
@@ -332,6 +335,8 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
                 .publish(boost::bind(&rx_dsp_core_200::get_freq_range, _mbc[mb].rx_dsps[dspno]));
             _tree->create<stream_cmd_t>(rx_dsp_path / "stream_cmd")
                 .subscribe(boost::bind(&rx_dsp_core_200::issue_stream_command, _mbc[mb].rx_dsps[dspno], _1));
+            _tree->create<rx_stream_stats_t>(rx_dsp_path / "stats")
+                .publish(boost::bind(&usrp2_impl::get_rx_stats, this, mb, dspno));
         }
 
         ////////////////////////////////////////////////////////////////
@@ -353,6 +358,8 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
             .coerce(boost::bind(&usrp2_impl::set_tx_dsp_freq, this, mb, _1));
         _tree->create<meta_range_t>(mb_path / "tx_dsps/0/freq/range")
             .publish(boost::bind(&usrp2_impl::get_tx_dsp_freq_range, this, mb));
+        _tree->create<tx_stream_stats_t>(mb_path / "tx_dsps/0/stats")
+            .publish(boost::bind(&usrp2_impl::get_tx_stats, this, mb, 0));
 
         //setup dsp flow control
         const double ups_per_sec = device_args_i.cast<double>("ups_per_sec", 20);
@@ -362,6 +369,8 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
             (ups_per_sec > 0.0)? size_t(100e6/*approx tick rate*//ups_per_sec) : 0,
             (ups_per_fifo > 0.0)? size_t(USRP2_SRAM_BYTES/ups_per_fifo/send_frame_size) : 0
         );
+        _mbc[mb].iface->set_pipelined_writes(false);
+        _mbc[mb].iface->flush_writes();
 
         ////////////////////////////////////////////////////////////////
         // create time control objects
@@ -382,6 +391,10 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
         _tree->create<time_spec_t>(mb_path / "time/pps")
             .publish(boost::bind(&time64_core_200::get_time_last_pps, _mbc[mb].time64))
             .subscribe(boost::bind(&time64_core_200::set_time_next_pps, _mbc[mb].time64, _1));
+        _tree->access<double>(mb_path / "tick_rate")
+            .subscribe(boost::bind(&usrp2_iface::set_tick_rate, _mbc[mb].iface, _1));
+        _tree->create<time_spec_t>(mb_path / "time/cmd")
+            .subscribe(boost::bind(&usrp2_iface::set_command_time, _mbc[mb].iface, _1));
         //setup time source props
         _tree->create<std::string>(mb_path / "time_source/value")
             .subscribe(boost::bind(&time64_core_200::set_time_source, _mbc[mb].time64, _1));
@@ -437,7 +450,7 @@ usrp2_impl::usrp2_impl(const device_addr_t &_device_addr){
     }
 
     //initialize io handling
-    this->io_init();
+    this->io_init(device_addr);
 
     //do some post-init tasks
     this->update_rates();
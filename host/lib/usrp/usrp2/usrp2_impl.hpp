@@ -27,6 +27,7 @@
 #include "rx_dsp_core_200.hpp"
 #include "tx_dsp_core_200.hpp"
 #include "time64_core_200.hpp"
+#include "flow_control_monitor.hpp"
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/msg.hpp>
 #include <uhd/property_tree.hpp>
@@ -36,6 +37,7 @@
 #include <uhd/utils/byteswap.hpp>
 #include <uhd/types/dict.hpp>
 #include <uhd/types/stream_cmd.hpp>
+#include <uhd/types/stream_stats.hpp>
 #include <uhd/types/clock_config.hpp>
 #include <uhd/usrp/dboard_eeprom.hpp>
 #include <boost/shared_ptr.hpp>
@@ -121,7 +123,7 @@ private:
         tx_dsp_core_200::sptr tx_dsp;
         time64_core_200::sptr time64;
         std::vector<uhd::transport::zero_copy_if::sptr> rx_dsp_xports;
-        uhd::transport::zero_copy_if::sptr tx_dsp_xport;
+        uhd::transport::udp_zero_copy::sptr tx_dsp_xport;
         uhd::usrp::dboard_manager::sptr dboard_manager;
         uhd::usrp::dboard_iface::sptr dboard_iface;
         size_t rx_chan_occ, tx_chan_occ;
@@ -145,10 +147,12 @@ private:
 
     //io impl methods and members
     UHD_PIMPL_DECL(io_impl) _io_impl;
-    void io_init(void);
+    void io_init(const uhd::device_addr_t &);
     void update_tick_rate(const double rate);
     void update_rx_samp_rate(const std::string &, const size_t, const double rate);
     void update_tx_samp_rate(const std::string &, const size_t, const double rate);
+    uhd::rx_stream_stats_t get_rx_stats(const std::string &, const size_t);
+    uhd::tx_stream_stats_t get_tx_stats(const std::string &, const size_t);
     void update_rates(void);
     //update spec methods are coercers until we only accept db_name == A
     void update_rx_subdev_spec(const std::string &, const uhd::usrp::subdev_spec_t &);
@@ -349,73 +353,4 @@ static device_addrs_t usrp2_find_generic(const device_addr_t &hint_, const char
     return usrp2_addrs;
 }
 
-/***********************************************************************
- * flow control monitor for a single tx channel
- *  - the pirate thread calls update
- *  - the get send buffer calls check
- **********************************************************************/
-class flow_control_monitor{
-public:
-    typedef boost::uint32_t seq_type;
-    typedef boost::shared_ptr<flow_control_monitor> sptr;
-
-    /*!
-     * Make a new flow control monitor.
-     * \param max_seqs_out num seqs before throttling
-     */
-    flow_control_monitor(seq_type max_seqs_out):_max_seqs_out(max_seqs_out){
-        this->clear();
-        _ready_fcn = boost::bind(&flow_control_monitor::ready, this);
-    }
-
-    //! Clear the monitor, Ex: when a streamer is created
-    void clear(void){
-        _last_seq_out = 0;
-        _last_seq_ack = 0;
-    }
-
-    /*!
-     * Gets the current sequence number to go out.
-     * Increments the sequence for the next call
-     * \return the sequence to be sent to the dsp
-     */
-    UHD_INLINE seq_type get_curr_seq_out(void){
-        return _last_seq_out++;
-    }
-
-    /*!
-     * Check the flow control condition.
-     * \param timeout the timeout in seconds
-     * \return false on timeout
-     */
-    UHD_INLINE bool check_fc_condition(double timeout){
-        boost::mutex::scoped_lock lock(_fc_mutex);
-        if (this->ready()) return true;
-        boost::this_thread::disable_interruption di; //disable because the wait can throw
-        return _fc_cond.timed_wait(lock, to_time_dur(timeout), _ready_fcn);
-    }
-
-    /*!
-     * Update the flow control condition.
-     * \param seq the last sequence number to be ACK'd
-     */
-    UHD_INLINE void update_fc_condition(seq_type seq){
-        boost::mutex::scoped_lock lock(_fc_mutex);
-        _last_seq_ack = seq;
-        lock.unlock();
-        _fc_cond.notify_one();
-    }
-
-private:
-    bool ready(void){
-        return seq_type(_last_seq_out -_last_seq_ack) < _max_seqs_out;
-    }
-
-    boost::mutex _fc_mutex;
-    boost::condition _fc_cond;
-    seq_type _last_seq_out, _last_seq_ack;
-    const seq_type _max_seqs_out;
-    boost::function<bool(void)> _ready_fcn;
-};
-
 #endif /* INCLUDED_USRP2_IMPL_HPP */
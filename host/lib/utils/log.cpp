@@ -180,6 +180,10 @@ uhd::_log::log::log(
 ){
     _impl = UHD_PIMPL_MAKE(impl, ());
     _impl->verbosity = verbosity;
+
+    //skip the header formatting when the entry will be thrown away
+    if (_impl->verbosity < log_rs().level) return;
+
     const std::string time = pt::to_simple_string(pt::microsec_clock::local_time());
     const std::string header1 = str(boost::format("-- %s - level %d") % time % int(verbosity));
     const std::string header2 = str(boost::format("-- %s") % function).substr(0, 80);
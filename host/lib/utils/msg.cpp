@@ -18,11 +18,20 @@
 #include <uhd/utils/msg.hpp>
 #include <uhd/utils/log.hpp>
 #include <uhd/utils/static.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
 #include <boost/tokenizer.hpp>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <map>
 
 /***********************************************************************
  * Helper functions
@@ -60,12 +69,174 @@ static void msg_to_cerr(const std::string &title, const std::string &msg){
     std::cerr << ss.str() << std::flush;
 }
 
+/***********************************************************************
+ * Fast-path message ring
+ *
+ * Every thread that sends fast-path messages owns one ring.
+ * The owner thread pushes and the drain pops, neither side ever waits.
+ * When the ring is full the message is dropped and counted instead.
+ **********************************************************************/
+static const size_t FASTPATH_RING_SIZE = 256; //power of two
+static const size_t FASTPATH_BURST = 10; //passed through per message per window
+static const long FASTPATH_WINDOW_SECS = 1;
+static const long FASTPATH_POLL_MS = 10;
+
+class fastpath_ring{
+public:
+    typedef boost::shared_ptr<fastpath_ring> sptr;
+
+    fastpath_ring(void): _msgs(FASTPATH_RING_SIZE){}
+
+    //! push a message, called from the owner thread only
+    bool push(std::string &msg){
+        const boost::uint32_t tail = _tail.read();
+        if (tail - _head.read() == FASTPATH_RING_SIZE){
+            _dropped.inc();
+            return false;
+        }
+        _msgs[tail % FASTPATH_RING_SIZE].swap(msg);
+        _tail.inc(); //publish the slot
+        return true;
+    }
+
+    //! pop a message, called from the drain only
+    bool pop(std::string &msg){
+        const boost::uint32_t head = _head.read();
+        if (head == _tail.read()) return false;
+        msg.clear();
+        msg.swap(_msgs[head % FASTPATH_RING_SIZE]);
+        _head.inc(); //free the slot
+        return true;
+    }
+
+    bool empty(void){
+        return _head.read() == _tail.read();
+    }
+
+    //! get and reset the number of dropped messages
+    size_t take_dropped(void){
+        boost::uint32_t dropped;
+        do{
+            dropped = _dropped.read();
+        } while (_dropped.cas(0, dropped) != dropped);
+        return dropped;
+    }
+
+private:
+    std::vector<std::string> _msgs;
+    uhd::atomic_uint32_t _head, _tail, _dropped;
+};
+
 /***********************************************************************
  * Global resources for the messenger
  **********************************************************************/
-struct msg_resource_type{
+class msg_resource_type{
+public:
     boost::mutex mutex;
     uhd::msg::handler_t handler;
+
+    msg_resource_type(void): _window_dropped(0){
+        _window_end = boost::get_system_time();
+    }
+
+    ~msg_resource_type(void){
+        if (_drain_thread.get() != NULL){
+            _drain_thread->interrupt();
+            _drain_thread->join();
+        }
+        this->drain(true);
+    }
+
+    //! call the handler with the lock held
+    void handle(const uhd::msg::type_t type, const std::string &msg){
+        boost::mutex::scoped_lock lock(mutex);
+        handler(type, msg);
+    }
+
+    //! queue a fast-path message on this thread's ring, never blocks
+    void post_fastpath(std::string msg){
+        if (_thread_ring.get() == NULL) this->register_thread();
+        (*_thread_ring)->push(msg);
+    }
+
+    /*!
+     * Hand the queued fast-path messages to the handler.
+     * Each distinct message is passed through up to the burst limit
+     * per window; the rest are counted and reported once per window.
+     * \param end_window true to report the counts now
+     */
+    void drain(const bool end_window){
+        boost::mutex::scoped_lock drain_lock(_drain_mutex);
+
+        //forget the rings of threads that are gone, once they are empty
+        std::vector<fastpath_ring::sptr> rings;
+        {
+            boost::mutex::scoped_lock rings_lock(_rings_mutex);
+            std::vector<fastpath_ring::sptr> live_rings;
+            BOOST_FOREACH(const fastpath_ring::sptr &ring, _rings){
+                if (not ring.unique() or not ring->empty()) live_rings.push_back(ring);
+            }
+            _rings.swap(live_rings);
+            rings = _rings;
+        }
+
+        std::string msg;
+        BOOST_FOREACH(const fastpath_ring::sptr &ring, rings){
+            while (ring->pop(msg)){
+                if (_window_counts[msg]++ < FASTPATH_BURST) this->handle(uhd::msg::fastpath, msg);
+            }
+            _window_dropped += ring->take_dropped();
+        }
+
+        if (not end_window and boost::get_system_time() < _window_end) return;
+        typedef std::pair<const std::string, size_t> count_pair_type;
+        BOOST_FOREACH(const count_pair_type &count, _window_counts){
+            if (count.second <= FASTPATH_BURST) continue;
+            this->handle(uhd::msg::fastpath, str(boost::format("\n%s x %u in last %us\n")
+                % count.first % count.second % FASTPATH_WINDOW_SECS));
+        }
+        if (_window_dropped != 0){
+            this->handle(uhd::msg::fastpath, str(boost::format("\n%u fast-path messages dropped\n")
+                % _window_dropped));
+        }
+        _window_counts.clear();
+        _window_dropped = 0;
+        _window_end = boost::get_system_time() + boost::posix_time::seconds(FASTPATH_WINDOW_SECS);
+    }
+
+private:
+    boost::thread_specific_ptr<fastpath_ring::sptr> _thread_ring;
+    std::vector<fastpath_ring::sptr> _rings;
+    boost::mutex _rings_mutex;
+    boost::scoped_ptr<boost::thread> _drain_thread;
+
+    boost::mutex _drain_mutex;
+    std::map<std::string, size_t> _window_counts;
+    size_t _window_dropped;
+    boost::system_time _window_end;
+
+    //! give the calling thread a ring, start the drain on first use
+    void register_thread(void){
+        fastpath_ring::sptr ring(new fastpath_ring());
+        _thread_ring.reset(new fastpath_ring::sptr(ring));
+        boost::mutex::scoped_lock rings_lock(_rings_mutex);
+        _rings.push_back(ring);
+        if (_drain_thread.get() == NULL){
+            _drain_thread.reset(new boost::thread(boost::bind(&msg_resource_type::drain_loop, this)));
+        }
+    }
+
+    void drain_loop(void){
+        try{
+            while (true){
+                this->drain(false);
+                boost::this_thread::sleep(boost::posix_time::milliseconds(FASTPATH_POLL_MS));
+            }
+        }
+        catch(const boost::thread_interrupted &){
+            //the messenger is shutting down
+        }
+    }
 };
 
 UHD_SINGLETON_FCN(msg_resource_type, msg_rs);
@@ -78,6 +249,10 @@ void uhd::msg::register_handler(const handler_t &handler){
     msg_rs().handler = handler;
 }
 
+void uhd::msg::flush(void){
+    msg_rs().drain(true);
+}
+
 static void default_msg_handler(uhd::msg::type_t type, const std::string &msg){
     switch(type){
     case uhd::msg::fastpath:
@@ -119,8 +294,12 @@ uhd::msg::_msg::_msg(const type_t type){
 }
 
 uhd::msg::_msg::~_msg(void){
-    boost::mutex::scoped_lock lock(msg_rs().mutex);
-    msg_rs().handler(_impl->type, _impl->ss.str());
+    //fast-path messages are handled later, on the drain thread
+    if (_impl->type == fastpath){
+        msg_rs().post_fastpath(_impl->ss.str());
+        return;
+    }
+    msg_rs().handle(_impl->type, _impl->ss.str());
 }
 
 std::ostream & uhd::msg::_msg::operator()(void){
@@ -0,0 +1,99 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/transport/spsc_bounded_buffer.hpp>
+#include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <iostream>
+
+namespace po = boost::program_options;
+using namespace uhd::transport;
+
+/***********************************************************************
+ * Single thread: push and pop in turn, like a transport frame queue
+ **********************************************************************/
+template <typename buffer_type> double bench_single_thread(size_t num_elems, size_t capacity){
+    buffer_type bb(capacity);
+    size_t val = 0;
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    for (size_t i = 0; i < num_elems; i++){
+        bb.push_with_haste(i);
+        bb.pop_with_timed_wait(val, 0.1);
+    }
+    const uhd::time_spec_t elapsed = uhd::time_spec_t::get_system_time() - start;
+    return elapsed.get_real_secs()*1e9/num_elems;
+}
+
+/***********************************************************************
+ * Two threads: a producer pushes while the caller pops
+ **********************************************************************/
+template <typename buffer_type> void producer(buffer_type *bb, size_t num_elems){
+    for (size_t i = 0; i < num_elems; i++) bb->push_with_wait(i);
+}
+
+template <typename buffer_type> double bench_two_threads(size_t num_elems, size_t capacity){
+    buffer_type bb(capacity);
+    size_t val = 0;
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    boost::thread producer_thread(boost::bind(&producer<buffer_type>, &bb, num_elems));
+    for (size_t i = 0; i < num_elems; i++){
+        bb.pop_with_wait(val);
+        if (val != i) throw std::runtime_error("elements out of order");
+    }
+    producer_thread.join();
+    const uhd::time_spec_t elapsed = uhd::time_spec_t::get_system_time() - start;
+    return elapsed.get_real_secs()*1e9/num_elems;
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    //variables to be set by po
+    size_t num_elems, capacity;
+
+    //setup the program options
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("num", po::value<size_t>(&num_elems)->default_value(1000000), "number of elements to pass through each buffer")
+        ("capacity", po::value<size_t>(&capacity)->default_value(32), "capacity of each buffer")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UHD Buffer Benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+
+    std::cout << boost::format("Passing %d elements through buffers of capacity %d") % num_elems % capacity << std::endl;
+    std::cout << boost::format("  single thread, bounded_buffer:       %8.1f ns/element")
+        % bench_single_thread<bounded_buffer<size_t> >(num_elems, capacity) << std::endl;
+    std::cout << boost::format("  single thread, spsc_bounded_buffer:  %8.1f ns/element")
+        % bench_single_thread<spsc_bounded_buffer<size_t> >(num_elems, capacity) << std::endl;
+    std::cout << boost::format("  two threads,   bounded_buffer:       %8.1f ns/element")
+        % bench_two_threads<bounded_buffer<size_t> >(num_elems, capacity) << std::endl;
+    std::cout << boost::format("  two threads,   spsc_bounded_buffer:  %8.1f ns/element")
+        % bench_two_threads<spsc_bounded_buffer<size_t> >(num_elems, capacity) << std::endl;
+
+    return 0;
+}
@@ -17,7 +17,12 @@
 
 #include <boost/test/unit_test.hpp>
 #include <uhd/transport/bounded_buffer.hpp>
+#include <uhd/transport/spsc_bounded_buffer.hpp>
+#include <uhd/transport/buffer_pool.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <cstring>
 
 using namespace boost::assign;
 using namespace uhd::transport;
@@ -62,3 +67,62 @@ BOOST_AUTO_TEST_CASE(test_bounded_buffer_with_pop_on_full){
     BOOST_CHECK(bb.pop_with_timed_wait(val, timeout));
     BOOST_CHECK_EQUAL(val, 3);
 }
+
+BOOST_AUTO_TEST_CASE(test_spsc_bounded_buffer_with_timed_wait){
+    spsc_bounded_buffer<int> bb(3);
+
+    //push elements, check for timeout
+    BOOST_CHECK(bb.push_with_timed_wait(0, timeout));
+    BOOST_CHECK(bb.push_with_timed_wait(1, timeout));
+    BOOST_CHECK(bb.push_with_timed_wait(2, timeout));
+    BOOST_CHECK(not bb.push_with_timed_wait(3, timeout));
+
+    int val;
+    //pop elements, check for timeout and check values
+    BOOST_CHECK(bb.pop_with_timed_wait(val, timeout));
+    BOOST_CHECK_EQUAL(val, 0);
+    BOOST_CHECK(bb.pop_with_timed_wait(val, timeout));
+    BOOST_CHECK_EQUAL(val, 1);
+    BOOST_CHECK(bb.pop_with_timed_wait(val, timeout));
+    BOOST_CHECK_EQUAL(val, 2);
+    BOOST_CHECK(not bb.pop_with_timed_wait(val, timeout));
+}
+
+static void spsc_producer(spsc_bounded_buffer<int> *bb, int num_elems){
+    for (int i = 0; i < num_elems; i++) bb->push_with_wait(i);
+}
+
+BOOST_AUTO_TEST_CASE(test_spsc_bounded_buffer_with_threads){
+    static const int num_elems = 100000;
+    spsc_bounded_buffer<int> bb(7);
+
+    //the producer thread will block often on the small buffer
+    boost::thread producer(boost::bind(&spsc_producer, &bb, num_elems));
+
+    //pop elements in order, never time out
+    int val;
+    for (int i = 0; i < num_elems; i++){
+        BOOST_REQUIRE(bb.pop_with_timed_wait(val, 1.0));
+        BOOST_REQUIRE_EQUAL(val, i);
+    }
+    producer.join();
+    BOOST_CHECK(not bb.pop_with_haste(val));
+}
+
+static void check_buffer_pool(buffer_pool::sptr pool, const size_t num_buffs, const size_t buff_size, const size_t alignment){
+    BOOST_REQUIRE_EQUAL(pool->size(), num_buffs);
+    for (size_t i = 0; i < num_buffs; i++){
+        BOOST_CHECK_EQUAL(size_t(pool->at(i)) % alignment, size_t(0));
+        if (i != 0) BOOST_CHECK_GE(size_t(pool->at(i)) - size_t(pool->at(i-1)), buff_size);
+        std::memset(pool->at(i), int(i), buff_size); //must be writable
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_buffer_pool_hints){
+    //plain allocation with a cache line alignment
+    check_buffer_pool(buffer_pool::make(100, 1472, uhd::device_addr_t("buff_alignment=64")), 100, 1472, 64);
+
+    //mapped allocation: the options may not be available, but must still allocate
+    const uhd::device_addr_t hints("buff_alignment=4096,buff_hugepages=1,buff_numa_node=0,buff_mlock=1");
+    check_buffer_pool(buffer_pool::make(100, 1472, hints), 100, 1472, 4096);
+}
@@ -0,0 +1,179 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/convert.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/program_options.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#  include <x86intrin.h>
+#  define HAVE_RDTSC
+#endif
+
+namespace po = boost::program_options;
+using namespace uhd;
+
+static boost::uint64_t get_cycles(void){
+    #ifdef HAVE_RDTSC
+    return __rdtsc();
+    #else
+    return 0;
+    #endif
+}
+
+/***********************************************************************
+ * A set of buffers for one side of a conversion:
+ * Aligned to a cache line, then offset by the requested number of bytes.
+ **********************************************************************/
+struct conv_buffers{
+    conv_buffers(const size_t num_chans, const size_t num_bytes, const size_t offset_bytes):
+        mems(num_chans, std::vector<char>(num_bytes + 64 + offset_bytes))
+    {
+        BOOST_FOREACH(std::vector<char> &mem, mems){
+            const size_t addr = size_t(&mem.front());
+            ptrs.push_back(&mem.front() + ((64 - addr % 64) % 64) + offset_bytes);
+        }
+    }
+    std::vector<std::vector<char> > mems;
+    std::vector<void *> ptrs;
+};
+
+struct bench_result{
+    double samps_per_sec;
+    double cycles_per_samp;
+};
+
+/***********************************************************************
+ * Run one converter implementation repeatedly on zeroed buffers
+ **********************************************************************/
+static bench_result run_benchmark(
+    const convert::id_type &id, const convert::priority_type prio,
+    const size_t nsamps, const bool aligned, const double duration
+){
+    //multi-channel formats interleave the channels, so size for the wider side
+    const size_t nitems = nsamps*std::max(id.num_inputs, id.num_outputs);
+    const size_t in_item_size = convert::get_bytes_per_item(id.input_format);
+    const size_t out_item_size = convert::get_bytes_per_item(id.output_format);
+
+    //misaligned buffers start one item past the cache line
+    conv_buffers input(id.num_inputs, nitems*in_item_size, aligned? 0 : in_item_size);
+    conv_buffers output(id.num_outputs, nitems*out_item_size, aligned? 0 : out_item_size);
+    const std::vector<const void *> inputs(input.ptrs.begin(), input.ptrs.end());
+
+    convert::converter::sptr converter = convert::get_converter(id, prio)();
+    converter->set_scalar(1.0);
+    converter->conv(inputs, output.ptrs, nsamps); //warm up
+
+    //run until the duration has elapsed
+    size_t num_runs = 0;
+    const boost::uint64_t start_cycles = get_cycles();
+    const time_spec_t start_time = time_spec_t::get_system_time();
+    time_spec_t elapsed;
+    do{
+        converter->conv(inputs, output.ptrs, nsamps);
+        num_runs++;
+        elapsed = time_spec_t::get_system_time() - start_time;
+    } while (elapsed.get_real_secs() < duration);
+    const boost::uint64_t cycles = get_cycles() - start_cycles;
+
+    bench_result result;
+    result.samps_per_sec = (double(num_runs)*nsamps)/elapsed.get_real_secs();
+    result.cycles_per_samp = double(cycles)/(double(num_runs)*nsamps);
+    return result;
+}
+
+static std::vector<size_t> parse_sizes(const std::string &sizes_str){
+    std::vector<size_t> sizes;
+    std::stringstream ss(sizes_str);
+    std::string size_str;
+    while (std::getline(ss, size_str, ',')){
+        sizes.push_back(size_t(std::atof(size_str.c_str())));
+    }
+    return sizes;
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    //variables to be set by po
+    std::string sizes_str, in_filter, out_filter;
+    double duration;
+
+    //setup the program options
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("sizes", po::value<std::string>(&sizes_str)->default_value("363,4096,65536,1e6"), "comma separated buffer sizes in samples")
+        ("duration", po::value<double>(&duration)->default_value(0.05), "seconds to run each measurement")
+        ("in", po::value<std::string>(&in_filter)->default_value(""), "only conversions with an input format containing this")
+        ("out", po::value<std::string>(&out_filter)->default_value(""), "only conversions with an output format containing this")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UHD Converter Benchmark %s") % desc << std::endl
+            << "Measures every registered implementation of every registered conversion." << std::endl
+            << "The default sizes span one UDP packet of sc16 up to several MB." << std::endl
+            << std::endl;
+        return ~0;
+    }
+
+    const std::vector<size_t> sizes = parse_sizes(sizes_str);
+
+    #ifndef HAVE_RDTSC
+    std::cout << "Cycle counts are not available on this platform" << std::endl;
+    #endif
+    std::cout << boost::format("%-20s %-20s %4s %4s %9s %9s %12s %12s")
+        % "input" % "output" % "chan" % "prio" % "aligned" % "nsamps" % "Msps" % "cycles/samp" << std::endl;
+
+    BOOST_FOREACH(const convert::id_type &id, convert::get_converter_ids()){
+        if (id.input_format.find(in_filter) == std::string::npos) continue;
+        if (id.output_format.find(out_filter) == std::string::npos) continue;
+
+        std::vector<convert::priority_type> prios = convert::get_converter_prios(id);
+        std::sort(prios.begin(), prios.end());
+        BOOST_FOREACH(const convert::priority_type &prio, prios){
+        BOOST_FOREACH(const size_t nsamps, sizes){
+        for (int aligned = 1; aligned >= 0; aligned--){
+            try{
+                const bench_result result = run_benchmark(id, prio, nsamps, aligned != 0, duration);
+                std::cout << boost::format("%-20s %-20s %4s %4d %9s %9d %12.2f %12.2f")
+                    % id.input_format % id.output_format
+                    % str(boost::format("%dx%d") % id.num_inputs % id.num_outputs)
+                    % prio % ((aligned != 0)? "yes" : "no") % nsamps
+                    % (result.samps_per_sec/1e6) % result.cycles_per_samp << std::endl;
+            }
+            catch(const std::exception &e){
+                std::cout << boost::format("%-20s %-20s skipped: %s")
+                    % id.input_format % id.output_format % e.what() << std::endl;
+                break;
+            }
+        }}}
+    }
+
+    return 0;
+}
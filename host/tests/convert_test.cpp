@@ -16,9 +16,13 @@
 //
 
 #include <uhd/convert.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/utils/byteswap.hpp>
 #include <boost/test/unit_test.hpp>
 #include <boost/foreach.hpp>
+#include <boost/format.hpp>
 #include <boost/cstdint.hpp>
+#include <algorithm>
 #include <complex>
 #include <vector>
 #include <cstdlib>
@@ -280,3 +284,169 @@ BOOST_AUTO_TEST_CASE(test_convert_types_sc16_to_fc32){
         MY_CHECK_CLOSE(input[i].imag()/float(32767), output[i].imag(), float(0.01));
     }
 }
+
+/***********************************************************************
+ * Test every registered implementation against the general one:
+ * The SIMD implementations have vector loops and scalar remainders,
+ * so try many lengths and misaligned input and output buffers.
+ **********************************************************************/
+static const int MAX_TEST_PRIO = 8;
+static const size_t MAX_TEST_NSAMPS = 67;
+
+static void random_fill(fc32_t &x){
+    x = fc32_t((std::rand()/float(RAND_MAX/2)) - 1, (std::rand()/float(RAND_MAX/2)) - 1);
+}
+
+static void random_fill(sc16_t &x){
+    x = sc16_t(std::rand()-(RAND_MAX/2), std::rand()-(RAND_MAX/2));
+}
+
+static void random_fill(boost::uint32_t &x){
+    x = (boost::uint32_t(std::rand()) << 16) ^ boost::uint32_t(std::rand());
+}
+
+static void random_fill(boost::uint16_t &x){
+    x = boost::uint16_t(std::rand());
+}
+
+static void check_same(const convert::id_type &, const fc32_t &x, const fc32_t &ref, int){
+    BOOST_CHECK_SMALL(x.real() - ref.real(), float(1e-6));
+    BOOST_CHECK_SMALL(x.imag() - ref.imag(), float(1e-6));
+}
+
+static void check_same(const convert::id_type &, const fc64_t &x, const fc64_t &ref, int){
+    BOOST_CHECK_SMALL(x.real() - ref.real(), 1e-6);
+    BOOST_CHECK_SMALL(x.imag() - ref.imag(), 1e-6);
+}
+
+static void check_same(const convert::id_type &, const sc16_t &x, const sc16_t &ref, int){
+    BOOST_CHECK_EQUAL(x, ref);
+}
+
+//compare the items in host order, within lsb_tolerance for each 16-bit half
+static void check_same(const convert::id_type &id, const boost::uint32_t &x, const boost::uint32_t &ref, int lsb_tolerance){
+    const bool is_be = id.output_format.find("_be") != std::string::npos;
+    const boost::uint32_t x_host = is_be? uhd::ntohx(x) : uhd::wtohx(x);
+    const boost::uint32_t ref_host = is_be? uhd::ntohx(ref) : uhd::wtohx(ref);
+    BOOST_CHECK_LE(std::abs(int(boost::int16_t(x_host >> 16)) - int(boost::int16_t(ref_host >> 16))), lsb_tolerance);
+    BOOST_CHECK_LE(std::abs(int(boost::int16_t(x_host >> 0)) - int(boost::int16_t(ref_host >> 0))), lsb_tolerance);
+}
+
+static void run_converter(
+    const convert::function_type &fcn, const double scalar,
+    const std::vector<const void *> &inputs, const std::vector<void *> &outputs, const size_t nsamps
+){
+    convert::converter::sptr c = fcn();
+    c->set_scalar(scalar);
+    c->conv(inputs, outputs, nsamps);
+}
+
+//! pointers to the same offset in every buffer
+template <typename ptr_type, typename buff_type>
+static std::vector<ptr_type> buff_ptrs(std::vector<std::vector<buff_type> > &buffs, const size_t offset){
+    std::vector<ptr_type> ptrs;
+    BOOST_FOREACH(std::vector<buff_type> &buff, buffs) ptrs.push_back(&buff[offset]);
+    return ptrs;
+}
+
+/*!
+ * Multi-channel ids interleave the channels into one buffer,
+ * so the single buffer side holds num_chans items per sample.
+ */
+template <typename in_type, typename out_type>
+static void test_convert_prios(const convert::id_type &id, const double scalar, const int lsb_tolerance = 0){
+    const size_t num_chans = std::max(id.num_inputs, id.num_outputs);
+    const size_t in_items = (id.num_inputs == num_chans)? 1 : num_chans;
+    const size_t out_items = (id.num_outputs == num_chans)? 1 : num_chans;
+
+    std::vector<std::vector<in_type> > input(id.num_inputs, std::vector<in_type>((MAX_TEST_NSAMPS+1)*in_items));
+    BOOST_FOREACH(std::vector<in_type> &buff, input){
+        BOOST_FOREACH(in_type &in, buff) random_fill(in);
+    }
+
+    const convert::function_type general = convert::get_converter(id, 0);
+    for (int prio = 1; prio <= MAX_TEST_PRIO; prio++){
+        convert::function_type fcn;
+        try{
+            fcn = convert::get_converter(id, prio);
+        }
+        catch(const uhd::key_error &){
+            continue;
+        }
+        std::cout << boost::format("testing %s x%d -> %s x%d prio %d")
+            % id.input_format % id.num_inputs % id.output_format % id.num_outputs % prio << std::endl;
+
+        for (size_t offset = 0; offset < 2; offset++){
+        for (size_t nsamps = 1; nsamps < MAX_TEST_NSAMPS; nsamps++){
+            std::vector<std::vector<out_type> >
+                output(id.num_outputs, std::vector<out_type>((nsamps+1)*out_items)),
+                ref(id.num_outputs, std::vector<out_type>((nsamps+1)*out_items));
+            const std::vector<const void *> inputs = buff_ptrs<const void *>(input, offset);
+            run_converter(general, scalar, inputs, buff_ptrs<void *>(ref, offset), nsamps);
+            run_converter(fcn, scalar, inputs, buff_ptrs<void *>(output, offset), nsamps);
+            for (size_t j = 0; j < id.num_outputs; j++){
+            for (size_t i = offset; i < nsamps*out_items+offset; i++){
+                check_same(id, output[j][i], ref[j][i], lsb_tolerance);
+            }}
+        }}
+    }
+}
+
+static convert::id_type make_id(
+    const std::string &input_format, const std::string &output_format,
+    const size_t num_inputs = 1, const size_t num_outputs = 1
+){
+    convert::id_type id;
+    id.input_format = input_format;
+    id.num_inputs = num_inputs;
+    id.output_format = output_format;
+    id.num_outputs = num_outputs;
+    return id;
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_fc32_to_item32){
+    //float to short may round or truncate
+    test_convert_prios<fc32_t, boost::uint32_t>(make_id("fc32", "sc16_item32_le"), 32767., 1);
+    test_convert_prios<fc32_t, boost::uint32_t>(make_id("fc32", "sc16_item32_be"), 32767., 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_item32_to_fc32){
+    test_convert_prios<boost::uint32_t, fc32_t>(make_id("sc16_item32_le", "fc32"), 1/32767.);
+    test_convert_prios<boost::uint32_t, fc32_t>(make_id("sc16_item32_be", "fc32"), 1/32767.);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_sc16_to_item32){
+    test_convert_prios<sc16_t, boost::uint32_t>(make_id("sc16", "sc16_item32_le"), 1.);
+    test_convert_prios<sc16_t, boost::uint32_t>(make_id("sc16", "sc16_item32_be"), 1.);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_item32_to_sc16){
+    test_convert_prios<boost::uint32_t, sc16_t>(make_id("sc16_item32_le", "sc16"), 1.);
+    test_convert_prios<boost::uint32_t, sc16_t>(make_id("sc16_item32_be", "sc16"), 1.);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_sc8_item32_to_fc32){
+    //one sc8 sample is 16 bits, so an odd offset starts mid-item
+    test_convert_prios<boost::uint16_t, fc32_t>(make_id("sc8_item32_le", "fc32"), 1/127.);
+    test_convert_prios<boost::uint16_t, fc32_t>(make_id("sc8_item32_be", "fc32"), 1/127.);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_sc8_item32_to_fc64){
+    test_convert_prios<boost::uint16_t, fc64_t>(make_id("sc8_item32_le", "fc64"), 1/127.);
+    test_convert_prios<boost::uint16_t, fc64_t>(make_id("sc8_item32_be", "fc64"), 1/127.);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_sc8_item32_to_sc16){
+    test_convert_prios<boost::uint16_t, sc16_t>(make_id("sc8_item32_le", "sc16"), 1.);
+    test_convert_prios<boost::uint16_t, sc16_t>(make_id("sc8_item32_be", "sc16"), 1.);
+}
+
+BOOST_AUTO_TEST_CASE(test_convert_prios_usrp1_multi_chan){
+    for (size_t width = 2; width <= 4; width += 2){
+        test_convert_prios<boost::uint32_t, sc16_t>(make_id("sc16_item16_usrp1", "sc16", 1, width), 1.);
+        test_convert_prios<boost::uint32_t, fc32_t>(make_id("sc16_item16_usrp1", "fc32", 1, width), 1/32767.);
+        test_convert_prios<sc16_t, boost::uint32_t>(make_id("sc16", "sc16_item16_usrp1", width, 1), 1.);
+        //float to short may round or truncate
+        test_convert_prios<fc32_t, boost::uint32_t>(make_id("fc32", "sc16_item16_usrp1", width, 1), 32767., 1);
+    }
+}
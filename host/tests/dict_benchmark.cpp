@@ -0,0 +1,200 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/types/dict.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/convert.hpp>
+#include <boost/program_options.hpp>
+#include <boost/tokenizer.hpp>
+#include <boost/format.hpp>
+#include <boost/foreach.hpp>
+#include <iostream>
+#include <list>
+#include <vector>
+
+namespace po = boost::program_options;
+using namespace uhd;
+
+/***********************************************************************
+ * The list based dict, kept here as the reference to beat
+ **********************************************************************/
+template <typename Key, typename Val> class list_dict{
+public:
+    bool has_key(const Key &key) const{
+        BOOST_FOREACH(const pair_t &p, _map){
+            if (p.first == key) return true;
+        }
+        return false;
+    }
+
+    Val &operator[](const Key &key){
+        BOOST_FOREACH(pair_t &p, _map){
+            if (p.first == key) return p.second;
+        }
+        _map.push_back(std::make_pair(key, Val()));
+        return _map.back().second;
+    }
+
+private:
+    typedef std::pair<Key, Val> pair_t;
+    std::list<pair_t> _map;
+};
+
+/***********************************************************************
+ * A directory tree of either dict, walked like the property tree was
+ **********************************************************************/
+template <template <typename, typename> class dict_type> struct node_type :
+    dict_type<std::string, node_type<dict_type> >
+{
+    int value;
+};
+
+typedef boost::tokenizer<boost::char_separator<char> > path_tokenizer;
+
+template <template <typename, typename> class dict_type>
+void make_path(node_type<dict_type> &root, const std::string &path){
+    node_type<dict_type> *node = &root;
+    BOOST_FOREACH(const std::string &name, path_tokenizer(path, boost::char_separator<char>("/"))){
+        node = &(*node)[name];
+    }
+}
+
+template <template <typename, typename> class dict_type>
+int walk_path(node_type<dict_type> &root, const std::string &path){
+    node_type<dict_type> *node = &root;
+    BOOST_FOREACH(const std::string &name, path_tokenizer(path, boost::char_separator<char>("/"))){
+        if (not node->has_key(name)) throw std::runtime_error("path not found: " + path);
+        node = &(*node)[name];
+    }
+    return node->value;
+}
+
+template <template <typename, typename> class dict_type>
+double bench_tree_walk(const std::vector<std::string> &paths, const size_t num_iters){
+    node_type<dict_type> root;
+    BOOST_FOREACH(const std::string &path, paths) make_path(root, path);
+
+    int accum = 0;
+    const time_spec_t start = time_spec_t::get_system_time();
+    for (size_t i = 0; i < num_iters; i++){
+        accum += walk_path(root, paths[i % paths.size()]);
+    }
+    const time_spec_t elapsed = time_spec_t::get_system_time() - start;
+    if (accum == 42) std::cout << ""; //keep the walk alive
+    return elapsed.get_real_secs()*1e9/num_iters;
+}
+
+/***********************************************************************
+ * Look up every converter in a copy of the registry
+ **********************************************************************/
+template <typename table_type>
+double bench_registry(const std::vector<convert::id_type> &ids, const size_t num_iters){
+    table_type table;
+    BOOST_FOREACH(const convert::id_type &id, ids) table[id] = 1;
+
+    int accum = 0;
+    const time_spec_t start = time_spec_t::get_system_time();
+    for (size_t i = 0; i < num_iters; i++){
+        const convert::id_type &id = ids[i % ids.size()];
+        if (table.has_key(id)) accum += table[id];
+    }
+    const time_spec_t elapsed = time_spec_t::get_system_time() - start;
+    if (accum == 42) std::cout << ""; //keep the lookups alive
+    return elapsed.get_real_secs()*1e9/num_iters;
+}
+
+/***********************************************************************
+ * The paths of a device tree, like an UmTRX with its two dsps per side
+ **********************************************************************/
+static std::vector<std::string> make_device_paths(const size_t num_mboards){
+    static const char *leaves[] = {
+        "rate/value", "rate/range", "freq/value", "freq/range", "stream_cmd", "stats"
+    };
+    static const char *fe_leaves[] = {
+        "name", "freq/value", "freq/range", "gains/VGA1/value", "gains/VGA2/value",
+        "antenna/value", "bandwidth/value", "sensors/lo_locked", "enabled", "use_lo_offset"
+    };
+    std::vector<std::string> paths;
+    for (size_t mb = 0; mb < num_mboards; mb++){
+        const std::string mb_path = str(boost::format("/mboards/%u") % mb);
+        paths.push_back(mb_path + "/name");
+        paths.push_back(mb_path + "/tick_rate");
+        paths.push_back(mb_path + "/time/now");
+        paths.push_back(mb_path + "/time/pps");
+        paths.push_back(mb_path + "/clock_source/value");
+        paths.push_back(mb_path + "/time_source/value");
+        for (size_t dsp = 0; dsp < 2; dsp++){
+            BOOST_FOREACH(const char *leaf, leaves){
+                paths.push_back(str(boost::format("%s/rx_dsps/%u/%s") % mb_path % dsp % leaf));
+                paths.push_back(str(boost::format("%s/tx_dsps/%u/%s") % mb_path % dsp % leaf));
+            }
+            BOOST_FOREACH(const char *leaf, fe_leaves){
+                paths.push_back(str(boost::format("%s/dboards/%c/rx_frontends/0/%s") % mb_path % char('A'+dsp) % leaf));
+                paths.push_back(str(boost::format("%s/dboards/%c/tx_frontends/0/%s") % mb_path % char('A'+dsp) % leaf));
+            }
+        }
+    }
+    return paths;
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    //variables to be set by po
+    size_t num_iters, num_mboards;
+
+    //setup the program options
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("iters", po::value<size_t>(&num_iters)->default_value(1000000), "number of lookups per measurement")
+        ("mboards", po::value<size_t>(&num_mboards)->default_value(2), "number of motherboards in the tree")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UHD Dict Benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+
+    const std::vector<std::string> paths = make_device_paths(num_mboards);
+    const std::vector<convert::id_type> ids = convert::get_converter_ids();
+    std::cout << boost::format(
+        "%d lookups over %d tree paths and %d registered converters"
+    ) % num_iters % paths.size() % ids.size() << std::endl;
+
+    //the property tree, with its index of accessed paths
+    property_tree::sptr tree = property_tree::make();
+    BOOST_FOREACH(const std::string &path, paths) tree->create<int>(path).set(0);
+    const time_spec_t start = time_spec_t::get_system_time();
+    for (size_t i = 0; i < num_iters; i++){
+        tree->access<int>(paths[i % paths.size()]);
+    }
+    const double tree_access = (time_spec_t::get_system_time() - start).get_real_secs()*1e9/num_iters;
+
+    const std::string fmt = "  %-32s %8.1f ns/lookup";
+    std::cout << boost::format(fmt) % "tree walk, list dict:" % bench_tree_walk<list_dict>(paths, num_iters) << std::endl;
+    std::cout << boost::format(fmt) % "tree walk, hashed dict:" % bench_tree_walk<dict>(paths, num_iters) << std::endl;
+    std::cout << boost::format(fmt) % "property tree access:" % tree_access << std::endl;
+    std::cout << boost::format(fmt) % "converter registry, list dict:" % bench_registry<list_dict<convert::id_type, int> >(ids, num_iters) << std::endl;
+    std::cout << boost::format(fmt) % "converter registry, hashed dict:" % bench_registry<dict<convert::id_type, int> >(ids, num_iters) << std::endl;
+
+    return 0;
+}
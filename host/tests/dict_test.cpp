@@ -70,3 +70,88 @@ BOOST_AUTO_TEST_CASE(test_dict_pop){
     BOOST_CHECK(d.keys()[0] == -1);
     BOOST_CHECK(d.keys()[1] == 1);
 }
+
+BOOST_AUTO_TEST_CASE(test_dict_order){
+    uhd::dict<std::string, int> d;
+    d["c"] = 1;
+    d["a"] = 2;
+    d["b"] = 3;
+    d["a"] = 4; //an update keeps the position
+    BOOST_CHECK_EQUAL(d.size(), 3);
+    BOOST_CHECK_EQUAL(d.keys()[0], "c");
+    BOOST_CHECK_EQUAL(d.keys()[1], "a");
+    BOOST_CHECK_EQUAL(d.keys()[2], "b");
+    BOOST_CHECK_EQUAL(d["a"], 4);
+
+    //a popped key is added back at the end
+    d.pop("c");
+    d["c"] = 5;
+    BOOST_CHECK_EQUAL(d.keys()[0], "a");
+    BOOST_CHECK_EQUAL(d.keys()[2], "c");
+    BOOST_CHECK_EQUAL(d.get("c"), 5);
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_copy){
+    uhd::dict<std::string, int> d;
+    d["a"] = 1;
+    d["b"] = 2;
+
+    //each copy looks up into its own items
+    uhd::dict<std::string, int> d_copy(d);
+    uhd::dict<std::string, int> d_assign;
+    d_assign = d;
+    d["a"] = 3;
+    d.pop("b");
+    BOOST_CHECK_EQUAL(d_copy["a"], 1);
+    BOOST_CHECK_EQUAL(d_copy["b"], 2);
+    BOOST_CHECK_EQUAL(d_assign["a"], 1);
+    BOOST_CHECK_EQUAL(d_assign["b"], 2);
+    BOOST_CHECK(not d.has_key("b"));
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_indexed){
+    //enough keys to be looked up through the hash index
+    uhd::dict<int, int> d;
+    for (int i = 0; i < 100; i++) d[99-i] = i;
+    BOOST_CHECK_EQUAL(d.size(), 100);
+    BOOST_CHECK_EQUAL(d.keys()[0], 99);
+    BOOST_CHECK_EQUAL(d.keys()[99], 0);
+    BOOST_CHECK_EQUAL(d[0], 99);
+    BOOST_CHECK(not d.has_key(100));
+
+    BOOST_CHECK_EQUAL(d.pop(50), 49);
+    BOOST_CHECK(not d.has_key(50));
+    BOOST_CHECK_THROW(d.pop(50), std::exception);
+    d[50] = 1;
+    BOOST_CHECK_EQUAL(d.keys()[99], 50);
+
+    const uhd::dict<int, int> d_copy = d;
+    BOOST_CHECK_EQUAL(d_copy[50], 1);
+    BOOST_CHECK_EQUAL(d_copy.get(1000, 7), 7);
+}
+
+BOOST_AUTO_TEST_CASE(test_dict_repeated_keys){
+    //the first item of a repeated key is kept, indexed or not
+    for (int n = 2; n < 20; n++){
+        std::vector<std::pair<int, int> > items;
+        for (int i = 0; i < n; i++) items.push_back(std::make_pair(i, i));
+        items.push_back(std::make_pair(0, -1));
+        items.push_back(std::make_pair(n-1, -1));
+
+        const uhd::dict<int, int> d(items.begin(), items.end());
+        BOOST_CHECK_EQUAL(d.size(), size_t(n));
+        BOOST_CHECK_EQUAL(d.keys().back(), n-1);
+        BOOST_CHECK_EQUAL(d[0], 0);
+        BOOST_CHECK_EQUAL(d[n-1], n-1);
+    }
+}
+
+enum test_dict_enum_t{TEST_DICT_ENUM_A, TEST_DICT_ENUM_B};
+
+BOOST_AUTO_TEST_CASE(test_dict_enum_keys){
+    uhd::dict<test_dict_enum_t, int> d;
+    d[TEST_DICT_ENUM_B] = 1;
+    BOOST_CHECK(d.has_key(TEST_DICT_ENUM_B));
+    BOOST_CHECK(not d.has_key(TEST_DICT_ENUM_A));
+    BOOST_CHECK_EQUAL(d.get(TEST_DICT_ENUM_A, 2), 2);
+}
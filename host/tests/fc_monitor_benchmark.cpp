@@ -0,0 +1,163 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "../lib/usrp/common/flow_control_monitor.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/utils/atomic.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/format.hpp>
+#include <boost/bind.hpp>
+#include <iostream>
+
+namespace po = boost::program_options;
+
+/***********************************************************************
+ * The mutex based monitor, kept here as the reference to beat
+ **********************************************************************/
+class locked_flow_control_monitor{
+public:
+    typedef boost::uint32_t seq_type;
+
+    locked_flow_control_monitor(seq_type max_seqs_out):
+        _last_seq_out(0), _last_seq_ack(0), _max_seqs_out(max_seqs_out)
+    {
+        _ready_fcn = boost::bind(&locked_flow_control_monitor::ready, this);
+    }
+
+    UHD_INLINE seq_type get_curr_seq_out(void){
+        return _last_seq_out++;
+    }
+
+    UHD_INLINE bool check_fc_condition(double timeout){
+        boost::mutex::scoped_lock lock(_fc_mutex);
+        if (this->ready()) return true;
+        return _fc_cond.timed_wait(lock, boost::posix_time::microseconds(long(timeout*1e6)), _ready_fcn);
+    }
+
+    UHD_INLINE void update_fc_condition(seq_type seq){
+        boost::mutex::scoped_lock lock(_fc_mutex);
+        _last_seq_ack = seq;
+        lock.unlock();
+        _fc_cond.notify_one();
+    }
+
+private:
+    bool ready(void){
+        return seq_type(_last_seq_out -_last_seq_ack) < _max_seqs_out;
+    }
+
+    boost::mutex _fc_mutex;
+    boost::condition _fc_cond;
+    seq_type _last_seq_out, _last_seq_ack;
+    const seq_type _max_seqs_out;
+    boost::function<bool(void)> _ready_fcn;
+};
+
+/***********************************************************************
+ * Single thread: check, take a sequence, and ack every so often,
+ * the window never closes, so this is the per-packet fast path cost
+ **********************************************************************/
+template <typename monitor_type> double bench_open_window(size_t num_packets, size_t window, size_t ack_every){
+    monitor_type fc_mon(window);
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    for (size_t i = 0; i < num_packets; i++){
+        if (not fc_mon.check_fc_condition(0.0)) throw std::runtime_error("window closed");
+        const boost::uint32_t seq = fc_mon.get_curr_seq_out();
+        if (seq % ack_every == 0) fc_mon.update_fc_condition(seq);
+    }
+    const uhd::time_spec_t elapsed = uhd::time_spec_t::get_system_time() - start;
+    return elapsed.get_real_secs()*1e9/num_packets;
+}
+
+/***********************************************************************
+ * Two threads: the caller sends into the window,
+ * and a device thread acks in batches, like the pirate thread
+ **********************************************************************/
+template <typename monitor_type> void device_acker(
+    monitor_type *fc_mon, uhd::atomic_uint32_t *num_sent, size_t num_packets, size_t ack_every
+){
+    size_t num_acked = 0;
+    while (num_acked < num_packets){
+        const size_t sent = num_sent->read();
+        if (sent >= num_acked + ack_every or sent == num_packets){
+            fc_mon->update_fc_condition(boost::uint32_t(sent));
+            num_acked = sent;
+        }
+        else boost::this_thread::yield();
+    }
+}
+
+template <typename monitor_type> double bench_with_acks(size_t num_packets, size_t window, size_t ack_every){
+    monitor_type fc_mon(window);
+    uhd::atomic_uint32_t num_sent;
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    boost::thread acker_thread(boost::bind(&device_acker<monitor_type>, &fc_mon, &num_sent, num_packets, ack_every));
+    for (size_t i = 0; i < num_packets; i++){
+        while (not fc_mon.check_fc_condition(1.0)){}
+        fc_mon.get_curr_seq_out();
+        num_sent.write(boost::uint32_t(i+1));
+    }
+    acker_thread.join();
+    const uhd::time_spec_t elapsed = uhd::time_spec_t::get_system_time() - start;
+    return elapsed.get_real_secs()*1e9/num_packets;
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    //variables to be set by po
+    size_t num_packets, window, ack_every, frame_size;
+
+    //setup the program options
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("num", po::value<size_t>(&num_packets)->default_value(2000000), "number of packets to send through each monitor")
+        ("window", po::value<size_t>(&window)->default_value(712), "packets in flight before throttling (SRAM bytes/frame size)")
+        ("ack-every", po::value<size_t>(&ack_every)->default_value(89), "packets per flow control update from the device")
+        ("frame-size", po::value<size_t>(&frame_size)->default_value(1472), "send frame size in bytes, sets the GigE packet rate")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UHD Flow Control Monitor Benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+
+    //the time budget per packet when sending at the full GigE line rate
+    const double budget_ns = 1e9/(1e9/8/frame_size);
+    std::cout << boost::format(
+        "Sending %d packets, window %d, ack every %d\n"
+        "Full GigE TX with %d byte frames leaves %.1f ns per packet"
+    ) % num_packets % window % ack_every % frame_size % budget_ns << std::endl;
+
+    const double locked_open = bench_open_window<locked_flow_control_monitor>(num_packets, window, ack_every);
+    const double atomic_open = bench_open_window<flow_control_monitor>(num_packets, window, ack_every);
+    const double locked_acks = bench_with_acks<locked_flow_control_monitor>(num_packets, window, ack_every);
+    const double atomic_acks = bench_with_acks<flow_control_monitor>(num_packets, window, ack_every);
+
+    const std::string fmt = "  %-28s %8.1f ns/packet (%5.2f%% of budget)";
+    std::cout << boost::format(fmt) % "open window, mutex:" % locked_open % (100*locked_open/budget_ns) << std::endl;
+    std::cout << boost::format(fmt) % "open window, atomic:" % atomic_open % (100*atomic_open/budget_ns) << std::endl;
+    std::cout << boost::format(fmt) % "with acker thread, mutex:" % locked_acks % (100*locked_acks/budget_ns) << std::endl;
+    std::cout << boost::format(fmt) % "with acker thread, atomic:" % atomic_acks % (100*atomic_acks/budget_ns) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "../lib/usrp/umtrx/lms6002d.hpp"
+#include <uhd/utils/safe_main.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <boost/program_options.hpp>
+#include <boost/format.hpp>
+#include <iostream>
+#include <vector>
+
+namespace po = boost::program_options;
+
+/***********************************************************************
+ * A fake LMS6002D that counts the SPI transactions,
+ * the VTUNE comparators read normal for VCOCAP in a band around 32
+ **********************************************************************/
+class bench_lms6002d_dev : public lms6002d_dev{
+public:
+    bench_lms6002d_dev(void): regs(128, 0), num_reads(0), num_writes(0){}
+
+    void spi_write_reg(uint8_t addr, uint8_t val){
+        regs[addr] = val;
+        num_writes++;
+    }
+
+    uint8_t spi_read_reg(uint8_t addr){
+        num_reads++;
+        if (addr == 0x1a or addr == 0x2a){
+            //move the normal band with the fractional word so every frequency differs
+            const int vcocap = regs[addr - 0x0a + 0x09] & 0x3f;
+            const int center = 16 + regs[addr - 0x0a + 0x02] % 32;
+            if (vcocap < center - 8) return 0x80; //HIGH
+            if (vcocap > center + 8) return 0x40; //LOW
+            return 0x00; //NORMAL
+        }
+        return regs[addr];
+    }
+
+    //! The VCOCAP search before the bisection, kept here as the reference to beat
+    void linear_vcocap_search(uint8_t reg){
+        int start_i = -1, stop_i = -1;
+        for (int i = 0; i < 64; i++){
+            lms_write_bits(reg + 0x9, 0x3f, i);
+            const int comp = read_reg(reg + 0x0a) >> 6;
+            if (comp == 0x00 and start_i == -1) start_i = i;
+            if (comp == 0x01 and start_i != -1 and stop_i == -1) stop_i = i - 1;
+        }
+        if (stop_i == -1) stop_i = 63;
+        lms_write_bits(reg + 0x09, 0x3f, (start_i + stop_i) / 2);
+    }
+
+    std::vector<uint8_t> regs;
+    size_t num_reads, num_writes;
+};
+
+struct tune_result{
+    double cpu_ns, reads, writes;
+};
+
+/***********************************************************************
+ * Hop the Tx and Rx PLLs over a list of GSM carriers,
+ * mode 0: linear search, 1: bisection, 2: bisection and tuning cache
+ **********************************************************************/
+tune_result bench_hops(const std::vector<double> &freqs, size_t num_hops, int mode){
+    bench_lms6002d_dev lms;
+    const double ref_clock = 26e6;
+
+    //the linear search runs after a cached tune, which only writes NINT, NFRAC and FREQSEL
+    if (mode == 0){
+        for (size_t i = 0; i < freqs.size(); i++){
+            lms.tx_pll_tune(ref_clock, freqs[i]);
+            lms.rx_pll_tune(ref_clock, freqs[i] + 45e6);
+        }
+        lms.num_reads = lms.num_writes = 0;
+    }
+
+    const uhd::time_spec_t start = uhd::time_spec_t::get_system_time();
+    for (size_t i = 0; i < num_hops; i++){
+        const double freq = freqs[i % freqs.size()];
+        if (mode == 1) lms.clear_tune_cache();
+        lms.tx_pll_tune(ref_clock, freq);
+        lms.rx_pll_tune(ref_clock, freq + 45e6);
+        if (mode == 0){
+            lms.linear_vcocap_search(0x10);
+            lms.linear_vcocap_search(0x20);
+        }
+    }
+    const uhd::time_spec_t elapsed = uhd::time_spec_t::get_system_time() - start;
+    tune_result result;
+    result.cpu_ns = elapsed.get_real_secs()*1e9/num_hops;
+    result.reads = double(lms.num_reads)/num_hops;
+    result.writes = double(lms.num_writes)/num_hops;
+    return result;
+}
+
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    //variables to be set by po
+    size_t num_hops, num_arfcns;
+    double rtt_us;
+
+    //setup the program options
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("num", po::value<size_t>(&num_hops)->default_value(10000), "number of Tx+Rx retunes per mode")
+        ("arfcns", po::value<size_t>(&num_arfcns)->default_value(8), "number of GSM900 carriers to hop over")
+        ("rtt", po::value<double>(&rtt_us)->default_value(150), "control round trip time in us, paid by each SPI read")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help")){
+        std::cout << boost::format("UHD LMS6002D Tune Latency Benchmark %s") % desc << std::endl;
+        return ~0;
+    }
+
+    //GSM900 uplink carriers from ARFCN 1, 200 kHz apart
+    std::vector<double> freqs;
+    for (size_t i = 0; i < num_arfcns; i++) freqs.push_back(890.2e6 + 0.2e6*(i*7 % 124));
+
+    //the writes are pipelined, so each blocking read is one control round trip
+    std::cout << boost::format(
+        "Hopping over %d carriers, %d retunes of both PLLs per mode\n"
+        "Each SPI read costs a %.0f us control round trip"
+    ) % num_arfcns % num_hops % rtt_us << std::endl;
+
+    const char *names[] = {"linear search:", "bisection:", "bisection and cache:"};
+    for (int mode = 0; mode < 3; mode++){
+        const tune_result r = bench_hops(freqs, num_hops, mode);
+        std::cout << boost::format("  %-22s %6.1f reads %6.1f writes %8.1f ns cpu, ~%6.2f ms per retune")
+            % names[mode] % r.reads % r.writes % r.cpu_ns % ((r.reads*rtt_us*1e3 + r.cpu_ns)/1e6) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "../lib/usrp/umtrx/lms6002d.hpp"
+#include <vector>
+
+/***********************************************************************
+ * A fake LMS6002D: a register map behind counted SPI accesses,
+ * the VTUNE comparators read normal for VCOCAP in [vco_lo, vco_hi]
+ **********************************************************************/
+class fake_lms6002d_dev : public lms6002d_dev{
+public:
+    fake_lms6002d_dev(void): regs(128, 0), num_reads(0), num_writes(0), vco_lo(20), vco_hi(40){}
+
+    void spi_write_reg(uint8_t addr, uint8_t val){
+        regs[addr] = val;
+        num_writes++;
+    }
+
+    uint8_t spi_read_reg(uint8_t addr){
+        num_reads++;
+        if (addr == 0x1a or addr == 0x2a){
+            const int vcocap = regs[addr - 0x0a + 0x09] & 0x3f;
+            if (vcocap < vco_lo) return 0x80; //HIGH
+            if (vcocap > vco_hi) return 0x40; //LOW
+            return 0x00; //NORMAL
+        }
+        return regs[addr];
+    }
+
+    int get_vcocap(uint8_t reg){
+        return regs[reg + 0x09] & 0x3f;
+    }
+
+    std::vector<uint8_t> regs;
+    size_t num_reads, num_writes;
+    int vco_lo, vco_hi;
+};
+
+BOOST_AUTO_TEST_CASE(test_lms_shadow_masked_writes){
+    fake_lms6002d_dev lms;
+    lms.regs[0x41] = 0xe0;
+
+    //the first access reads the chip, the others are served from the shadow
+    lms.set_tx_vga1gain(-10);
+    lms.set_tx_vga1gain(-20);
+    BOOST_CHECK_EQUAL(lms.get_tx_vga1gain(), -20);
+    BOOST_CHECK_EQUAL(lms.num_reads, size_t(1));
+    BOOST_CHECK_EQUAL(lms.num_writes, size_t(2));
+
+    //the bits outside of the mask are kept
+    BOOST_CHECK_EQUAL(lms.regs[0x41], 0xe0 | (35 - 20));
+
+    //registers written before their first read never hit the chip
+    lms.write_reg(0x45, 0x00);
+    lms.set_tx_vga2gain(20);
+    BOOST_CHECK_EQUAL(lms.get_tx_vga2gain(), 20);
+    BOOST_CHECK_EQUAL(lms.num_reads, size_t(1));
+}
+
+BOOST_AUTO_TEST_CASE(test_lms_shadow_volatile){
+    fake_lms6002d_dev lms;
+
+    //the comparators are read from the chip every time
+    lms.write_reg(0x19, 0);
+    BOOST_CHECK_EQUAL(lms.read_reg(0x1a), 0x80);
+    lms.write_reg(0x19, 63);
+    BOOST_CHECK_EQUAL(lms.read_reg(0x1a), 0x40);
+    BOOST_CHECK_EQUAL(lms.num_reads, size_t(2));
+
+    //and so are the calibration results, even after a write
+    lms.write_reg(0x60, 31);
+    lms.regs[0x60] = 17;
+    BOOST_CHECK_EQUAL(lms.read_reg(0x60), 17);
+    BOOST_CHECK_EQUAL(lms.num_reads, size_t(3));
+}
+
+BOOST_AUTO_TEST_CASE(test_lms_shadow_invalidate){
+    fake_lms6002d_dev lms;
+    lms.regs[0x05] = 0x32;
+    BOOST_CHECK_EQUAL(lms.read_reg(0x05), 0x32);
+
+    //a chip reset is only seen after the shadow is dropped
+    lms.regs[0x05] = 0x3e;
+    BOOST_CHECK_EQUAL(lms.read_reg(0x05), 0x32);
+    lms.invalidate_shadow();
+    BOOST_CHECK_EQUAL(lms.read_reg(0x05), 0x3e);
+    BOOST_CHECK_EQUAL(lms.num_reads, size_t(2));
+}
+
+BOOST_AUTO_TEST_CASE(test_lms_vcocap_search){
+    //the middle of the normal range, as found by polling all 64 values
+    const int ranges[][2] = {{20, 40}, {0, 63}, {0, 0}, {63, 63}, {31, 32}, {5, 6}, {50, 63}};
+    for (size_t i = 0; i < sizeof(ranges)/sizeof(ranges[0]); i++){
+        fake_lms6002d_dev lms;
+        lms.vco_lo = ranges[i][0];
+        lms.vco_hi = ranges[i][1];
+        BOOST_CHECK_CLOSE(lms.rx_pll_tune(26e6, 935.2e6), 935.2e6, 1e-3);
+        BOOST_CHECK_EQUAL(lms.get_vcocap(0x20), (ranges[i][0] + ranges[i][1])/2);
+        BOOST_CHECK(lms.num_reads <= 16);
+    }
+
+    //no normal range at all
+    fake_lms6002d_dev lms;
+    lms.vco_lo = 40;
+    lms.vco_hi = 20;
+    BOOST_CHECK_EQUAL(lms.tx_pll_tune(26e6, 890.2e6), -1);
+}
+
+BOOST_AUTO_TEST_CASE(test_lms_tune_cache){
+    fake_lms6002d_dev lms;
+    const double freq = lms.tx_pll_tune(26e6, 890.2e6);
+    lms.rx_pll_tune(26e6, 935.2e6);
+
+    //a hop back to a known frequency checks the remembered VCOCAP once
+    lms.tx_pll_tune(26e6, 900e6);
+    const size_t num_reads = lms.num_reads;
+    BOOST_CHECK_EQUAL(lms.tx_pll_tune(26e6, 890.2e6), freq);
+    BOOST_CHECK_EQUAL(lms.num_reads, num_reads + 1);
+    BOOST_CHECK_EQUAL(lms.get_vcocap(0x10), 30);
+
+    //the PLLs and reference clocks are kept apart
+    lms.tx_pll_tune(13e6, 890.2e6);
+    BOOST_CHECK(lms.num_reads > num_reads + 2);
+
+    //a drifted VCO is searched anew
+    lms.vco_lo = 50;
+    lms.vco_hi = 60;
+    BOOST_CHECK_EQUAL(lms.tx_pll_tune(26e6, 890.2e6), freq);
+    BOOST_CHECK_EQUAL(lms.get_vcocap(0x10), 55);
+
+    //and so is everything after a clear
+    lms.clear_tune_cache();
+    const size_t num_cleared_reads = lms.num_reads;
+    lms.rx_pll_tune(26e6, 935.2e6);
+    BOOST_CHECK(lms.num_reads > num_cleared_reads + 1);
+}
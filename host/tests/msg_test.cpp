@@ -17,7 +17,12 @@
 
 #include <boost/test/unit_test.hpp>
 #include <uhd/utils/msg.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/foreach.hpp>
+#include <boost/bind.hpp>
 #include <iostream>
+#include <vector>
 
 BOOST_AUTO_TEST_CASE(test_messages){
     std::cerr << "---begin print test ---" << std::endl;
@@ -38,3 +43,39 @@ BOOST_AUTO_TEST_CASE(test_messages){
     UHD_VAR(x);
     std::cerr << "---end print test ---" << std::endl;
 }
+
+static boost::mutex fastpath_mutex;
+static std::vector<std::string> fastpath_msgs;
+
+static void fastpath_handler(uhd::msg::type_t type, const std::string &msg){
+    boost::mutex::scoped_lock lock(fastpath_mutex);
+    if (type == uhd::msg::fastpath) fastpath_msgs.push_back(msg);
+}
+
+static void fastpath_storm(const size_t num_msgs){
+    for (size_t i = 0; i < num_msgs; i++) UHD_MSG(fastpath) << "O";
+}
+
+BOOST_AUTO_TEST_CASE(test_fastpath_aggregation){
+    uhd::msg::register_handler(&fastpath_handler);
+    uhd::msg::flush(); //start a new window
+
+    //an overflow storm from two streaming threads
+    boost::thread_group storm;
+    storm.create_thread(boost::bind(&fastpath_storm, 100));
+    storm.create_thread(boost::bind(&fastpath_storm, 100));
+    storm.join_all();
+    uhd::msg::flush();
+
+    //the first few pass through, the rest are counted once
+    size_t num_passed = 0, num_counts = 0;
+    BOOST_FOREACH(const std::string &msg, fastpath_msgs){
+        if (msg == "O") num_passed++;
+        else{
+            BOOST_CHECK_EQUAL(msg, "\nO x 200 in last 1s\n");
+            num_counts++;
+        }
+    }
+    BOOST_CHECK_EQUAL(num_passed, 10);
+    BOOST_CHECK_EQUAL(num_counts, 1);
+}
@@ -173,3 +173,35 @@ BOOST_AUTO_TEST_CASE(test_prop_subtree){
     BOOST_CHECK_EQUAL_COLLECTIONS(tree_dirs2.begin(), tree_dirs2.end(), subtree2_dirs.begin(), subtree2_dirs.end());
 
 }
+
+BOOST_AUTO_TEST_CASE(test_prop_tree_index){
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    tree->create<int>("/test/prop0").set(42);
+
+    //the same property through different spellings of the path
+    BOOST_CHECK_EQUAL(tree->access<int>("/test/prop0").get(), 42);
+    BOOST_CHECK_EQUAL(tree->access<int>("test//prop0/").get(), 42);
+    BOOST_CHECK_EQUAL(tree->subtree("/test")->access<int>("prop0").get(), 42);
+
+    //a removed and re-created property is not served from the index
+    tree->remove("/test");
+    BOOST_CHECK(not tree->exists("/test/prop0"));
+    BOOST_CHECK_THROW(tree->access<int>("/test/prop0"), std::exception);
+    tree->create<int>("/test/prop0").set(34);
+    BOOST_CHECK_EQUAL(tree->access<int>("/test/prop0").get(), 34);
+    BOOST_CHECK_EQUAL(tree->subtree("/test")->access<int>("prop0").get(), 34);
+}
+
+BOOST_AUTO_TEST_CASE(test_prop_tree_handle){
+    uhd::property_tree::sptr tree = uhd::property_tree::make();
+    tree->create<int>("/test/prop0").set(42);
+
+    uhd::property<int>::sptr handle = tree->access_handle<int>("/test/prop0");
+    BOOST_CHECK_EQUAL(handle->get(), 42);
+    handle->set(34);
+    BOOST_CHECK_EQUAL(tree->access<int>("/test/prop0").get(), 34);
+
+    //the handle outlives the removal
+    tree->remove("/test/prop0");
+    BOOST_CHECK_EQUAL(handle->get(), 34);
+}
@@ -0,0 +1,306 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/usrp/multi_usrp.hpp>
+#include <uhd/device.hpp>
+#include <uhd/property_tree.hpp>
+#include <uhd/exception.hpp>
+#include <uhd/types/stream_stats.hpp>
+#include <uhd/transport/bounded_buffer.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <cstring>
+#include <complex>
+#include <vector>
+
+using namespace uhd;
+
+BOOST_AUTO_TEST_CASE(test_sim_find){
+    //only found when asked for by type
+    BOOST_CHECK_EQUAL(device::find(device_addr_t("type=sim")).size(), 1);
+    BOOST_CHECK_EQUAL(device::find(device_addr_t("type=sim,serial=other")).size(), 0);
+}
+
+static size_t recv_num_samps(
+    usrp::multi_usrp::sptr usrp, const size_t num_samps, size_t &num_overflows, bool &got_eob
+){
+    rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args_t("fc32"));
+    std::vector<std::complex<float> > buff(rx_stream->get_max_num_samps());
+
+    stream_cmd_t stream_cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+    stream_cmd.num_samps = num_samps;
+    stream_cmd.stream_now = true;
+    usrp->issue_stream_cmd(stream_cmd);
+
+    size_t num_recvd = 0;
+    num_overflows = 0;
+    got_eob = false;
+    while (not got_eob){
+        rx_metadata_t md;
+        num_recvd += rx_stream->recv(&buff.front(), buff.size(), md, 1.0, true);
+        if (md.error_code == rx_metadata_t::ERROR_CODE_OVERFLOW) num_overflows++;
+        else if (md.error_code != rx_metadata_t::ERROR_CODE_NONE) break;
+        got_eob = md.end_of_burst;
+    }
+    return num_recvd;
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_num_samps){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t("type=sim,throttle=0"));
+    usrp->set_rx_rate(10e6);
+
+    size_t num_overflows;
+    bool got_eob;
+    BOOST_CHECK_EQUAL(recv_num_samps(usrp, 100000, num_overflows, got_eob), 100000);
+    BOOST_CHECK(got_eob);
+    BOOST_CHECK_EQUAL(num_overflows, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_injected_errors){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t(
+        "type=sim,throttle=0,inject_overflow=10,inject_seq_error=15"
+    ));
+
+    //every 10th packet is an overflow and every 15th is lost,
+    //and both are reported as overflows by the packet handler
+    size_t num_overflows;
+    bool got_eob;
+    const size_t num_recvd = recv_num_samps(usrp, 300000, num_overflows, got_eob);
+    BOOST_CHECK(got_eob);
+    BOOST_CHECK(num_overflows > 0);
+    BOOST_CHECK(num_recvd < 300000);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_tx_burst_ack){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t("type=sim"));
+    usrp->set_tx_rate(1e6);
+    tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args_t("fc32"));
+    std::vector<std::complex<float> > buff(10000);
+
+    //a timed burst in the future is played and acknowledged
+    tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = true;
+    md.has_time_spec = true;
+    md.time_spec = usrp->get_time_now() + time_spec_t(0.01);
+    BOOST_CHECK_EQUAL(tx_stream->send(&buff.front(), buff.size(), md, 1.0), buff.size());
+
+    async_metadata_t async_md;
+    BOOST_REQUIRE(usrp->get_device()->recv_async_msg(async_md, 1.0));
+    BOOST_CHECK_EQUAL(async_md.event_code, async_metadata_t::EVENT_CODE_BURST_ACK);
+    BOOST_CHECK(async_md.time_spec > md.time_spec);
+
+    //a burst in the past is late
+    md.time_spec = usrp->get_time_now() - time_spec_t(0.01);
+    BOOST_CHECK_EQUAL(tx_stream->send(&buff.front(), buff.size(), md, 1.0), buff.size());
+    BOOST_REQUIRE(usrp->get_device()->recv_async_msg(async_md, 1.0));
+    BOOST_CHECK_EQUAL(async_md.event_code, async_metadata_t::EVENT_CODE_TIME_ERROR);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_recv_view){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t("type=sim,throttle=0"));
+    usrp->set_rx_rate(10e6);
+    rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args_t("sc16", "sc16"));
+    const size_t spp = rx_stream->get_max_num_samps();
+
+    stream_cmd_t stream_cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+    stream_cmd.num_samps = spp*10;
+    stream_cmd.stream_now = true;
+    usrp->issue_stream_cmd(stream_cmd);
+
+    //a short recv leaves a fragment behind for the view
+    std::vector<std::complex<short> > buff(spp/2);
+    rx_metadata_t md;
+    size_t num_recvd = rx_stream->recv(&buff.front(), buff.size(), md, 1.0, true);
+    BOOST_CHECK_EQUAL(num_recvd, buff.size());
+    BOOST_CHECK(md.more_fragments);
+
+    rx_streamer::recv_view_type view;
+    num_recvd += rx_stream->recv_view(view, md, 1.0);
+    BOOST_CHECK_EQUAL(view.nsamps_per_buff, spp - buff.size());
+    BOOST_CHECK_EQUAL(md.fragment_offset, buff.size());
+    BOOST_CHECK(not md.more_fragments);
+
+    //the remaining packets are lent whole, one lease per channel
+    while (not md.end_of_burst){
+        BOOST_REQUIRE_EQUAL(rx_stream->recv_view(view, md, 1.0), view.nsamps_per_buff);
+        BOOST_REQUIRE_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_REQUIRE_EQUAL(view.buffs.size(), 1);
+        BOOST_REQUIRE_EQUAL(view.leases.size(), 1);
+        BOOST_CHECK(view.leases[0]->size() > view.nsamps_per_buff*sizeof(boost::uint32_t));
+        num_recvd += view.nsamps_per_buff;
+    }
+    BOOST_CHECK_EQUAL(num_recvd, spp*10);
+
+    view.release();
+    BOOST_CHECK(view.buffs.empty());
+    BOOST_CHECK(view.leases.empty());
+
+    //a timeout leaves the view empty
+    BOOST_CHECK_EQUAL(rx_stream->recv_view(view, md, 0.01), 0);
+    BOOST_CHECK_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_TIMEOUT);
+    BOOST_CHECK(view.leases.empty());
+}
+
+typedef boost::shared_ptr<rx_streamer::recv_view_type> view_sptr;
+
+static void release_views(transport::bounded_buffer<view_sptr> *views, size_t *num_samps){
+    view_sptr view;
+    while (true){
+        views->pop_with_wait(view);
+        if (not view) return;
+        *num_samps += view->nsamps_per_buff;
+        view->release();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_rx_recv_view_release_on_worker){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t("type=sim,throttle=0"));
+    usrp->set_rx_rate(10e6);
+    rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args_t("sc16", "sc16"));
+    const size_t spp = rx_stream->get_max_num_samps();
+    static const size_t NUM_PKTS = 1000;
+
+    //a processing thread releases the views while the receive goes on
+    transport::bounded_buffer<view_sptr> views(4);
+    size_t num_released = 0;
+    boost::thread worker(boost::bind(&release_views, &views, &num_released));
+
+    stream_cmd_t stream_cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+    stream_cmd.num_samps = spp*NUM_PKTS;
+    stream_cmd.stream_now = true;
+    usrp->issue_stream_cmd(stream_cmd);
+
+    rx_metadata_t md;
+    do{
+        view_sptr view(new rx_streamer::recv_view_type());
+        rx_stream->recv_view(*view, md, 1.0);
+        BOOST_REQUIRE_EQUAL(md.error_code, rx_metadata_t::ERROR_CODE_NONE);
+        views.push_with_wait(view);
+    } while (not md.end_of_burst);
+    views.push_with_wait(view_sptr());
+    worker.join();
+
+    //every frame went back to the transport: nothing was lost or reused early
+    BOOST_CHECK_EQUAL(num_released, spp*NUM_PKTS);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_tx_send_view){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t("type=sim"));
+    usrp->set_tx_rate(1e6);
+    tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args_t("sc16", "sc16"));
+
+    tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = true;
+    md.has_time_spec = true;
+    md.time_spec = usrp->get_time_now() + time_spec_t(0.01);
+
+    //the samples are written straight into the send frame
+    tx_streamer::send_view_type view;
+    BOOST_CHECK_EQUAL(tx_stream->get_send_view(view, true, 1.0), tx_stream->get_max_num_samps());
+    BOOST_REQUIRE_EQUAL(view.buffs.size(), 1);
+    std::memset(view.buffs[0], 0, 100*sizeof(boost::uint32_t));
+
+    //the header reserved for a time spec cannot carry an untimed packet
+    tx_metadata_t untimed_md = md;
+    untimed_md.has_time_spec = false;
+    BOOST_CHECK_THROW(tx_stream->commit_send_view(view, 100, untimed_md), uhd::value_error);
+
+    BOOST_CHECK_EQUAL(tx_stream->commit_send_view(view, 100, md), 100);
+    BOOST_CHECK(view.leases.empty());
+    BOOST_CHECK_THROW(tx_stream->commit_send_view(view, 100, md), uhd::value_error);
+
+    async_metadata_t async_md;
+    BOOST_REQUIRE(usrp->get_device()->recv_async_msg(async_md, 1.0));
+    BOOST_CHECK_EQUAL(async_md.event_code, async_metadata_t::EVENT_CODE_BURST_ACK);
+    BOOST_CHECK(async_md.time_spec > md.time_spec);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_tx_send_view_drop){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t("type=sim"));
+    usrp->set_tx_rate(1e6);
+    tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args_t("sc16", "sc16"));
+
+    //views dropped without a commit send nothing and cost no flow control credit,
+    //so dropping more than the device buffer holds does not stall the streamer
+    tx_streamer::send_view_type view;
+    for (size_t i = 0; i < 2000; i++){
+        BOOST_REQUIRE_EQUAL(tx_stream->get_send_view(view, false, 1.0), tx_stream->get_max_num_samps());
+        view.release();
+    }
+
+    std::vector<boost::uint32_t> buff(1000);
+    tx_metadata_t md;
+    md.start_of_burst = true;
+    md.end_of_burst = true;
+    md.has_time_spec = true;
+    md.time_spec = usrp->get_time_now() + time_spec_t(0.01);
+    BOOST_CHECK_EQUAL(tx_stream->send(&buff.front(), buff.size(), md, 1.0), buff.size());
+
+    async_metadata_t async_md;
+    BOOST_REQUIRE(usrp->get_device()->recv_async_msg(async_md, 1.0));
+    BOOST_CHECK_EQUAL(async_md.event_code, async_metadata_t::EVENT_CODE_BURST_ACK);
+}
+
+BOOST_AUTO_TEST_CASE(test_sim_stream_stats){
+    usrp::multi_usrp::sptr usrp = usrp::multi_usrp::make(device_addr_t(
+        "type=sim,throttle=0,inject_seq_error=15"
+    ));
+    property_tree::sptr tree = usrp->get_device()->get_tree();
+
+    //nothing is counted without a streamer
+    BOOST_CHECK_EQUAL(tree->access<rx_stream_stats_t>("/mboards/0/rx_dsps/0/stats").get().num_packets, 0);
+    BOOST_CHECK_EQUAL(tree->access<tx_stream_stats_t>("/mboards/0/tx_dsps/0/stats").get().num_packets, 0);
+
+    rx_streamer::sptr rx_stream = usrp->get_rx_stream(stream_args_t("fc32"));
+    std::vector<std::complex<float> > buff(rx_stream->get_max_num_samps());
+    stream_cmd_t stream_cmd(stream_cmd_t::STREAM_MODE_NUM_SAMPS_AND_DONE);
+    stream_cmd.num_samps = buff.size()*100;
+    stream_cmd.stream_now = true;
+    usrp->issue_stream_cmd(stream_cmd);
+    rx_metadata_t rx_md;
+    do{
+        rx_stream->recv(&buff.front(), buff.size(), rx_md, 1.0, true);
+        if (rx_md.error_code == rx_metadata_t::ERROR_CODE_TIMEOUT) break;
+    } while (not rx_md.end_of_burst);
+    rx_stream->recv(&buff.front(), buff.size(), rx_md, 0.01, true);
+
+    const rx_stream_stats_t rx_stats = tree->access<rx_stream_stats_t>("/mboards/0/rx_dsps/0/stats").get();
+    BOOST_CHECK(rx_stats.num_packets > 0);
+    BOOST_CHECK(rx_stats.num_bytes >= rx_stats.num_packets);
+    BOOST_CHECK(rx_stats.num_timeouts >= 1);
+    BOOST_REQUIRE_EQUAL(rx_stats.seq_errors.size(), 1);
+    BOOST_CHECK(rx_stats.seq_errors[0] > 0);
+    BOOST_CHECK(rx_stats.align_iterations.count > 0);
+    BOOST_CHECK(rx_stats.get_buff_ns.count > 0);
+    BOOST_CHECK(rx_stats.convert_ns.count > 0);
+
+    tx_streamer::sptr tx_stream = usrp->get_tx_stream(stream_args_t("fc32"));
+    tx_metadata_t tx_md;
+    tx_md.start_of_burst = true;
+    tx_md.end_of_burst = true;
+    BOOST_CHECK_EQUAL(tx_stream->send(&buff.front(), buff.size(), tx_md, 1.0), buff.size());
+
+    const tx_stream_stats_t tx_stats = tree->access<tx_stream_stats_t>("/mboards/0/tx_dsps/0/stats").get();
+    BOOST_CHECK_EQUAL(tx_stats.num_timeouts, 0);
+    BOOST_CHECK(tx_stats.num_packets > 0);
+    BOOST_CHECK(tx_stats.num_bytes >= buff.size()*sizeof(boost::uint32_t));
+    BOOST_CHECK_EQUAL(tx_stats.get_buff_ns.count, 1); //the first packet is sampled
+}
@@ -705,3 +705,173 @@ BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_fragment){
     }
 
 }
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_multi_channel_convert_threads){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_be";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 0;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 0;
+    ifpi.tsf = 0;
+    ifpi.has_tlr = false;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 10e6;
+    static const size_t NUM_PKTS_TO_TEST = 30;
+    static const size_t NUM_SAMPS_PER_BUFF = 20;
+    static const size_t NCHANNELS = 4;
+
+    std::vector<dummy_recv_xport_class> dummy_recv_xports(NCHANNELS, dummy_recv_xport_class("big"));
+
+    //generate a bunch of packets, the first word is unique per channel
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        ifpi.num_payload_words32 = 10 + i%10;
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            dummy_recv_xports[ch].push_back_packet(ifpi, ch+1);
+        }
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*size_t(TICK_RATE/SAMP_RATE);
+    }
+
+    //the copied transports share the packet memory with the originals
+    std::vector<dummy_recv_xport_class> serial_recv_xports(dummy_recv_xports);
+
+    //create a serial and a threaded super receive packet handler
+    uhd::transport::sph::recv_packet_handler serial_handler(NCHANNELS);
+    uhd::transport::sph::recv_packet_handler handler(NCHANNELS);
+    handler.set_convert_threads(2);
+    for (size_t i = 0; i < 2; i++){
+        uhd::transport::sph::recv_packet_handler &h = (i == 0)? serial_handler : handler;
+        std::vector<dummy_recv_xport_class> &xports = (i == 0)? serial_recv_xports : dummy_recv_xports;
+        h.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+        h.set_tick_rate(TICK_RATE);
+        h.set_samp_rate(SAMP_RATE);
+        for (size_t ch = 0; ch < NCHANNELS; ch++){
+            h.set_xport_chan_get_buff(ch, boost::bind(&dummy_recv_xport_class::get_recv_buff, &xports[ch], _1));
+        }
+        h.set_converter(id);
+    }
+
+    //check the received packets against the serial conversion
+    size_t num_accum_samps = 0;
+    std::vector<std::complex<float> > serial_mem(NUM_SAMPS_PER_BUFF*NCHANNELS);
+    std::vector<std::complex<float> > mem(NUM_SAMPS_PER_BUFF*NCHANNELS);
+    std::vector<std::complex<float> *> serial_buffs(NCHANNELS), buffs(NCHANNELS);
+    for (size_t ch = 0; ch < NCHANNELS; ch++){
+        serial_buffs[ch] = &serial_mem[ch*NUM_SAMPS_PER_BUFF];
+        buffs[ch] = &mem[ch*NUM_SAMPS_PER_BUFF];
+    }
+    uhd::rx_metadata_t serial_metadata, metadata;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        std::cout << "data check " << i << std::endl;
+        const size_t serial_num_samps_ret = serial_handler.recv(
+            serial_buffs, NUM_SAMPS_PER_BUFF, serial_metadata, 1.0, true
+        );
+        const size_t num_samps_ret = handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK(not metadata.more_fragments);
+        BOOST_CHECK(metadata.has_time_spec);
+        BOOST_CHECK_TS_CLOSE(metadata.time_spec, uhd::time_spec_t(0, num_accum_samps, SAMP_RATE));
+        BOOST_CHECK_EQUAL(num_samps_ret, 10 + i%10);
+        BOOST_CHECK_EQUAL(num_samps_ret, serial_num_samps_ret);
+        BOOST_CHECK(mem == serial_mem);
+        for (size_t ch = 1; ch < NCHANNELS; ch++){
+            BOOST_CHECK(mem[ch*NUM_SAMPS_PER_BUFF] != mem[0]);
+        }
+        num_accum_samps += num_samps_ret;
+    }
+
+    //subsequent receives should be a timeout
+    for (size_t i = 0; i < 3; i++){
+        std::cout << "timeout check " << i << std::endl;
+        handler.recv(
+            buffs, NUM_SAMPS_PER_BUFF, metadata, 1.0, true
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_TIMEOUT);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_recv_one_channel_exact_time){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "sc16_item32_be";
+    id.num_inputs = 1;
+    id.output_format = "fc32";
+    id.num_outputs = 1;
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 100e6/3;
+    static const long TICKS_PER_SEC = 100000000;
+    static const long TICKS_PER_SAMP = 3;
+    static const size_t NUM_PKTS_TO_TEST = 20;
+
+    //start a few packets before a second boundary, late in a long capture
+    dummy_recv_xport_class dummy_recv_xport("big");
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    ifpi.packet_type = uhd::transport::vrt::if_packet_info_t::PACKET_TYPE_DATA;
+    ifpi.num_payload_words32 = 10;
+    ifpi.packet_count = 0;
+    ifpi.sob = true;
+    ifpi.eob = false;
+    ifpi.has_sid = false;
+    ifpi.has_cid = false;
+    ifpi.has_tsi = true;
+    ifpi.has_tsf = true;
+    ifpi.tsi = 86400;
+    ifpi.tsf = TICKS_PER_SEC - 5*10*TICKS_PER_SAMP;
+    ifpi.has_tlr = false;
+    const boost::uint64_t start_ticks = ifpi.tsi*boost::uint64_t(TICKS_PER_SEC) + ifpi.tsf;
+
+    //generate a bunch of packets, normalized like the device does
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        dummy_recv_xport.push_back_packet(ifpi);
+        ifpi.packet_count++;
+        ifpi.tsf += ifpi.num_payload_words32*TICKS_PER_SAMP;
+        if (ifpi.tsf >= boost::uint64_t(TICKS_PER_SEC)){
+            ifpi.tsf -= TICKS_PER_SEC;
+            ifpi.tsi++;
+        }
+    }
+
+    //create the super receive packet handler
+    uhd::transport::sph::recv_packet_handler handler(1);
+    handler.set_vrt_unpacker(&uhd::transport::vrt::if_hdr_unpack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_recv_xport_class::get_recv_buff, &dummy_recv_xport, _1));
+    handler.set_converter(id);
+
+    //receive in fragments, every time spec should land on an exact tick
+    size_t num_accum_samps = 0;
+    std::vector<std::complex<float> > buff(4);
+    uhd::rx_metadata_t metadata;
+    while (num_accum_samps < NUM_PKTS_TO_TEST*10){
+        size_t num_samps_ret = handler.recv(
+            &buff.front(), buff.size(), metadata, 1.0, true
+        );
+        BOOST_CHECK_EQUAL(metadata.error_code, uhd::rx_metadata_t::ERROR_CODE_NONE);
+        BOOST_CHECK(metadata.has_time_spec);
+        const boost::uint64_t ticks = start_ticks + num_accum_samps*TICKS_PER_SAMP;
+        BOOST_CHECK_EQUAL(metadata.time_spec.get_full_secs(), time_t(ticks/TICKS_PER_SEC));
+        BOOST_CHECK_EQUAL(metadata.time_spec.get_tick_count(TICK_RATE), long(ticks%TICKS_PER_SEC));
+        BOOST_REQUIRE(num_samps_ret != 0);
+        num_accum_samps += num_samps_ret;
+    }
+}
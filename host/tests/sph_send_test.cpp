@@ -200,3 +200,94 @@ BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_full_buffer_mode){
         num_accum_samps += ifpi.num_payload_words32;
     }
 }
+
+////////////////////////////////////////////////////////////////////////
+static void count_flush(size_t *num_flushes){
+    (*num_flushes)++;
+}
+
+BOOST_AUTO_TEST_CASE(test_sph_send_flush_per_send_call){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "fc32";
+    id.num_inputs = 1;
+    id.output_format = "sc16_item32_be";
+    id.num_outputs = 1;
+
+    dummy_send_xport_class dummy_send_xport("big");
+
+    static const size_t NUM_SENDS_TO_TEST = 5;
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(1);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(100e6);
+    handler.set_samp_rate(10e6);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xport, _1));
+    size_t num_flushes = 0;
+    handler.set_xport_chan_flush(0, boost::bind(&count_flush, &num_flushes));
+    handler.set_converter(id);
+    handler.set_max_samples_per_packet(20);
+
+    //allocate metadata and buffer
+    std::vector<std::complex<float> > buff(100);
+    uhd::tx_metadata_t metadata;
+
+    //each call fragments into several packets but flushes once
+    for (size_t i = 0; i < NUM_SENDS_TO_TEST; i++){
+        metadata.end_of_burst = (i == NUM_SENDS_TO_TEST-1);
+        const size_t num_sent = handler.send(&buff.front(), buff.size(), metadata, 1.0);
+        BOOST_CHECK_EQUAL(num_sent, buff.size());
+        BOOST_CHECK_EQUAL(num_flushes, i+1);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+BOOST_AUTO_TEST_CASE(test_sph_send_one_channel_exact_time){
+////////////////////////////////////////////////////////////////////////
+    uhd::convert::id_type id;
+    id.input_format = "fc32";
+    id.num_inputs = 1;
+    id.output_format = "sc16_item32_be";
+    id.num_outputs = 1;
+
+    dummy_send_xport_class dummy_send_xport("big");
+
+    static const double TICK_RATE = 100e6;
+    static const double SAMP_RATE = 100e6/3;
+    static const boost::uint64_t TICKS_PER_SEC = 100000000;
+    static const boost::uint64_t TICKS_PER_SAMP = 3;
+    static const size_t NUM_PKTS_TO_TEST = 10;
+
+    //create the super send packet handler
+    uhd::transport::sph::send_packet_handler handler(1);
+    handler.set_vrt_packer(&uhd::transport::vrt::if_hdr_pack_be);
+    handler.set_tick_rate(TICK_RATE);
+    handler.set_samp_rate(SAMP_RATE);
+    handler.set_xport_chan_get_buff(0, boost::bind(&dummy_send_xport_class::get_send_buff, &dummy_send_xport, _1));
+    handler.set_converter(id);
+    handler.set_max_samples_per_packet(20);
+
+    //one send fragments across a second boundary
+    const boost::uint64_t start_ticks = 86400*TICKS_PER_SEC + TICKS_PER_SEC - 4*20*TICKS_PER_SAMP;
+    std::vector<std::complex<float> > buff(20*NUM_PKTS_TO_TEST);
+    uhd::tx_metadata_t metadata;
+    metadata.start_of_burst = true;
+    metadata.end_of_burst = true;
+    metadata.has_time_spec = true;
+    metadata.time_spec = uhd::time_spec_t(
+        time_t(start_ticks/TICKS_PER_SEC), long(start_ticks%TICKS_PER_SEC), TICK_RATE
+    );
+    BOOST_CHECK_EQUAL(handler.send(&buff.front(), buff.size(), metadata, 1.0), buff.size());
+
+    //check the fragment timestamps tick for tick
+    uhd::transport::vrt::if_packet_info_t ifpi;
+    for (size_t i = 0; i < NUM_PKTS_TO_TEST; i++){
+        dummy_send_xport.pop_front_packet(ifpi);
+        const boost::uint64_t ticks = start_ticks + i*20*TICKS_PER_SAMP;
+        BOOST_CHECK_EQUAL(ifpi.num_payload_words32, 20);
+        BOOST_CHECK_EQUAL(ifpi.tsi, ticks/TICKS_PER_SEC);
+        BOOST_CHECK_EQUAL(ifpi.tsf, ticks%TICKS_PER_SEC);
+        BOOST_CHECK_EQUAL(ifpi.eob, i == NUM_PKTS_TO_TEST-1);
+    }
+}
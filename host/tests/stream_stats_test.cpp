@@ -0,0 +1,61 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include <uhd/types/stream_stats.hpp>
+
+using namespace uhd;
+
+BOOST_AUTO_TEST_CASE(test_log2_histogram_buckets){
+    log2_histogram_t hist;
+    BOOST_CHECK_EQUAL(hist.get_mean(), 0.0);
+    BOOST_CHECK_EQUAL(hist.get_percentile(0.5), 0);
+
+    hist.add(0);
+    hist.add(1);
+    hist.add(2);
+    hist.add(3);
+    hist.add(100);
+    BOOST_CHECK_EQUAL(hist.count, 5);
+    BOOST_CHECK_EQUAL(hist.sum, 106);
+    BOOST_CHECK_EQUAL(hist.buckets[0], 1);
+    BOOST_CHECK_EQUAL(hist.buckets[1], 1);
+    BOOST_CHECK_EQUAL(hist.buckets[2], 2);
+    BOOST_CHECK_EQUAL(hist.buckets[7], 1);
+    BOOST_CHECK_CLOSE(hist.get_mean(), 21.2, 0.001);
+
+    //percentiles are the upper edges of the buckets
+    BOOST_CHECK_EQUAL(hist.get_percentile(0.5), 3);
+    BOOST_CHECK_EQUAL(hist.get_percentile(1.0), 127);
+
+    //huge values land in the last bucket
+    hist.add(~boost::uint64_t(0));
+    BOOST_CHECK_EQUAL(hist.buckets[log2_histogram_t::num_buckets-1], 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_stream_stats_defaults){
+    rx_stream_stats_t rx_stats;
+    BOOST_CHECK_EQUAL(rx_stats.num_packets, 0);
+    BOOST_CHECK(rx_stats.seq_errors.empty());
+    BOOST_CHECK_EQUAL(rx_stats.align_iterations.count, 0);
+    BOOST_CHECK(not rx_stats.to_pp_string().empty());
+
+    tx_stream_stats_t tx_stats;
+    BOOST_CHECK_EQUAL(tx_stats.num_packets, 0);
+    BOOST_CHECK_EQUAL(tx_stats.fc_wait_ns.count, 0);
+    BOOST_CHECK(not tx_stats.to_pp_string().empty());
+}
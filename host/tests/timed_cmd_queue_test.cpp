@@ -0,0 +1,125 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <boost/test/unit_test.hpp>
+#include "../lib/usrp/common/timed_cmd_queue.hpp"
+#include <boost/bind.hpp>
+#include <vector>
+
+using uhd::time_spec_t;
+
+/***********************************************************************
+ * A simulated device: a register map behind the queue,
+ * driven by a clock that only moves when the test says so
+ **********************************************************************/
+struct sim_device{
+    sim_device(void): queue(4), regs(4, 0){}
+
+    struct cmd_type{
+        size_t addr;
+        int data;
+    };
+
+    void poke(const time_spec_t &time, size_t addr, int data){
+        cmd_type cmd;
+        cmd.addr = addr;
+        cmd.data = data;
+        BOOST_REQUIRE(queue.push(time, cmd));
+    }
+
+    size_t tick(const time_spec_t &time){
+        now = time;
+        return queue.run(now, boost::bind(&sim_device::write, this, _1));
+    }
+
+    void write(const cmd_type &cmd){
+        regs[cmd.addr] = cmd.data;
+        log.push_back(cmd.data);
+    }
+
+    timed_cmd_queue<cmd_type> queue;
+    std::vector<int> regs, log;
+    time_spec_t now;
+};
+
+BOOST_AUTO_TEST_CASE(test_timed_cmd_run_at_time){
+    sim_device dev;
+    dev.poke(time_spec_t(1.0), 0, 10);
+    dev.poke(time_spec_t(1.5), 1, 11);
+
+    //nothing runs before its time
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(0.999)), size_t(0));
+    BOOST_CHECK_EQUAL(dev.regs[0], 0);
+    BOOST_CHECK_CLOSE(dev.queue.get_wait(dev.now).get_real_secs(), 0.001, 1e-3);
+
+    //then each write runs at its time
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(1.0)), size_t(1));
+    BOOST_CHECK_EQUAL(dev.regs[0], 10);
+    BOOST_CHECK_EQUAL(dev.regs[1], 0);
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(2.0)), size_t(1));
+    BOOST_CHECK_EQUAL(dev.regs[1], 11);
+    BOOST_CHECK(dev.queue.empty());
+    BOOST_CHECK_EQUAL(dev.queue.get_wait(dev.now).get_real_secs(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_timed_cmd_in_order){
+    sim_device dev;
+
+    //the front command holds back a later command with an earlier time
+    dev.poke(time_spec_t(2.0), 0, 1);
+    dev.poke(time_spec_t(1.0), 0, 2);
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(1.5)), size_t(0));
+
+    //and then both run in order, the late one upon arrival at the front
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(2.0)), size_t(2));
+    BOOST_CHECK_EQUAL(dev.regs[0], 2);
+    BOOST_REQUIRE_EQUAL(dev.log.size(), size_t(2));
+    BOOST_CHECK_EQUAL(dev.log[0], 1);
+    BOOST_CHECK_EQUAL(dev.log[1], 2);
+
+    //a late command runs at the next tick
+    dev.poke(time_spec_t(0.5), 3, 3);
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(2.0)), size_t(1));
+    BOOST_CHECK_EQUAL(dev.regs[3], 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_timed_cmd_back_pressure){
+    sim_device dev;
+    timed_cmd_queue<int> mirror(dev.queue.depth());
+
+    //the host mirror fills up along with the device queue
+    for (int i = 0; i < 4; i++){
+        BOOST_CHECK(mirror.push(time_spec_t(1.0 + i), i));
+        dev.poke(time_spec_t(1.0 + i), 0, i);
+    }
+    BOOST_CHECK(mirror.full());
+    BOOST_CHECK(not mirror.push(time_spec_t(5.0), 4));
+
+    //the host waits for the front command, then both queues have room
+    const time_spec_t now(0.25);
+    BOOST_CHECK_EQUAL(mirror.retire(now), size_t(0));
+    const time_spec_t wake = now + mirror.get_wait(now);
+    BOOST_CHECK_CLOSE(wake.get_real_secs(), 1.0, 1e-9);
+    BOOST_CHECK_EQUAL(mirror.retire(wake), size_t(1));
+    BOOST_CHECK_EQUAL(dev.tick(wake), size_t(1));
+    BOOST_CHECK(mirror.push(time_spec_t(5.0), 4));
+    dev.poke(time_spec_t(5.0), 0, 4);
+
+    BOOST_CHECK_EQUAL(dev.tick(time_spec_t(10.0)), size_t(4));
+    BOOST_CHECK_EQUAL(mirror.retire(time_spec_t(10.0)), size_t(4));
+    BOOST_CHECK_EQUAL(dev.regs[0], 4);
+}
@@ -0,0 +1,894 @@
+//
+// Copyright 2013 Fairwaves LLC
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "../lib/usrp/usrp2/fw_common.h"
+#include "../lib/usrp/usrp2/usrp2_regs.hpp"
+#include "../lib/usrp/common/timed_cmd_queue.hpp"
+#include <uhd/transport/vrt_if_packet.hpp>
+#include <uhd/types/metadata.hpp>
+#include <uhd/types/time_spec.hpp>
+#include <uhd/utils/byteswap.hpp>
+#include <uhd/utils/thread_priority.hpp>
+#include <uhd/utils/safe_main.hpp>
+#include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/math/special_functions/round.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/format.hpp>
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <iostream>
+#include <complex>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace po = boost::program_options;
+namespace asio = boost::asio;
+using namespace uhd;
+using namespace uhd::transport;
+
+typedef boost::shared_ptr<asio::ip::udp::socket> socket_type;
+
+static const size_t insane_mtu = 9000;
+static const boost::uint64_t TICK_RATE = 100000000; //the N210 master clock
+static const size_t TONE_PERIOD = 16; //samples per period of the RX test tone
+static const size_t EMU_SRAM_BYTES = size_t(1 << 20); //the TX buffer that the host flow control fills
+static const double PI = 3.14159265358979323846;
+
+//The emulated device reports itself as an N210 (see mboard_eeprom_t).
+static const boost::uint16_t EMU_HW_REV = 0x0A01;
+static const boost::uint8_t EMU_MAC_ADDR[6] = {0x00, 0x50, 0xC2, 0x85, 0x3f, 0xff};
+static const size_t EMU_SERIAL_OFFSET = 0x18;
+
+//register offsets of the rx dsp, tx dsp, and time64 cores
+static const boost::uint32_t RX_CTRL_STREAM_CMD = 0;
+static const boost::uint32_t RX_CTRL_TIME_SECS = 4;
+static const boost::uint32_t RX_CTRL_TIME_TICKS = 8;
+static const boost::uint32_t RX_CTRL_CLEAR = 12;
+static const boost::uint32_t RX_CTRL_VRT_SID = 20;
+static const boost::uint32_t RX_CTRL_NSAMPS_PP = 28;
+static const boost::uint32_t RX_CTRL_FORMAT = 36;
+static const boost::uint32_t DSP_DECIM_INTERP = 8;
+static const boost::uint32_t TX_CTRL_CLEAR_STATE = 4;
+static const boost::uint32_t TX_CTRL_REPORT_SID = 8;
+static const boost::uint32_t TX_CTRL_POLICY = 12;
+static const boost::uint32_t TX_CTRL_CYCLES_PER_UP = 16;
+static const boost::uint32_t TX_CTRL_PACKETS_PER_UP = 20;
+static const boost::uint32_t TX_CTRL_POLICY_NEXT_PACKET = (0x1 << 1);
+static const boost::uint32_t TX_CTRL_UP_ENB = (1ul << 31);
+static const boost::uint32_t TIME64_SECS = 0;
+static const boost::uint32_t TIME64_TICKS = 4;
+static const boost::uint32_t TIME64_IMM = 12;
+
+/***********************************************************************
+ * Signal handlers
+ **********************************************************************/
+static bool stop_signal_called = false;
+void sig_int_handler(int){stop_signal_called = true;}
+
+static bool wait_for_recv_ready(int sock_fd, const double timeout){
+    //setup timeval for timeout
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = long(std::max(timeout, 0.0)*1e6);
+
+    //setup rset for timeout
+    fd_set rset;
+    FD_ZERO(&rset);
+    FD_SET(sock_fd, &rset);
+
+    //call select with timeout on receive socket
+    return ::select(sock_fd+1, &rset, NULL, NULL, &tv) > 0;
+}
+
+static socket_type make_socket(
+    asio::io_service &io_service, const std::string &bind, const boost::uint16_t port,
+    const size_t rx_size = 0, const size_t tx_size = 0
+){
+    asio::ip::udp::endpoint endpoint(asio::ip::address::from_string(bind), port);
+    socket_type sock(new asio::ip::udp::socket(io_service, endpoint));
+    if (rx_size != 0) sock->set_option(asio::socket_base::receive_buffer_size(rx_size));
+    if (tx_size != 0) sock->set_option(asio::socket_base::send_buffer_size(tx_size));
+    return sock;
+}
+
+/***********************************************************************
+ * Settings registers shared by the cores
+ **********************************************************************/
+class emu_regs{
+public:
+    void poke32(const boost::uint32_t addr, const boost::uint32_t data){
+        boost::mutex::scoped_lock lock(_mutex);
+        _regs[addr] = data;
+    }
+
+    boost::uint32_t peek32(const boost::uint32_t addr){
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<boost::uint32_t, boost::uint32_t>::const_iterator it = _regs.find(addr);
+        return (it == _regs.end())? 0 : it->second;
+    }
+
+private:
+    boost::mutex _mutex;
+    std::map<boost::uint32_t, boost::uint32_t> _regs;
+};
+
+/***********************************************************************
+ * Time core: the device time follows the host system clock
+ **********************************************************************/
+class emu_time_core{
+public:
+    emu_time_core(void): _offset(0 - sys_ticks()), _pps_pending(false){
+        /* NOP */
+    }
+
+    boost::uint64_t get_ticks_now(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        const boost::uint64_t sys = sys_ticks();
+        this->handle_pps(sys);
+        return sys + _offset;
+    }
+
+    boost::uint64_t get_ticks_last_pps(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        const boost::uint64_t sys = sys_ticks();
+        this->handle_pps(sys);
+        return sys - sys%TICK_RATE + _offset;
+    }
+
+    void set_ticks(const boost::uint64_t ticks, const bool now){
+        boost::mutex::scoped_lock lock(_mutex);
+        const boost::uint64_t sys = sys_ticks();
+        if (now){
+            _offset = ticks - sys;
+            _pps_pending = false;
+        }
+        else{
+            //a PPS edge happens on each whole second of the system clock
+            _pps_ticks = ticks;
+            _pps_sys = sys - sys%TICK_RATE + TICK_RATE;
+            _pps_pending = true;
+        }
+    }
+
+private:
+    static boost::uint64_t sys_ticks(void){
+        const time_spec_t t = time_spec_t::get_system_time();
+        return boost::uint64_t(t.get_full_secs())*TICK_RATE + t.get_tick_count(double(TICK_RATE));
+    }
+
+    void handle_pps(const boost::uint64_t sys){
+        if (not _pps_pending or sys < _pps_sys) return;
+        _offset = _pps_ticks - _pps_sys;
+        _pps_pending = false;
+    }
+
+    boost::mutex _mutex;
+    boost::uint64_t _offset;
+    bool _pps_pending;
+    boost::uint64_t _pps_ticks, _pps_sys;
+};
+
+/***********************************************************************
+ * Pack a context packet: the code word and the flow control sequence
+ **********************************************************************/
+static size_t pack_context(
+    boost::uint32_t *frame, const boost::uint32_t sid, const size_t packet_count,
+    const boost::uint64_t ticks, const boost::uint32_t code, const boost::uint32_t seq
+){
+    vrt::if_packet_info_t if_packet_info;
+    if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_CONTEXT;
+    if_packet_info.num_payload_words32 = 2;
+    if_packet_info.num_payload_bytes = 2*sizeof(boost::uint32_t);
+    if_packet_info.packet_count = packet_count;
+    if_packet_info.sob = false;
+    if_packet_info.eob = false;
+    if_packet_info.has_sid = true;
+    if_packet_info.sid = sid;
+    if_packet_info.has_cid = false;
+    if_packet_info.has_tsi = true;
+    if_packet_info.tsi = boost::uint32_t(ticks/TICK_RATE);
+    if_packet_info.has_tsf = true;
+    if_packet_info.tsf = ticks%TICK_RATE;
+    if_packet_info.has_tlr = false;
+    vrt::if_hdr_pack_be(frame, if_packet_info);
+    frame[if_packet_info.num_header_words32 + 0] = uhd::htonx(code);
+    frame[if_packet_info.num_header_words32 + 1] = uhd::htonx(seq);
+    return if_packet_info.num_packet_words32*sizeof(boost::uint32_t);
+}
+
+static size_t decim_interp_rate(const boost::uint32_t word){
+    //the halfbands double the rate of the cic
+    size_t rate = std::max<size_t>(word & 0xff, 1);
+    if (word & (1 << 8)) rate *= 2;
+    if (word & (1 << 9)) rate *= 2;
+    return rate;
+}
+
+/***********************************************************************
+ * RX DSP: executes stream commands and streams a test tone
+ **********************************************************************/
+struct rx_cmd_t{
+    bool now, chain, reload, stop;
+    size_t num_samps;
+    boost::uint64_t ticks;
+};
+
+class emu_rx_dsp{
+public:
+    typedef boost::shared_ptr<emu_rx_dsp> sptr;
+
+    emu_rx_dsp(
+        emu_regs &regs, emu_time_core &time, socket_type sock,
+        const boost::uint32_t dsp_base, const boost::uint32_t ctrl_base, const bool throttle
+    ):
+        _regs(regs), _time(time), _sock(sock),
+        _dsp_base(dsp_base), _ctrl_base(ctrl_base), _throttle(throttle),
+        _host_known(false), _streaming(false), _packet_count(0)
+    {
+        //one period of a full scale tone for each wire format,
+        //repeated to cover one frame so that any payload is a single copy
+        const size_t num_items = TONE_PERIOD + insane_mtu/2;
+        _tone_sc16.resize(num_items*4);
+        _tone_sc8.resize(num_items*2);
+        for (size_t i = 0; i < num_items; i++){
+            const std::complex<double> samp = std::polar(0.7, 2*PI*double(i%TONE_PERIOD)/TONE_PERIOD);
+            const boost::int32_t re16 = boost::math::iround(samp.real()*32767);
+            const boost::int32_t im16 = boost::math::iround(samp.imag()*32767);
+            boost::uint32_t *item = reinterpret_cast<boost::uint32_t *>(&_tone_sc16[i*4]);
+            *item = uhd::htonx(boost::uint32_t((boost::uint32_t(re16) << 16) | (boost::uint32_t(im16) & 0xffff)));
+            _tone_sc8[(i^1)*2 + 0] = char(boost::math::iround(samp.real()*127));
+            _tone_sc8[(i^1)*2 + 1] = char(boost::math::iround(samp.imag()*127));
+        }
+    }
+
+    //! Called on the poke to the time ticks register, which latches the command
+    void issue_stream_cmd(const boost::uint32_t word, const boost::uint32_t secs, const boost::uint32_t ticks){
+        rx_cmd_t cmd;
+        cmd.now = (word & (1ul << 31)) != 0;
+        cmd.chain = (word & (1 << 30)) != 0;
+        cmd.reload = (word & (1 << 29)) != 0;
+        cmd.stop = (word & (1 << 28)) != 0;
+        cmd.num_samps = word & 0x0fffffff;
+        cmd.ticks = boost::uint64_t(secs)*TICK_RATE + ticks;
+        boost::mutex::scoped_lock lock(_mutex);
+        _cmds.push_back(cmd);
+        _cond.notify_one();
+    }
+
+    void clear(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _cmds.clear();
+        _streaming = false;
+        _packet_count = 0;
+    }
+
+    void run(void){
+        uhd::set_thread_priority_safe();
+        std::vector<boost::uint32_t> frame(insane_mtu/sizeof(boost::uint32_t));
+        while (not boost::this_thread::interruption_requested()){
+            this->recv_host_packets();
+
+            boost::mutex::scoped_lock lock(_mutex);
+            size_t len = 0;
+            boost::uint64_t end_ticks = 0;
+
+            //a new command replaces a reloading (continuous) one
+            if (not _streaming or (_cmd.reload and not _cmds.empty())){
+                _streaming = false;
+                if (_cmds.empty()){
+                    _cond.timed_wait(lock, boost::posix_time::milliseconds(10));
+                    continue;
+                }
+                len = this->start_cmd(&frame.front());
+            }
+            if (_streaming) len = this->pack_data(&frame.front(), end_ticks);
+            lock.unlock();
+
+            //wait for the samples to be "acquired"
+            if (_throttle and end_ticks != 0){
+                const boost::int64_t wait_ticks = boost::int64_t(end_ticks - _time.get_ticks_now());
+                if (wait_ticks > 0) boost::this_thread::sleep(
+                    boost::posix_time::microseconds(long(wait_ticks/(TICK_RATE/1000000)))
+                );
+            }
+
+            if (len != 0 and _host_known) _sock->send_to(asio::buffer(&frame.front(), len), _host);
+        }
+    }
+
+private:
+    //! Learn the host endpoint from the packets the host sends to this port
+    void recv_host_packets(void){
+        boost::uint32_t buff[insane_mtu/sizeof(boost::uint32_t)];
+        while (_sock->available() > 0){
+            _sock->receive_from(asio::buffer(buff, sizeof(buff)), _host);
+            _host_known = true;
+        }
+    }
+
+    size_t start_cmd(boost::uint32_t *frame){
+        _cmd = _cmds.front();
+        _cmds.pop_front();
+        if (_cmd.stop) return 0;
+
+        const boost::uint64_t now = _time.get_ticks_now();
+        if (_cmd.now) _next_ticks = now;
+        else if (_cmd.ticks < now){
+            return pack_context(frame, this->get_sid(), _packet_count++, now, rx_metadata_t::ERROR_CODE_LATE_COMMAND, 0);
+        }
+        else _next_ticks = _cmd.ticks;
+
+        _nsamps_left = _cmd.num_samps;
+        _streaming = true;
+        return 0;
+    }
+
+    size_t pack_data(boost::uint32_t *frame, boost::uint64_t &end_ticks){
+        const bool sc8 = (_regs.peek32(_ctrl_base + RX_CTRL_FORMAT) & (1 << 18)) != 0;
+        const size_t bytes_per_item = (sc8)? 2 : 4;
+        const size_t decim = decim_interp_rate(_regs.peek32(_dsp_base + DSP_DECIM_INTERP));
+        const size_t max_nsamps = (insane_mtu - 6*sizeof(boost::uint32_t))/bytes_per_item;
+        const size_t spp = std::min<size_t>(std::max<boost::uint32_t>(_regs.peek32(_ctrl_base + RX_CTRL_NSAMPS_PP), 1), max_nsamps);
+        const size_t nsamps = (_cmd.reload)? spp : std::min(spp, _nsamps_left);
+        end_ticks = _next_ticks + nsamps*decim;
+
+        //the device fell behind by more than its buffering: overflow
+        //the streaming stops until the host issues a new command
+        const boost::uint64_t now = _time.get_ticks_now();
+        if (_throttle and now > end_ticks + TICK_RATE/10){
+            _streaming = false;
+            end_ticks = 0;
+            return pack_context(frame, this->get_sid(), _packet_count++, _next_ticks, rx_metadata_t::ERROR_CODE_OVERFLOW, 0);
+        }
+
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.packet_type = vrt::if_packet_info_t::PACKET_TYPE_DATA;
+        if_packet_info.num_payload_bytes = nsamps*bytes_per_item;
+        if_packet_info.num_payload_words32 = (if_packet_info.num_payload_bytes + 3)/sizeof(boost::uint32_t);
+        if_packet_info.packet_count = _packet_count++;
+        if_packet_info.sob = false;
+        if_packet_info.eob = false;
+        if_packet_info.has_sid = true;
+        if_packet_info.sid = this->get_sid();
+        if_packet_info.has_cid = false;
+        if_packet_info.has_tsi = true;
+        if_packet_info.tsi = boost::uint32_t(_next_ticks/TICK_RATE);
+        if_packet_info.has_tsf = true;
+        if_packet_info.tsf = _next_ticks%TICK_RATE;
+        if_packet_info.has_tlr = true;
+        if_packet_info.tlr = 0;
+
+        //copy the tone, continuing the phase of the last packet
+        //(sc8 keeps the sample pairs of an item, so the offset is even)
+        size_t tone_offset = (_next_ticks/decim)%TONE_PERIOD;
+        if (sc8) tone_offset &= ~size_t(1);
+        const char *tone = (sc8)? &_tone_sc8[tone_offset*2] : &_tone_sc16[tone_offset*4];
+        _next_ticks = end_ticks;
+
+        //a finished command chains into the next one or ends the burst
+        if (not _cmd.reload and (_nsamps_left -= nsamps) == 0){
+            _streaming = false;
+            if (not _cmd.chain){
+                if_packet_info.eob = true;
+            }
+            else if (not _cmds.empty()){
+                _cmd = _cmds.front();
+                _cmds.pop_front();
+                _nsamps_left = _cmd.num_samps;
+                _streaming = not _cmd.stop;
+            }
+        }
+
+        vrt::if_hdr_pack_be(frame, if_packet_info);
+        std::memcpy(frame + if_packet_info.num_header_words32, tone, if_packet_info.num_payload_bytes);
+        frame[if_packet_info.num_packet_words32 - 1] = 0; //trailer
+        return if_packet_info.num_packet_words32*sizeof(boost::uint32_t);
+    }
+
+    boost::uint32_t get_sid(void){
+        return _regs.peek32(_ctrl_base + RX_CTRL_VRT_SID);
+    }
+
+    emu_regs &_regs;
+    emu_time_core &_time;
+    socket_type _sock;
+    const boost::uint32_t _dsp_base, _ctrl_base;
+    const bool _throttle;
+    asio::ip::udp::endpoint _host;
+    bool _host_known;
+    std::vector<char> _tone_sc16, _tone_sc8;
+
+    boost::mutex _mutex;
+    boost::condition_variable _cond;
+    std::deque<rx_cmd_t> _cmds;
+    rx_cmd_t _cmd;
+    bool _streaming;
+    size_t _nsamps_left, _packet_count;
+    boost::uint64_t _next_ticks;
+};
+
+/***********************************************************************
+ * TX DSP: plays out packets and sends flow control and async reports
+ **********************************************************************/
+class emu_tx_dsp{
+public:
+    typedef boost::shared_ptr<emu_tx_dsp> sptr;
+
+    emu_tx_dsp(
+        emu_regs &regs, emu_time_core &time, socket_type sock,
+        const boost::uint32_t dsp_base, const boost::uint32_t ctrl_base, const bool throttle
+    ):
+        _regs(regs), _time(time), _sock(sock),
+        _dsp_base(dsp_base), _ctrl_base(ctrl_base), _throttle(throttle),
+        _host_known(false), _report_count(0)
+    {
+        this->clear();
+    }
+
+    void clear(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        _queue.clear();
+        _reports.clear();
+        _seq_known = false;
+        _count_known = false;
+        _in_burst = false;
+        _dropping = false;
+        _unacked = 0;
+        _play_ticks = 0;
+        _last_ack_ticks = 0;
+    }
+
+    void run(void){
+        uhd::set_thread_priority_safe();
+        std::vector<boost::uint32_t> frame(insane_mtu/sizeof(boost::uint32_t));
+        while (not boost::this_thread::interruption_requested()){
+            if (wait_for_recv_ready(_sock->native(), this->get_wait_timeout())){
+                const size_t len = _sock->receive_from(
+                    asio::buffer(&frame.front(), frame.size()*sizeof(boost::uint32_t)), _host
+                );
+                _host_known = true;
+                this->handle_packet(&frame.front(), len);
+            }
+            this->update(&frame.front());
+        }
+    }
+
+private:
+    struct queued_packet{
+        boost::uint32_t seq;
+        boost::uint64_t end_ticks;
+        bool eob;
+    };
+
+    double get_wait_timeout(void){
+        boost::mutex::scoped_lock lock(_mutex);
+        if (not _throttle or _queue.empty()) return 0.01;
+        const boost::int64_t wait_ticks = boost::int64_t(_queue.front().end_ticks - _time.get_ticks_now());
+        return std::min(double(wait_ticks)/TICK_RATE, 0.01);
+    }
+
+    void push_report(const boost::uint32_t code, const boost::uint64_t ticks){
+        _reports.push_back(std::make_pair(code, ticks));
+    }
+
+    void handle_packet(const boost::uint32_t *frame, const size_t len){
+        //the flow control sequence precedes the vrt header
+        if (len < 2*sizeof(boost::uint32_t)) return;
+        if (frame[1] == uhd::htonx(boost::uint32_t(USRP2_INVALID_VRT_HEADER))) return;
+        vrt::if_packet_info_t if_packet_info;
+        if_packet_info.num_packet_words32 = len/sizeof(boost::uint32_t) - 1;
+        try{
+            vrt::if_hdr_unpack_be(frame + 1, if_packet_info);
+        }
+        catch(const std::exception &){
+            return;
+        }
+        //like the fpga, ignore the packet type: the host does not set it
+
+        boost::mutex::scoped_lock lock(_mutex);
+        const boost::uint64_t now = _time.get_ticks_now();
+
+        //sequence errors show up in the 4-bit vrt packet count
+        if (_count_known and if_packet_info.packet_count != ((_last_count + 1) & 0xf)){
+            this->push_report((_in_burst)?
+                async_metadata_t::EVENT_CODE_SEQ_ERROR_IN_BURST :
+                async_metadata_t::EVENT_CODE_SEQ_ERROR, now
+            );
+        }
+        _last_count = if_packet_info.packet_count;
+        _count_known = true;
+
+        //schedule the playout: late bursts are dropped, gaps are underflows
+        if (not _in_burst){
+            _play_ticks = std::max(_play_ticks, now);
+            if (if_packet_info.has_tsi and if_packet_info.has_tsf){
+                const boost::uint64_t start = boost::uint64_t(if_packet_info.tsi)*TICK_RATE + if_packet_info.tsf;
+                if (_throttle and start < now){
+                    this->push_report(async_metadata_t::EVENT_CODE_TIME_ERROR, start);
+                    _dropping = true;
+                }
+                else _play_ticks = start;
+            }
+        }
+        else if (_throttle and not _dropping and _play_ticks < now){
+            this->push_report(async_metadata_t::EVENT_CODE_UNDERFLOW, _play_ticks);
+            _play_ticks = now;
+        }
+        _in_burst = not if_packet_info.eob;
+
+        queued_packet packet;
+        packet.seq = uhd::ntohx(frame[0]);
+        packet.eob = if_packet_info.eob and not _dropping;
+        if (_dropping) packet.end_ticks = now;
+        else{
+            const size_t interp = decim_interp_rate(_regs.peek32(_dsp_base + DSP_DECIM_INTERP));
+            _play_ticks += if_packet_info.num_payload_words32*interp;
+            packet.end_ticks = (_throttle)? _play_ticks : now;
+        }
+        _queue.push_back(packet);
+
+        //the policy drops until the next packet or the next burst
+        const bool next_packet = (_regs.peek32(_ctrl_base + TX_CTRL_POLICY) & TX_CTRL_POLICY_NEXT_PACKET) != 0;
+        if (next_packet or if_packet_info.eob) _dropping = false;
+    }
+
+    void update(boost::uint32_t *frame){
+        boost::mutex::scoped_lock lock(_mutex);
+        const boost::uint64_t now = _time.get_ticks_now();
+
+        //consume the played packets
+        while (not _queue.empty() and _queue.front().end_ticks <= now){
+            _last_seq = _queue.front().seq;
+            _seq_known = true;
+            _unacked++;
+            if (_queue.front().eob) this->push_report(async_metadata_t::EVENT_CODE_BURST_ACK, _queue.front().end_ticks);
+            _queue.pop_front();
+        }
+        if (not _host_known) return;
+        const boost::uint32_t sid = _regs.peek32(_ctrl_base + TX_CTRL_REPORT_SID);
+
+        //send the async reports
+        while (not _reports.empty()){
+            const size_t len = pack_context(frame, sid, _report_count++, _reports.front().second, _reports.front().first, 0);
+            _reports.pop_front();
+            _sock->send_to(asio::buffer(frame, len), _host);
+        }
+
+        //flow control updates every N packets and every N cycles
+        const boost::uint32_t packets_per_up = _regs.peek32(_ctrl_base + TX_CTRL_PACKETS_PER_UP);
+        const boost::uint32_t cycles_per_up = _regs.peek32(_ctrl_base + TX_CTRL_CYCLES_PER_UP);
+        const bool packets_up = (packets_per_up & TX_CTRL_UP_ENB) != 0 and
+            _unacked >= (packets_per_up & ~TX_CTRL_UP_ENB);
+        const bool cycles_up = (cycles_per_up & TX_CTRL_UP_ENB) != 0 and
+            now - _last_ack_ticks >= (cycles_per_up & ~TX_CTRL_UP_ENB);
+        if (_seq_known and (packets_up or cycles_up)){
+            const size_t len = pack_context(frame, sid, _report_count++, now, 0, _last_seq);
+            _sock->send_to(asio::buffer(frame, len), _host);
+            _unacked = 0;
+            _last_ack_ticks = now;
+        }
+    }
+
+    emu_regs &_regs;
+    emu_time_core &_time;
+    socket_type _sock;
+    const boost::uint32_t _dsp_base, _ctrl_base;
+    const bool _throttle;
+    asio::ip::udp::endpoint _host;
+    bool _host_known;
+    size_t _report_count;
+
+    boost::mutex _mutex;
+    std::deque<queued_packet> _queue;
+    std::deque<std::pair<boost::uint32_t, boost::uint64_t> > _reports;
+    bool _seq_known, _count_known, _in_burst, _dropping;
+    boost::uint32_t _last_seq;
+    size_t _last_count, _unacked;
+    boost::uint64_t _play_ticks, _last_ack_ticks;
+};
+
+/***********************************************************************
+ * The emulated device: answers the firmware control protocol
+ **********************************************************************/
+class emu_device{
+public:
+    emu_device(
+        const std::string &bind, const std::string &serial, const bool throttle,
+        const size_t recv_buff_size, const size_t send_buff_size
+    ):
+        _ip_addr(asio::ip::address_v4::from_string(bind)),
+        _timed_cmds(USRP2_TIMED_CMD_QUEUE_DEPTH)
+    {
+        _ctrl_sock = make_socket(_io_service, bind, USRP2_UDP_CTRL_PORT);
+        _rx_dsps.push_back(emu_rx_dsp::sptr(new emu_rx_dsp(
+            _regs, _time, make_socket(_io_service, bind, USRP2_UDP_RX_DSP0_PORT, recv_buff_size, send_buff_size),
+            U2_REG_SR_ADDR(SR_RX_DSP0), U2_REG_SR_ADDR(SR_RX_CTRL0), throttle
+        )));
+        _rx_dsps.push_back(emu_rx_dsp::sptr(new emu_rx_dsp(
+            _regs, _time, make_socket(_io_service, bind, USRP2_UDP_RX_DSP1_PORT, recv_buff_size, send_buff_size),
+            U2_REG_SR_ADDR(SR_RX_DSP1), U2_REG_SR_ADDR(SR_RX_CTRL1), throttle
+        )));
+        //the tx socket buffer stands in for the SRAM, so it holds a full window of packets
+        _tx_dsp = emu_tx_dsp::sptr(new emu_tx_dsp(
+            _regs, _time, make_socket(_io_service, bind, USRP2_UDP_TX_DSP0_PORT, std::max(recv_buff_size, EMU_SRAM_BYTES), send_buff_size),
+            U2_REG_SR_ADDR(SR_TX_DSP), U2_REG_SR_ADDR(SR_TX_CTRL), throttle
+        ));
+
+        //firmware registers: unlocked, with the current minor version
+        _fw_regs.resize(8, 0);
+        _fw_regs[U2_FW_REG_LOCK_TIME] = 0xfffffff0;
+        _fw_regs[U2_FW_REG_VER_MINOR] = USRP2_FW_VER_MINOR;
+
+        //the motherboard eeprom of an N210, all other eeproms are blank
+        std::vector<boost::uint8_t> &mb_eeprom = this->get_i2c_mem(USRP2_I2C_ADDR_MBOARD);
+        mb_eeprom[0x00] = boost::uint8_t(EMU_HW_REV >> 0);
+        mb_eeprom[0x01] = boost::uint8_t(EMU_HW_REV >> 8);
+        std::copy(EMU_MAC_ADDR, EMU_MAC_ADDR + sizeof(EMU_MAC_ADDR), mb_eeprom.begin() + 0x02);
+        const asio::ip::address_v4::bytes_type ip_bytes = _ip_addr.to_bytes();
+        std::copy(ip_bytes.begin(), ip_bytes.end(), mb_eeprom.begin() + 0x0C);
+        mb_eeprom[0x17] = 0; //no gpsdo
+        std::copy(serial.begin(), serial.end(), mb_eeprom.begin() + EMU_SERIAL_OFFSET);
+        mb_eeprom[EMU_SERIAL_OFFSET + serial.size()] = '\0';
+
+        _thread_group.create_thread(boost::bind(&emu_rx_dsp::run, _rx_dsps[0]));
+        _thread_group.create_thread(boost::bind(&emu_rx_dsp::run, _rx_dsps[1]));
+        _thread_group.create_thread(boost::bind(&emu_tx_dsp::run, _tx_dsp));
+    }
+
+    ~emu_device(void){
+        _thread_group.interrupt_all();
+        _thread_group.join_all();
+    }
+
+    //! Handle one control packet, return false on timeout
+    bool handle_ctrl(const double timeout){
+        //run the timed writes that are due, and wake up for the next one
+        _timed_cmds.run(this->get_time_now(), boost::bind(&emu_device::run_timed_cmd, this, _1));
+        const double wait = std::min(timeout, _timed_cmds.get_wait(this->get_time_now()).get_real_secs());
+        if (not wait_for_recv_ready(_ctrl_sock->native(), (_timed_cmds.empty())? timeout : wait)) return false;
+        asio::ip::udp::endpoint endpoint;
+        std::vector<boost::uint8_t> buff(insane_mtu);
+        const size_t len = _ctrl_sock->receive_from(asio::buffer(buff), endpoint);
+        if (len < offsetof(usrp2_ctrl_data_t, data)) return true;
+
+        const usrp2_ctrl_data_t *in = reinterpret_cast<const usrp2_ctrl_data_t *>(&buff.front());
+        usrp2_ctrl_data_t out = usrp2_ctrl_data_t();
+        out.proto_ver = uhd::htonx<boost::uint32_t>(USRP2_FW_COMPAT_NUM);
+        out.seq = in->seq;
+
+        switch(uhd::ntohx(in->id)){
+        case USRP2_CTRL_ID_WAZZUP_BRO:
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_WAZZUP_DUDE);
+            out.data.ip_addr = uhd::htonx<boost::uint32_t>(_ip_addr.to_ulong());
+            break;
+
+        case USRP2_CTRL_ID_HOLLER_AT_ME_BRO:{
+            //echo the received length in a packet of the requested length
+            const size_t echo_len = std::min<size_t>(uhd::ntohx(in->data.echo_args.len), buff.size());
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_HOLLER_BACK_DUDE);
+            out.data.echo_args.len = uhd::htonx<boost::uint32_t>(len);
+            std::fill(buff.begin(), buff.end(), 0);
+            std::memcpy(&buff.front(), &out, sizeof(out));
+            _ctrl_sock->send_to(asio::buffer(&buff.front(), std::max(echo_len, sizeof(out))), endpoint);
+        } return true;
+
+        case USRP2_CTRL_ID_TRANSACT_ME_SOME_SPI_BRO:
+            //the spi slaves are write-only here, readback is always zero
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_OMG_TRANSACTED_SPI_DUDE);
+            out.data.spi_args.data = 0;
+            break;
+
+        case USRP2_CTRL_ID_DO_AN_I2C_READ_FOR_ME_BRO:{
+            i2c_mem_t &mem = this->get_i2c_mem(in->data.i2c_args.addr);
+            const size_t num_bytes = std::min<size_t>(in->data.i2c_args.bytes, sizeof(out.data.i2c_args.data));
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_HERES_THE_I2C_DATA_DUDE);
+            out.data.i2c_args.addr = in->data.i2c_args.addr;
+            out.data.i2c_args.bytes = num_bytes;
+            boost::uint8_t &ptr = _i2c_ptrs[in->data.i2c_args.addr];
+            for (size_t i = 0; i < num_bytes; i++) out.data.i2c_args.data[i] = mem[ptr++];
+        } break;
+
+        case USRP2_CTRL_ID_WRITE_THESE_I2C_VALUES_BRO:{
+            //the first byte sets the address pointer, the rest are written
+            i2c_mem_t &mem = this->get_i2c_mem(in->data.i2c_args.addr);
+            const size_t num_bytes = std::min<size_t>(in->data.i2c_args.bytes, sizeof(in->data.i2c_args.data));
+            boost::uint8_t &ptr = _i2c_ptrs[in->data.i2c_args.addr];
+            for (size_t i = 0; i < num_bytes; i++){
+                if (i == 0) ptr = in->data.i2c_args.data[0];
+                else mem[ptr++] = in->data.i2c_args.data[i];
+            }
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_COOL_IM_DONE_I2C_WRITE_DUDE);
+        } break;
+
+        case USRP2_CTRL_ID_GET_THIS_REGISTER_FOR_ME_BRO:
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_OMG_GOT_REGISTER_SO_BAD_DUDE);
+            out.data.reg_args = in->data.reg_args;
+            out.data.reg_args.data = uhd::htonx(this->handle_reg(
+                uhd::ntohx(in->data.reg_args.addr), uhd::ntohx(in->data.reg_args.data), in->data.reg_args.action
+            ));
+            break;
+
+        case USRP2_CTRL_ID_DO_THIS_AT_TIME_BRO:{
+            //queue in host byte order, the fpga writes and spi writes run later
+            timed_cmd_t cmd;
+            cmd.action = in->data.timed_args.action;
+            cmd.addr = uhd::ntohx(in->data.timed_args.addr);
+            cmd.data = uhd::ntohx(in->data.timed_args.data);
+            const time_spec_t time(
+                time_t(uhd::ntohx(in->data.timed_args.secs)),
+                long(uhd::ntohx(in->data.timed_args.ticks)), double(TICK_RATE)
+            );
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_WILL_DO_AT_TIME_DUDE);
+            out.data.timed_args = in->data.timed_args;
+            out.data.timed_args.queued = _timed_cmds.push(time, cmd)? 1 : 0;
+        } break;
+
+        default:
+            out.id = uhd::htonx<boost::uint32_t>(USRP2_CTRL_ID_HUH_WHAT);
+        }
+
+        _ctrl_sock->send_to(asio::buffer(&out, sizeof(out)), endpoint);
+        return true;
+    }
+
+private:
+    struct timed_cmd_t{
+        boost::uint8_t action;
+        boost::uint32_t addr, data;
+    };
+
+    time_spec_t get_time_now(void){
+        const boost::uint64_t ticks = _time.get_ticks_now();
+        return time_spec_t(time_t(ticks/TICK_RATE), long(ticks%TICK_RATE), double(TICK_RATE));
+    }
+
+    void run_timed_cmd(const timed_cmd_t &cmd){
+        //the spi slaves are write-only here
+        if (cmd.action == USRP2_REG_ACTION_FPGA_POKE32 or cmd.action == USRP2_REG_ACTION_FPGA_POKE16){
+            this->poke32(cmd.addr, cmd.data);
+        }
+    }
+
+    typedef std::vector<boost::uint8_t> i2c_mem_t;
+
+    i2c_mem_t &get_i2c_mem(const boost::uint8_t addr){
+        if (_i2c_mems.count(addr) == 0) _i2c_mems[addr] = i2c_mem_t(256, 0xff);
+        return _i2c_mems[addr];
+    }
+
+    boost::uint32_t handle_reg(const boost::uint32_t addr, const boost::uint32_t data, const boost::uint8_t action){
+        switch(action){
+        case USRP2_REG_ACTION_FPGA_PEEK32:
+        case USRP2_REG_ACTION_FPGA_PEEK16:
+            return this->peek32(addr);
+
+        case USRP2_REG_ACTION_FPGA_POKE32:
+        case USRP2_REG_ACTION_FPGA_POKE16:
+            this->poke32(addr, data);
+            return data;
+
+        case USRP2_REG_ACTION_FW_PEEK32:
+            return (addr < _fw_regs.size())? _fw_regs[addr] : 0;
+
+        case USRP2_REG_ACTION_FW_POKE32:
+            if (addr < _fw_regs.size()) _fw_regs[addr] = data;
+            return data;
+        }
+        return 0;
+    }
+
+    boost::uint32_t peek32(const boost::uint32_t addr){
+        switch(addr){
+        case U2_REG_COMPAT_NUM_RB: return boost::uint32_t(USRP2_FPGA_COMPAT_NUM) << 16;
+        case U2_REG_TIME64_SECS_RB_IMM: return boost::uint32_t(_time.get_ticks_now()/TICK_RATE);
+        case U2_REG_TIME64_TICKS_RB_IMM: return boost::uint32_t(_time.get_ticks_now()%TICK_RATE);
+        case U2_REG_TIME64_SECS_RB_PPS: return boost::uint32_t(_time.get_ticks_last_pps()/TICK_RATE);
+        case U2_REG_TIME64_TICKS_RB_PPS: return boost::uint32_t(_time.get_ticks_last_pps()%TICK_RATE);
+        case U2_REG_IRQ_RB: return (1 << 11); //ref locked
+        }
+        return _regs.peek32(addr);
+    }
+
+    void poke32(const boost::uint32_t addr, const boost::uint32_t data){
+        _regs.poke32(addr, data);
+
+        //the seconds register latches the time
+        const boost::uint32_t time64_base = U2_REG_SR_ADDR(SR_TIME64);
+        if (addr == time64_base + TIME64_SECS) _time.set_ticks(
+            boost::uint64_t(data)*TICK_RATE + _regs.peek32(time64_base + TIME64_TICKS),
+            _regs.peek32(time64_base + TIME64_IMM) != 0
+        );
+
+        //the ticks register latches the stream command
+        static const boost::uint32_t rx_ctrl_bases[] = {U2_REG_SR_ADDR(SR_RX_CTRL0), U2_REG_SR_ADDR(SR_RX_CTRL1)};
+        for (size_t i = 0; i < _rx_dsps.size(); i++){
+            if (addr == rx_ctrl_bases[i] + RX_CTRL_TIME_TICKS) _rx_dsps[i]->issue_stream_cmd(
+                _regs.peek32(rx_ctrl_bases[i] + RX_CTRL_STREAM_CMD),
+                _regs.peek32(rx_ctrl_bases[i] + RX_CTRL_TIME_SECS), data
+            );
+            if (addr == rx_ctrl_bases[i] + RX_CTRL_CLEAR) _rx_dsps[i]->clear();
+        }
+
+        if (addr == U2_REG_SR_ADDR(SR_TX_CTRL) + TX_CTRL_CLEAR_STATE) _tx_dsp->clear();
+    }
+
+    asio::io_service _io_service;
+    const asio::ip::address_v4 _ip_addr;
+    socket_type _ctrl_sock;
+    emu_regs _regs;
+    emu_time_core _time;
+    std::vector<boost::uint32_t> _fw_regs;
+    std::map<boost::uint8_t, i2c_mem_t> _i2c_mems;
+    std::map<boost::uint8_t, boost::uint8_t> _i2c_ptrs;
+    timed_cmd_queue<timed_cmd_t> _timed_cmds;
+    std::vector<emu_rx_dsp::sptr> _rx_dsps;
+    emu_tx_dsp::sptr _tx_dsp;
+    boost::thread_group _thread_group;
+};
+
+/***********************************************************************
+ * Main
+ **********************************************************************/
+int UHD_SAFE_MAIN(int argc, char *argv[]){
+    uhd::set_thread_priority_safe();
+
+    //variables to be set by po
+    std::string bind, serial;
+    size_t recv_buff_size, send_buff_size;
+    bool throttle;
+
+    //setup the program options
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "help message")
+        ("bind", po::value<std::string>(&bind)->default_value("127.0.0.1"), "bind the emulated device to this network address")
+        ("serial", po::value<std::string>(&serial)->default_value("emu0"), "the serial number in the emulated eeprom (up to 8 characters)")
+        ("throttle", po::value<bool>(&throttle)->default_value(true), "stream at the programmed sample rate (0 for as fast as possible)")
+        ("recv-buff-size", po::value<size_t>(&recv_buff_size)->default_value(0), "the data sockets receive buffer size in bytes (0 for the system default)")
+        ("send-buff-size", po::value<size_t>(&send_buff_size)->default_value(0), "the data sockets send buffer size in bytes (0 for the system default)")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    //print the help message
+    if (vm.count("help") or serial.size() > 8){
+        std::cout
+            << boost::format("UHD USRP2/N-Series Emulator %s") % desc << std::endl
+            << "Answers the USRP2/N-Series firmware control protocol and streams\n"
+            << "VRT data on the data ports, so the host can use --args=\"addr=<bind>\".\n"
+            << std::endl;
+        return ~0;
+    }
+
+    emu_device device(bind, serial, throttle, recv_buff_size, send_buff_size);
+    std::cout << boost::format("Emulating a USRP-N210 on %s, press Ctrl + C to stop...") % bind << std::endl;
+
+    std::signal(SIGINT, &sig_int_handler);
+    while (not stop_signal_called) device.handle_ctrl(0.1);
+
+    //finished
+    std::cout << std::endl << "Done!" << std::endl << std::endl;
+    return 0;
+}